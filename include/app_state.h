@@ -0,0 +1,50 @@
+#pragma once
+#include <stdint.h>
+
+// ================= APP STATES =================
+// The states of the cube's conversation and the events that move it on.
+// main.cpp holds the transition table (what every state does on YES, NO and
+// its timeout) and the screens; test/test_transitions drives it from here.
+
+enum AppState {
+  STATE_INTRO_DOLPHIN,   // Dolphin "HI!" screen
+  STATE_INTRO_1,         // "I am a dumb cube"
+  STATE_VALENTINE_CHECK, // "Is valentines next week?"
+  STATE_GOODNIGHT,       // "oops! goodnight" before sleep
+  STATE_INTRO_REMEMBER,  // "remember"
+  STATE_INTRO_GREEN,     // "GREEN means yes" with Connected icon
+  STATE_INTRO_RED,       // "RED means no" with Error icon
+  STATE_INTRO_2,         // "i have only one purpose"
+  STATE_INTRO_3,         // "that is to ask you"
+  STATE_INTRO_4,         // "do you think im cute???"
+  STATE_CUTE_RESPONSE,   // "knew it" or "wrong answer"
+  STATE_INTRO_5,         // "now for the actual question"
+  STATE_INTRO_6,         // "my owner wants to ask you"
+  STATE_IDLE,            // "Will you be my Valentine?"
+  STATE_NO_RESPONSE,     // Showing NO response message
+  STATE_SWAP_MODE,       // Trick mode
+  STATE_TRICK_REVEAL,    // "You pressed YES!" with the buttons frozen swapped
+  STATE_FAIR_RIGHT,      // "Fair right?" (Yes/No available)
+  STATE_FINAL_PLEA,      // Control mode (Force Win)
+  STATE_CELEBRATION,     // "She said YES!"
+  STATE_FINAL_ANIMATION, // Final animation with hearts and BLE pairing
+  STATE_JOB_DONE,        // "with that my job here is done"
+  STATE_LEAVE_QUESTION,  // "Should i fuck off now?"
+  STATE_DEFIANT_RESPONSE, // "you cant control me i have rights"
+  STATE_SHUTDOWN,        // "Goodnight..." fade, then deep sleep
+  STATE_COUNT,
+
+  // Transition table markers, not real states
+  STATE_NONE = STATE_COUNT, // event ignored
+  STATE_UNSET               // entry missing from the table
+};
+
+// Transition table columns
+enum AppEvent : uint8_t { EVT_YES, EVT_NO, EVT_TIMEOUT, EVT_COUNT };
+#define EVT_INACTIVITY EVT_COUNT // trace only: the inactivity shutdown, see onInactivity()
+
+extern AppState currentState;
+
+// Runs the state's transition for ev: its action draws the screen, then the
+// state it returns is entered (and its timeout armed)
+void dispatchEvent(AppEvent ev, unsigned long now);
@@ -0,0 +1,28 @@
+#pragma once
+#include <Arduino.h>
+#include "cycles.h"
+
+// ================= MICROBENCHMARKS =================
+// Build with -DBENCH (envs bench and native_bench, and their *_300
+// variants). 'B' over Serial runs the suite defined in main.cpp and prints
+// one JSON document; tools/bench.py runs it in the simulator or on the board
+// and compares it with the stored baseline in bench/.
+//
+// Each case gets BENCH_WARMUP untimed runs, then BENCH_RUNS timed ones, each
+// after an untimed prepare() that puts the state back. Reported are min,
+// median and mean in cycle-counter ticks (see cycles.h).
+
+#define BENCH_WARMUP 5
+#define BENCH_RUNS   101
+
+struct BenchCase {
+  const char* name;
+  void (*prepare)(uint32_t arg); // untimed, before every run; may be nullptr
+  void (*run)(uint32_t arg);
+  uint32_t arg; // lets one pair of functions serve several cases
+};
+
+// Keeps results of pure computations alive
+extern volatile uint32_t benchSink;
+
+void benchRun(Print& out, const BenchCase* cases, uint8_t count);
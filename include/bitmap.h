@@ -0,0 +1,30 @@
+#pragma once
+#include <U8g2lib.h>
+#include "bitmaps.h" // generated: BitmapId, one BMP_* per assets/*.xbm
+
+// ================= PACKED BITMAPS =================
+// The screen art lives in assets/*.xbm and is packed at build time by
+// tools/gen_bitmaps.py (row delta + run-length coded pixels, see there).
+// bitmapDraw() decodes it straight into the u8g2 buffer with a one-row
+// scratch and sets exactly the pixels drawXBMP() would, honouring the draw
+// colour and bitmap mode (transparent or not).
+
+struct PackedBitmap {
+  const char* name;
+  uint8_t w;
+  uint8_t h;
+  uint16_t rawSize; // bytes the plain XBM took
+  uint16_t size;
+  const uint8_t* data;
+};
+
+struct BitmapStats {
+  uint32_t draws;
+  uint32_t lastUs;
+  uint32_t maxUs;
+};
+
+void bitmapDraw(U8G2& display, int x, int y, BitmapId id);
+const PackedBitmap& bitmapInfo(BitmapId id);
+const BitmapStats& bitmapStats(BitmapId id);
+void bitmapPrintStats(Print& out); // CSV: per asset sizes and decode times
@@ -0,0 +1,107 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+
+// ================= BUTTON EVENTS =================
+// GPIO edge interrupts push raw, timestamped edges into a lock-free
+// single-producer/single-consumer ring. loop() drains it through one debounce
+// filter per button and hands presses to the state machine in edge order, so
+// bounce on one button never delays the other and no press is dropped.
+
+enum ButtonId : uint8_t { BUTTON_YES = 0, BUTTON_NO = 1, BUTTON_COUNT = 2 };
+
+struct ButtonEdge {
+  uint32_t us;     // micros() in the interrupt
+  uint8_t button;
+  uint8_t level;   // pin level after the edge (LOW = pressed)
+};
+
+struct ButtonPress {
+  uint32_t us;     // time of the accepted edge
+  ButtonId button;
+};
+
+// push() only from the ISR, pop() only from loop(). Only atomic loads/stores
+// are used, which the ESP32-C3 (no RISC-V "A" extension) does natively.
+template <typename T, uint16_t N>
+class SpscRing {
+  static_assert((N & (N - 1)) == 0, "ring size must be a power of two");
+
+public:
+  bool push(const T& item) {
+    uint16_t h = head.load(std::memory_order_relaxed);
+    if ((uint16_t)(h - tail.load(std::memory_order_acquire)) >= N) {
+      dropped = dropped + 1;
+      return false;
+    }
+    items[h & (N - 1)] = item;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(T& item) {
+    uint16_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) return false;
+    item = items[t & (N - 1)];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  uint16_t size() const {
+    return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+  }
+
+  uint32_t droppedCount() const { return dropped; }
+
+private:
+  std::atomic<uint16_t> head{0};
+  std::atomic<uint16_t> tail{0};
+  T items[N];
+  volatile uint32_t dropped = 0;
+};
+
+// Leading-edge debounce: the first edge that flips the stable level counts
+// immediately, then the button is locked out for the debounce window. Feeding
+// the live pin level once the window closes re-syncs the filter, so a release
+// (or press) that ended inside the window is still seen.
+struct DebounceFilter {
+  uint32_t lockoutUs = 50000;
+  uint32_t lockedUntil = 0;
+  bool locked = false;
+  uint8_t stable = HIGH;
+
+  // true when this level change is an accepted press
+  bool update(uint8_t level, uint32_t us) {
+    if (locked && (int32_t)(us - lockedUntil) < 0) return false;
+    locked = false;
+    if (level == stable) return false;
+    stable = level;
+    locked = true;
+    lockedUntil = us + lockoutUs;
+    return level == LOW;
+  }
+};
+
+// Edge-to-delivery latency, bucket k counts [2^k, 2^(k+1)) us
+#define LATENCY_BUCKETS 16
+
+struct LatencyHistogram {
+  uint32_t counts[LATENCY_BUCKETS];
+  uint32_t samples;
+  uint32_t maxUs;
+
+  void add(uint32_t us) {
+    uint8_t k = 0;
+    while (k < LATENCY_BUCKETS - 1 && (us >> (k + 1))) k++;
+    counts[k]++;
+    samples++;
+    if (us > maxUs) maxUs = us;
+  }
+};
+
+void buttonsBegin(uint8_t yesPin, uint8_t noPin, uint16_t debounceMs);
+bool buttonsPoll(ButtonPress& press); // next debounced press, oldest first
+bool buttonHeld(ButtonId button);     // debounced level
+const LatencyHistogram& buttonsLatency();
+uint32_t buttonsDroppedEdges();
+void buttonsPrintLatency(Print& out); // CSV: bucket_lo_us,count
@@ -0,0 +1,52 @@
+#pragma once
+#include <stdint.h>
+
+// ================= PACKED COLOUR MATH =================
+// Colours stay packed the way Adafruit_NeoPixel::Color() returns them,
+// 0x00RRGGBB, and each operation handles all channels at once (SIMD within
+// a register): the even and the odd bytes of a word go into two words with
+// a spare byte above every lane, so one 32-bit multiply or add works on two
+// channels and its carries can't spill into the next one. The kernels don't
+// care which byte is which channel, so the *Buffer versions run over raw
+// strip buffers (getPixels(), GRB order) four bytes at a time.
+//
+// Amounts are 0..256: colorScale(c, 256) == c, colorLerp(a, b, 256) == b.
+
+#define SWAR_EVEN 0x00FF00FFUL
+
+inline uint32_t colorRgb(uint8_t r, uint8_t g, uint8_t b) {
+  return (uint32_t)r << 16 | (uint32_t)g << 8 | b;
+}
+
+inline uint8_t colorRed(uint32_t c)   { return c >> 16; }
+inline uint8_t colorGreen(uint32_t c) { return c >> 8; }
+inline uint8_t colorBlue(uint32_t c)  { return c; }
+
+// Every byte * s / 256 (a fade toward black)
+inline uint32_t colorScale(uint32_t c, uint16_t s) {
+  uint32_t even = ((c & SWAR_EVEN) * s >> 8) & SWAR_EVEN;
+  uint32_t odd = (((c >> 8) & SWAR_EVEN) * s) & ~SWAR_EVEN;
+  return even | odd;
+}
+
+// Every byte from a toward b by t / 256
+inline uint32_t colorLerp(uint32_t a, uint32_t b, uint16_t t) {
+  uint16_t u = 256 - t;
+  uint32_t even = (((a & SWAR_EVEN) * u + (b & SWAR_EVEN) * t) >> 8) & SWAR_EVEN;
+  uint32_t odd = (((a >> 8) & SWAR_EVEN) * u + ((b >> 8) & SWAR_EVEN) * t) & ~SWAR_EVEN;
+  return even | odd;
+}
+
+// Every byte a + b, stopping at 255
+inline uint32_t colorAddSat(uint32_t a, uint32_t b) {
+  uint32_t even = (a & SWAR_EVEN) + (b & SWAR_EVEN);
+  uint32_t odd = ((a >> 8) & SWAR_EVEN) + ((b >> 8) & SWAR_EVEN);
+  // A lane that carried into its spare byte becomes 0xFF
+  even |= ((even >> 8) & 0x00010001UL) * 0xFF;
+  odd |= ((odd >> 8) & 0x00010001UL) * 0xFF;
+  return (even & SWAR_EVEN) | ((odd & SWAR_EVEN) << 8);
+}
+
+// ---- whole buffers ----
+void colorScaleBuffer(uint8_t* px, uint16_t bytes, uint16_t s);
+void colorLerpBuffer(uint8_t* px, const uint8_t* to, uint16_t bytes, uint16_t t);
@@ -0,0 +1,21 @@
+#pragma once
+#include <Arduino.h>
+
+// ================= CYCLE COUNTER =================
+// Cheap timestamps for the profiler and the benchmarks. On the C3 this is the
+// machine performance counter at the CPU clock (it has no standard mcycle
+// CSR), on the host steady_clock nanoseconds. Differences of two readings are
+// valid up to 2^32 ticks, ~26 s at 160 MHz.
+
+#ifdef ESP_PLATFORM
+#include "hal/cpu_hal.h"
+static inline uint32_t cyclesNow() { return cpu_hal_get_cycle_count(); }
+#define CYCLES_PER_US (F_CPU / 1000000)
+#else
+#include <chrono>
+static inline uint32_t cyclesNow() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#define CYCLES_PER_US 1000
+#endif
@@ -0,0 +1,73 @@
+#pragma once
+#include <U8g2lib.h>
+
+// ================= DISPLAY PIPELINE =================
+// Every screen still draws into the normal u8g2 frame buffer, but instead of
+// sendBuffer() it calls displayFlush(). The flush copies the finished frame
+// into a triple buffer and returns; a FreeRTOS display task picks up the
+// newest frame, compares it with a shadow copy of what the panel already
+// shows and pushes only the 8x8 tiles that changed, one I2C area update per
+// run of dirty tiles in a row. loop() keeps running during the ~25 ms full
+// transfer, and frames that get replaced before the task reaches them are
+// dropped instead of queued.
+//
+// Anything else that talks to the panel must call displaySync() first.
+//
+// displayBegin() replaces u8g2.begin(): the task runs the panel's init
+// sequence itself, so setup() doesn't wait on I2C, and the panel stays in
+// power save until the first frame is on it (no flash of old display RAM).
+
+// Screens that come back pixel for pixel (the idle heart blinking, the two
+// final plea screens, finished captions) can keep their whole frame. Such a
+// screen asks displayShowCached(key) first; on a hit the stored frame goes to
+// the display task and nothing is drawn (the u8g2 buffer keeps whatever it
+// held), on a miss it draws as usual and ends with displayFlushCached(key)
+// instead of displayFlush(). A key is the address of the screen's main
+// message plus a variant and must fully determine the frame; screens made of
+// several messages (a typed caption) key on all of them with a DisplayKey,
+// since equal literals may share an address. The least recently used frame
+// makes room when DISPLAY_CACHE_BYTES is full.
+#ifndef DISPLAY_CACHE_BYTES
+#define DISPLAY_CACHE_BYTES 4096 // 1 KB per frame
+#endif
+
+// SSD1306 I2C bytes per area update besides the pixel data:
+// address + control + 3 cmd bytes (column hi/lo, page), address + data control.
+#define DISPLAY_AREA_OVERHEAD 7
+
+struct DisplayStats {
+  uint32_t frames;         // displayFlush() calls
+  uint32_t framesDropped;  // replaced before the display task took them
+  uint32_t framesSkipped;  // sent frames where nothing changed
+  uint32_t tilesSent;      // total 8x8 tiles pushed
+  uint32_t bytesSent;      // estimated I2C bytes incl. addressing overhead
+  uint32_t bytesFull;      // what full sendBuffer() calls would have cost
+  uint32_t transferUs;     // display task time spent on I2C
+  uint32_t blockedUs;      // loop() time spent in displayFlush()/displaySync()
+  uint16_t lastFrameTiles;
+  uint16_t lastFrameBytes;
+  uint32_t lastTransferUs;
+  uint32_t paintSeq;       // `frames` count at the flush of the last frame that changed a tile
+  uint32_t paintUs;        // micros() when that frame's first changed tile was sent
+  uint32_t cacheHits;
+  uint32_t cacheMisses;
+  uint32_t cacheSavedUs;   // drawing time the hits didn't spend, as measured on their misses
+};
+
+struct DisplayKey {
+  const void* msg[3]; // unused ones nullptr
+  uint8_t variant;
+};
+
+void displayBegin(U8G2& display); // after Wire.begin(); starts the display task
+void displayFlush();
+void displaySync();       // wait until the panel shows the last flushed frame
+bool displayBusy();       // a frame still queued or on the bus
+void displayInvalidate(); // next frame resends every tile
+bool displayShowCached(const void* key, uint8_t variant = 0);  // true: on its way, skip drawing
+void displayFlushCached(const void* key, uint8_t variant = 0); // displayFlush() and keep the frame
+bool displayShowCached(const DisplayKey& key);
+void displayFlushCached(const DisplayKey& key);
+const DisplayStats& displayStats();
+void displayResetStats();
+void displayPrintStats(Print& out); // CSV: name,value
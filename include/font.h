@@ -0,0 +1,32 @@
+#pragma once
+#include <U8g2lib.h>
+#include "fonts.h" // generated: FONT_* subsets, and #defines from the u8g2 names to them
+
+// ================= SUBSET FONTS =================
+// Every u8g2 font the firmware uses is rebuilt at build time by
+// tools/gen_fonts.py with only the glyphs some rendered string needs (a
+// string with a glyph the font lacks fails the build). The data stays in
+// u8g2's format, so setFont(u8g2_font_...) and all of u8g2 work unchanged;
+// fonts.h just points those names at the subsets.
+//
+// u8g2 finds a glyph by walking the glyph list from the start, 'A' or 'a'.
+// The subsets also carry a direct index by character code, and
+// fontDrawGlyph() decodes from there, setting exactly the pixels
+// drawGlyph() would (draw colour, solid or transparent font mode).
+
+struct SubsetFont {
+  const char* name;        // the u8g2 font it was cut from
+  const uint8_t* data;     // u8g2 font format
+  uint16_t fullSize;       // bytes the complete font takes
+  uint16_t size;           // bytes of the subset, index included
+  uint8_t first;           // index[c - first] is glyph c's offset in data,
+  uint8_t count;           // 0 where the subset has no such glyph
+  const uint16_t* index;
+};
+
+const SubsetFont* fontFind(const uint8_t* data); // nullptr unless it's a subset
+
+// Same as drawGlyph() with that font set; falls back to it for rotated text
+u8g2_uint_t fontDrawGlyph(U8G2& display, const SubsetFont& font, u8g2_uint_t x, u8g2_uint_t y, uint8_t c);
+
+void fontPrintStats(Print& out); // CSV: per font sizes
@@ -0,0 +1,41 @@
+#pragma once
+#include <Arduino.h>
+
+// ================= IDLE LIGHT SLEEP =================
+// A loop() pass takes a few ms of its 10 ms, the rest used to be delay(),
+// which keeps the CPU and its clocks running. idleWait() light-sleeps
+// through that gap instead: a timer wakeup just before the next pass (the
+// next LED frame, or the next timer from timer_wheel.h if that's sooner)
+// plus a GPIO wakeup on either button, so a press doesn't wait for the
+// timer. Any part of the gap left after waking is spun out, so passes start
+// when they did before.
+//
+// Waits stay in delay() while anything would notice the chip stopping:
+// a frame on the I2C bus or in an RMT channel, or a USB host on Serial
+// (the USB Serial/JTAG link doesn't survive light sleep). So does a wait
+// too short to be worth the trip.
+//
+// Time is booked per state: loop() work, waiting, and how much of the
+// waiting was spent asleep. 'i' over Serial prints it; active_pct is the
+// duty cycle the CPU needs in that state whether or not it got to sleep.
+
+#define IDLE_STATES         32
+#define IDLE_SLEEP_MIN_US   2000 // shorter waits stay in delay()
+#define IDLE_WAKE_MARGIN_US 500  // timer wakeup this much before the deadline, for the way back
+
+struct IdleStats {
+  uint64_t activeUs;  // in loop() passes
+  uint64_t waitUs;    // between them, asleep or not
+  uint64_t sleptUs;   // of waitUs, in light sleep
+  uint32_t sleeps;
+  uint32_t awake;     // waits long enough to sleep, spent in delay()
+  uint32_t lateMaxUs; // worst wakeup after the deadline
+};
+
+void idleBegin(uint8_t yesPin, uint8_t noPin);
+// Waits ms (from now) before the next pass, asleep unless busy or any of
+// the above. A button wakes it early. state is the one the pass ran in.
+void idleWait(uint32_t ms, uint8_t state, bool busy);
+void idleStop(); // before deep sleep, which must not take the light sleep timer along
+const IdleStats& idleStats(uint8_t state);
+void idlePrintStats(Print& out, const char* const* stateNames, uint8_t stateCount); // CSV
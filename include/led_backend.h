@@ -0,0 +1,122 @@
+#pragma once
+#include <Adafruit_NeoPixel.h>
+
+// ================= LED BACKENDS =================
+// Adafruit_NeoPixel stays the pixel buffer (setPixelColor, brightness), a
+// backend only clocks the finished GRB bytes out. On the ESP32-C3 the RMT
+// peripheral does that from its own memory while the CPU carries on, each
+// strip on its own TX channel, so the two strips go out in parallel and
+// interrupts are never disabled. The encoder is plain C++ so the capture
+// backend can run it on the host and check every symbol against the WS2812
+// timing spec.
+
+// ---- WS2812 symbols ----
+// Same layout as rmt_item32_t: {duration0:15, level0:1, duration1:15, level1:1}
+struct LedSymbol {
+  uint32_t val;
+
+  static constexpr LedSymbol make(uint16_t high, uint16_t low) {
+    return { (uint32_t)high | (1u << 15) | ((uint32_t)low << 16) };
+  }
+  uint16_t duration0() const { return val & 0x7FFF; }
+  uint8_t level0() const { return (val >> 15) & 1; }
+  uint16_t duration1() const { return (val >> 16) & 0x7FFF; }
+  uint8_t level1() const { return val >> 31; }
+};
+
+#define LED_RMT_CLK_DIV 2  // 80 MHz APB / 2 = 25 ns ticks
+#define LED_TICK_NS     25
+#define LED_RESET_US    300 // WS2812B latch gap (older parts only need 50)
+
+// Nominal WS2812B bit timing (datasheet +-150 ns)
+constexpr uint16_t LED_T0H = 400 / LED_TICK_NS;
+constexpr uint16_t LED_T0L = 850 / LED_TICK_NS;
+constexpr uint16_t LED_T1H = 800 / LED_TICK_NS;
+constexpr uint16_t LED_T1L = 450 / LED_TICK_NS;
+constexpr uint16_t LED_TOLERANCE_NS = 150;
+
+// Whole bytes of src (MSB first) into at most maxSymbols symbols, 8 per byte.
+// Returns symbols written, *consumed = bytes used. Same contract as an RMT
+// sample_to_rmt translator, which is what it runs as on the target.
+size_t ledEncode(const uint8_t* src, size_t srcBytes, LedSymbol* dst, size_t maxSymbols, size_t* consumed);
+
+// Back to bytes; counts symbols outside the WS2812 timing window
+struct LedDecodeResult {
+  size_t bytes;
+  uint32_t timingErrors;
+};
+LedDecodeResult ledDecode(const LedSymbol* symbols, size_t count, uint8_t* out, size_t maxBytes);
+
+// ---- backends ----
+class LedBackend {
+public:
+  virtual ~LedBackend() {}
+  virtual void begin(uint16_t maxBytes) = 0;
+  virtual void send(const uint8_t* grb, uint16_t bytes) = 0; // data may change right after
+  virtual bool busy() = 0;
+};
+
+// Adafruit's own show(), i.e. the bit-banged path
+class NeoPixelShowBackend : public LedBackend {
+public:
+  explicit NeoPixelShowBackend(Adafruit_NeoPixel& strip) : strip(strip) {}
+  void begin(uint16_t) override {}
+  void send(const uint8_t*, uint16_t) override { strip.show(); }
+  bool busy() override { return false; }
+
+private:
+  Adafruit_NeoPixel& strip;
+};
+
+#ifdef ESP_PLATFORM
+// Background transfer on one RMT TX channel (the C3 has two)
+class RmtLedBackend : public LedBackend {
+public:
+  RmtLedBackend(uint8_t pin, uint8_t channel) : pin(pin), channel(channel) {}
+  void begin(uint16_t maxBytes) override;
+  void send(const uint8_t* grb, uint16_t bytes) override;
+  bool busy() override;
+
+private:
+  uint8_t pin;
+  uint8_t channel;
+  uint8_t* tx = nullptr;  // copy the driver reads from while sending
+  uint16_t capacity = 0;
+  uint32_t idleAtUs = 0;  // earliest start of the next frame (latch gap)
+};
+#endif
+
+// Encodes like the RMT path (in translator-sized chunks), decodes it again and
+// checks timing and content. For host builds and self-tests; storage is the
+// caller's.
+#define CAPTURE_CHUNK 24 // symbols per translator call, half an RMT memory block
+
+struct LedCaptureStats {
+  uint32_t frames;
+  uint32_t symbols;
+  uint32_t timingErrors;
+  uint32_t mismatches; // frames that did not decode back to the input
+  uint32_t gapErrors;  // frames started inside the latch gap
+};
+
+class CaptureLedBackend : public LedBackend {
+public:
+  CaptureLedBackend(LedSymbol* symbols, uint8_t* decoded, size_t maxBytes, size_t chunk = CAPTURE_CHUNK)
+    : symbols(symbols), decoded(decoded), maxBytes(maxBytes), chunk(chunk) {}
+  void begin(uint16_t) override {}
+  void send(const uint8_t* grb, uint16_t bytes) override;
+  bool busy() override { return false; }
+
+  const LedCaptureStats& stats() const { return captured; }
+  const uint8_t* lastFrame() const { return decoded; }
+  size_t lastFrameBytes() const { return lastBytes; }
+
+private:
+  LedSymbol* symbols; // maxBytes * 8
+  uint8_t* decoded;   // maxBytes
+  size_t maxBytes;
+  size_t chunk;       // symbols per ledEncode() call
+  size_t lastBytes = 0;
+  uint32_t lastEndUs = 0;
+  LedCaptureStats captured = {};
+};
@@ -0,0 +1,88 @@
+#pragma once
+#include <Adafruit_NeoPixel.h>
+
+// ================= LED KEYFRAME CLIPS =================
+// LED sequences as data instead of loops. A Clip is a list of Tracks; each
+// Track drives one colour channel (or the brightness) of a run of pixels on
+// one strip through a list of keys, reaching every key from the one before
+// along an easing curve. Times are ms, values are ints clamped to 0..255 on
+// output (so a curve may dip below zero and read as off), and evaluation is
+// integer only: a per-track cursor follows the current key pair from tick to
+// tick instead of searching the list.
+//
+// A ClipPlayer lays its clip over the frame updateLEDs() already computed:
+//  - pixels with a colour track are the clip's; their channels without one
+//    go dark. Brightness tracks call setBrightness() on the whole strip.
+//  - a one-shot clip runs from play(). Past lengthMs it either holds its last
+//    frame or cross-fades into the live frame over blendOutMs and stops.
+//  - in a CLIP_LOOP clip every track repeats over its own last key's time,
+//    on millis() itself, so its phase doesn't depend on when it started.
+// A clip reaches as many pixels of a strip as the player was given for it
+// (the layout's active ones); begin() sizes its frame buffer from those.
+
+#define CLIP_MAX_TRACKS 12
+#define CLIP_MAX_STRIPS 2
+
+enum Ease : uint8_t {
+  EASE_STEP,   // hold the previous value, jump at the key
+  EASE_LINEAR,
+  EASE_SINE,   // (1 - cos(pi x)) / 2: exactly half a sine wave, trough to crest
+  EASE_IN,     // x^2
+  EASE_OUT,    // 1 - (1 - x)^2
+};
+
+struct Key {
+  uint16_t ms;
+  int16_t value;
+  Ease ease; // how the previous key's value gets to this one
+};
+
+enum Channel : uint8_t { CH_RED, CH_GREEN, CH_BLUE, CH_BRIGHTNESS };
+
+struct Track {
+  uint8_t strip;     // index into the player's strips
+  Channel channel;
+  uint16_t first;    // first pixel
+  uint16_t count;    // pixels driven (brightness tracks ignore both)
+  int16_t phaseMs;   // added to the clip time
+  int16_t staggerMs; // pixel first + k runs k * staggerMs behind
+  const Key* keys;   // ascending ms; the channel is 0 before the first one
+  uint8_t keyCount;
+};
+
+#define CLIP_LOOP 0x01
+
+struct Clip {
+  const Track* tracks;
+  uint8_t trackCount;
+  uint16_t lengthMs;   // where a one-shot ends
+  uint16_t blendOutMs; // one-shot only; 0 holds the last frame
+  uint8_t flags;
+};
+
+#define CLIP_KEYS(keys) keys, (uint8_t)(sizeof(keys) / sizeof(keys[0]))
+#define CLIP_TRACKS(tracks) tracks, (uint8_t)(sizeof(tracks) / sizeof(tracks[0]))
+
+class ClipPlayer {
+public:
+  ClipPlayer(Adafruit_NeoPixel* const* strips, const uint16_t* pixels, uint8_t stripCount); // pixels: per strip
+  ~ClipPlayer() { delete[] frame; }
+
+  void begin(); // allocates the frame buffer, once; apply() does nothing before
+  void play(const Clip* clip, unsigned long now); // nullptr stops; same clip again keeps running
+  const Clip* current() const { return clip; }
+  bool done(unsigned long now) const; // one-shot past its end (holding or not); loops never are
+  void apply(unsigned long now);      // after the live frame is in the strips
+
+private:
+  int16_t sample(const Track& track, int32_t t, uint8_t& cursor) const;
+
+  Adafruit_NeoPixel* const* strips;
+  uint8_t stripCount;
+  uint16_t pixels[CLIP_MAX_STRIPS] = {};
+  uint32_t* frame = nullptr;           // every strip's pixels in a row, packed (see color.h)
+  uint32_t* rgb[CLIP_MAX_STRIPS] = {}; // each strip's part of it
+  const Clip* clip = nullptr;
+  unsigned long startMs = 0;
+  uint8_t cursors[CLIP_MAX_TRACKS];
+};
@@ -0,0 +1,42 @@
+#pragma once
+#include <stdint.h>
+
+// ================= STRIP LAYOUT =================
+// A strip's shape, fixed at compile time: how many pixels the chain has,
+// and which of them are lit, as segments of consecutive pixels. Along a
+// segment an effect runs spacingMs later on each pixel than on the one
+// before, starting startMs behind the effect's own clock.
+//
+//   using Body = StripLayout<300, Segment<100, 40>, Segment<100, 40, 20>, Segment<100, 40>>;
+//
+// forEach() hands every lit pixel and its time offset to an effect. Counts,
+// offsets and spacing are all template arguments, so each segment's loop is
+// compiled for its own constants and nothing is looked up per pixel.
+
+template <uint16_t Count, uint16_t SpacingMs = 0, uint16_t StartMs = 0>
+struct Segment {
+  static constexpr uint16_t count = Count;
+  static constexpr uint16_t spacingMs = SpacingMs;
+  static constexpr uint16_t startMs = StartMs;
+};
+
+template <uint16_t Physical, typename... Segments>
+struct StripLayout {
+  static constexpr uint16_t physical = Physical;                 // pixels on the chain
+  static constexpr uint16_t active = (Segments::count + ... + 0); // lit ones, from pixel 0 on
+  static constexpr uint8_t segments = sizeof...(Segments);
+  static_assert(active <= physical, "segments longer than the strip");
+
+  // fn(pixel, offsetMs) for every lit pixel, in strip order
+  template <typename Fn>
+  static inline void forEach(Fn&& fn) {
+    if constexpr (segments > 0) each<0, Segments...>(fn);
+  }
+
+private:
+  template <uint16_t First, typename S, typename... Rest, typename Fn>
+  static inline void each(Fn& fn) {
+    for (uint16_t k = 0; k < S::count; k++) fn((uint16_t)(First + k), (uint32_t)S::startMs + (uint32_t)k * S::spacingMs);
+    if constexpr (sizeof...(Rest) > 0) each<First + S::count, Rest...>(fn);
+  }
+};
@@ -0,0 +1,109 @@
+#pragma once
+#include <stdint.h>
+
+// ================= FIXED-POINT LED KERNELS =================
+// The ESP32-C3 has no FPU, so the sin()/exp() based effects in updateLEDs()
+// ran in soft-float for every pixel on every pass. These kernels produce the
+// same 8-bit channel values (within +-1) from lookup tables that are built at
+// compile time, using only integer math at runtime.
+//
+// Phases are 32-bit: 2^32 == one full turn, so multiplying a millis() value by
+// a per-ms phase step wraps around for free.
+
+// ---- compile-time table generation (never runs on the device) ----
+constexpr double LUT_PI = 3.14159265358979323846;
+
+constexpr double lutSin(double x) {
+  while (x > LUT_PI) x -= 2 * LUT_PI;
+  while (x < -LUT_PI) x += 2 * LUT_PI;
+  double term = x, sum = x;
+  for (int n = 1; n < 12; n++) {
+    term *= -x * x / ((2 * n) * (2 * n + 1));
+    sum += term;
+  }
+  return sum;
+}
+
+constexpr double lutExp(double x) {
+  double term = 1, sum = 1;
+  for (int n = 1; n < 30; n++) {
+    term *= x / n;
+    sum += term;
+  }
+  return sum;
+}
+
+template <typename T, int N>
+struct Lut {
+  T v[N];
+};
+
+// 256 steps per turn, plus a guard entry so interpolation never wraps
+constexpr Lut<int16_t, 257> makeSinLut() {
+  Lut<int16_t, 257> t{};
+  for (int i = 0; i <= 256; i++) {
+    double s = lutSin(2 * LUT_PI * i / 256) * 32767.0;
+    t.v[i] = (int16_t)(s >= 0 ? s + 0.5 : s - 0.5);
+  }
+  return t;
+}
+
+// Candlelight curve (exp(sin(x)) - 1/e) * 108, stored in Q8
+constexpr Lut<uint16_t, 257> makeBreatheLut() {
+  Lut<uint16_t, 257> t{};
+  for (int i = 0; i <= 256; i++) {
+    double b = (lutExp(lutSin(2 * LUT_PI * i / 256)) - 0.36787944) * 108.0;
+    t.v[i] = (uint16_t)(b * 256.0 + 0.5);
+  }
+  return t;
+}
+
+constexpr uint32_t phaseStep(double periodMs) {
+  return (uint32_t)(4294967296.0 / periodMs + 0.5);
+}
+
+inline constexpr Lut<int16_t, 257> SIN_LUT = makeSinLut();
+inline constexpr Lut<uint16_t, 257> BREATHE_LUT = makeBreatheLut();
+
+// Per-ms phase steps for the original sin() arguments
+constexpr uint32_t PHASE_BREATHE = phaseStep(5000.0);            // sin(t / 2500 * PI)
+constexpr uint32_t PHASE_WAVE    = phaseStep(1600.0);            // sin(t / 800 * PI)
+constexpr uint32_t PHASE_SOFT    = phaseStep(2 * LUT_PI * 800);  // sin(t / 800)
+constexpr uint32_t PHASE_PANIC   = phaseStep(2 * LUT_PI * 150);  // sin(t / 150)
+constexpr uint32_t PHASE_WIN     = phaseStep(2 * LUT_PI * 300);  // sin(t / 300)
+constexpr uint32_t PHASE_HALF_RAD = (uint32_t)(0.5 / (2 * LUT_PI) * 4294967296.0 + 0.5);
+
+// ---- runtime kernels ----
+inline int32_t sinQ15(uint32_t phase) {
+  uint32_t idx = phase >> 24;
+  int32_t frac = (phase >> 8) & 0xFFFF;
+  int32_t a = SIN_LUT.v[idx];
+  int32_t b = SIN_LUT.v[idx + 1];
+  return a + (((b - a) * frac) >> 16);
+}
+
+// (int)(sin * amp), truncating toward zero like the float cast did
+inline int32_t sinScaled(uint32_t phase, int32_t amp) {
+  int32_t p = sinQ15(phase) * amp;
+  return p >= 0 ? (p >> 15) : -((-p) >> 15);
+}
+
+// map((exp(sin(t / 2500 * PI)) - 0.36787944) * 108, 0, 255, 20, 100)
+inline uint8_t ledBreathe(uint32_t t) {
+  uint32_t phase = t * PHASE_BREATHE;
+  uint32_t idx = phase >> 24;
+  int32_t frac = (phase >> 16) & 0xFF;
+  int32_t a = BREATHE_LUT.v[idx];
+  int32_t b = BREATHE_LUT.v[idx + 1];
+  int32_t breathe = (a + (((b - a) * frac) >> 8)) >> 8;
+  return 20 + breathe * 80 / 255;
+}
+
+// 0.5 + 0.5 * sin(t / 800 * PI + i * 0.5) in Q16
+inline uint32_t ledWave(uint32_t t, uint8_t i) {
+  return 32768 + sinQ15(t * PHASE_WAVE + i * PHASE_HALF_RAD);
+}
+
+inline int ledSoftPulse(uint32_t t)  { return 80 + sinScaled(t * PHASE_SOFT, 60); }
+inline int ledPanicPulse(uint32_t t) { return 100 + sinScaled(t * PHASE_PANIC, 100); }
+inline int ledWinPulse(uint32_t t)   { return 100 + sinScaled(t * PHASE_WIN, 155); }
@@ -0,0 +1,64 @@
+#pragma once
+#include <Adafruit_NeoPixel.h>
+#include "led_backend.h"
+#include "profiler.h"
+
+// ================= LED OUTPUT STAGE =================
+// updateLEDs() and the scenes only set pixels; loop() calls update() once per
+// pass and that decides whether the strip actually needs a show(). Each
+// send goes through a LedBackend (RMT in the background, or Adafruit's
+// blocking show()); frames identical to the last one sent are skipped,
+// changes are capped at a refresh target, and pixels past the active ones are
+// blanked once in begin() and then never streamed again. limit() scales what
+// goes out (the current budget, see led_power.h) without touching the
+// strip's own pixels.
+
+struct LedOutputStats {
+  uint32_t shows;     // frames that went out
+  uint32_t showUs;    // CPU time spent handing them to the backend
+  uint32_t unchanged; // passes skipped, same bytes as the last frame sent
+  uint32_t deferred;  // changed, but inside the refresh interval
+};
+
+class LedOutput {
+public:
+  LedOutput(Adafruit_NeoPixel& strip, LedBackend& backend, uint16_t activeCount, uint16_t refreshHz, uint8_t bytesPerPixel = 3);
+
+  void begin();                    // blank the whole strip (active pixels only after the first), then stream only those
+  bool update(unsigned long now);  // true if a frame went out
+  void showNow();                  // bypass the refresh target (still skipped if unchanged)
+  void limit(uint16_t scale) { limitScale = scale; } // 0..256 on every byte sent, 256 = off
+  uint32_t channelSum() const;     // all bytes of the active pixels as they are now
+  uint16_t physicalPixels() const { return physicalCount; }
+  bool busy() const { return backend.busy(); } // a frame still going out
+
+  const LedOutputStats& lastSecond() const { return done; }
+  const LedOutputStats& total() const { return all; }
+  void printStats(Print& out, const char* name) const; // CSV row, per second
+#ifdef PROFILER
+  void profileAs(uint8_t id) { profileId = id; } // histogram for the sends
+#endif
+
+private:
+  void send(unsigned long now);
+  void roll(unsigned long now);
+  bool changed() const;
+
+  Adafruit_NeoPixel& strip;
+  LedBackend& backend;
+  uint16_t physicalCount = 0;
+  uint16_t activeCount;
+  uint16_t bytes;
+  uint16_t intervalMs;
+  uint8_t* sent = nullptr;  // bytes of the last frame that went out, before limit()
+  uint16_t limitScale = 256;
+  uint16_t sentScale = 256;
+  unsigned long lastShowMs = 0;
+  unsigned long windowStart = 0;
+  LedOutputStats window = {};
+  LedOutputStats done = {};
+  LedOutputStats all = {};
+#ifdef PROFILER
+  uint8_t profileId = PROF_NONE;
+#endif
+};
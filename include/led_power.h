@@ -0,0 +1,63 @@
+#pragma once
+#include <Arduino.h>
+#include "led_output.h"
+
+// ================= LED CURRENT BUDGET =================
+// Estimates what the strips draw from the bytes they are about to send and
+// keeps the total under a budget: once a frame would go over, every byte of
+// every strip is scaled by the same amount, so colours and the balance
+// between the strips stay as they were, only dimmer. The bytes already carry
+// setBrightness(), so the estimate follows what actually goes out.
+//
+// The model is the usual WS2812 one: each channel draws in proportion to its
+// value, up to LED_CHANNEL_FULL_UA at 255, and every package on the strip
+// (lit or not, streamed or not) idles at LED_IDLE_UA, which no scaling can
+// take away. Good enough to compare states and to size a battery; measure
+// with a meter before trusting it to the last mA.
+//
+// The limited estimate is integrated per state; 'm' over Serial prints
+// charge, average and peak per state since boot.
+
+#define LED_CHANNEL_FULL_UA 20000 // one channel at 255
+#define LED_IDLE_UA         1000  // per package, dark
+#define LED_POWER_STATES    32
+#define LED_POWER_OUTPUTS   2
+
+// Channel draw for a sum of channel bytes
+uint32_t ledFrameUa(uint32_t channelSum);
+// Scale (0..256, 256 = untouched) that keeps dynamic * scale / 256 + idle
+// within the budget. 0 when the idle draw alone is over it.
+uint16_t ledBudgetScale(uint32_t dynamicUa, uint32_t idleUa, uint32_t budgetUa);
+
+struct LedPowerStats {
+  uint64_t uaMs;      // charge, µA x ms
+  uint32_t ms;        // time spent in the state
+  uint32_t peakUa;
+  uint32_t limitedMs; // time with the budget scaling frames down
+};
+
+class LedPowerBudget {
+public:
+  LedPowerBudget(LedOutput* const* outputs, uint8_t count, uint16_t budgetMa);
+
+  // Once per loop pass, after the frame is drawn and before the outputs'
+  // update(): sets their limit() and books the time since the last call to
+  // the state it was spent in
+  void update(unsigned long now, uint8_t state);
+
+  uint32_t currentUa() const { return lastUa; } // after limiting
+  uint16_t currentScale() const { return scale; }
+  const LedPowerStats& stats(uint8_t state) const { return perState[state]; }
+  void printStats(Print& out, const char* const* stateNames, uint8_t stateCount) const; // CSV
+
+private:
+  LedOutput* const* outputs;
+  uint8_t count;
+  uint32_t budgetUa;
+  uint16_t scale = 256;
+  uint32_t lastUa = 0;
+  uint8_t lastState = 0;
+  unsigned long lastMs = 0;
+  bool started = false;
+  LedPowerStats perState[LED_POWER_STATES] = {};
+};
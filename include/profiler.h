@@ -0,0 +1,96 @@
+#pragma once
+#include <Arduino.h>
+#include "cycles.h"
+
+// ================= HOT-PATH PROFILER =================
+// Build with -DPROFILER to time the hot paths in CPU cycles. Each PROFILE_SCOPE
+// reads the cycle counter on entry and exit and adds the difference to that
+// id's log2 histogram; PROFILE_BEGIN/END do the same for a span that ends
+// early, PROFILE_MARK records the time since the previous mark (loop period,
+// i.e. jitter). 'h' over Serial dumps the histograms as CSV and 'H' clears
+// them. Without the flag the macros expand to nothing and none of this is
+// compiled.
+//
+// Each id must only be recorded from one task (the display task owns
+// PROF_SEND_FRAME), so no locking is needed; a dump can see a half-updated row.
+
+enum ProfileId : uint8_t {
+  PROF_LOOP,          // loop() body, without the trailing delay
+  PROF_LOOP_PERIOD,   // loop() start to start
+  PROF_INPUT,         // Serial commands + button polling
+  PROF_UPDATE_LEDS,
+  PROF_TYPEWRITER,
+  PROF_IDLE_DISPLAY,
+  PROF_DISPLAY_FLUSH, // loop side of the display pipeline
+  PROF_SEND_FRAME,    // display task I2C transfer (was u8g2.sendBuffer())
+  PROF_SHOW_BODY,     // LED frame handed to the backend
+  PROF_SHOW_BUTTONS,
+  PROF_COUNT,
+  PROF_NONE = 0xFF
+};
+
+#ifdef PROFILER
+
+// Bucket k counts [2^k, 2^(k+1)) ticks, the last one everything above
+#define PROFILE_BUCKETS 24
+
+struct ProfileHistogram {
+  uint32_t counts[PROFILE_BUCKETS];
+  uint32_t samples;
+  uint32_t minTicks;
+  uint32_t maxTicks;
+  uint64_t totalTicks;
+
+  void add(uint32_t ticks) {
+    uint8_t k = ticks ? 31 - __builtin_clz(ticks) : 0;
+    if (k >= PROFILE_BUCKETS) k = PROFILE_BUCKETS - 1;
+    counts[k]++;
+    if (!samples || ticks < minTicks) minTicks = ticks;
+    if (ticks > maxTicks) maxTicks = ticks;
+    samples++;
+    totalTicks += ticks;
+  }
+};
+
+extern ProfileHistogram profileHist[PROF_COUNT];
+extern uint32_t profileLastMark[PROF_COUNT];
+
+static inline void profileAdd(uint8_t id, uint32_t ticks) {
+  if (id < PROF_COUNT) profileHist[id].add(ticks);
+}
+
+static inline void profileMark(uint8_t id) {
+  uint32_t t = cyclesNow();
+  if (profileLastMark[id]) profileAdd(id, t - profileLastMark[id]);
+  profileLastMark[id] = t ? t : 1;
+}
+
+class ProfileScope {
+public:
+  explicit ProfileScope(uint8_t id) : id(id), start(cyclesNow()) {}
+  ~ProfileScope() { profileAdd(id, cyclesNow() - start); }
+
+private:
+  uint8_t id;
+  uint32_t start;
+};
+
+void profileReset();
+void profilePrint(Print& out); // CSV: name,samples,min,mean,max,b0..b23 (ticks)
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(id) ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(id)
+#define PROFILE_MARK(id) profileMark(id)
+// For spans that end before the enclosing scope does
+#define PROFILE_BEGIN(id) uint32_t PROFILE_CONCAT(profileStart_, id) = cyclesNow()
+#define PROFILE_END(id) profileAdd(id, cyclesNow() - PROFILE_CONCAT(profileStart_, id))
+
+#else
+
+#define PROFILE_SCOPE(id) ((void)0)
+#define PROFILE_MARK(id) ((void)0)
+#define PROFILE_BEGIN(id) ((void)0)
+#define PROFILE_END(id) ((void)0)
+
+#endif
@@ -0,0 +1,34 @@
+#pragma once
+#include <Arduino.h>
+#include "text.h"
+
+// ================= SCENE RUNTIME =================
+// Multi-frame screens (typed captions, boot and shutdown animations) are
+// stackless coroutines: a plain function that loop() re-enters once per pass.
+// The SCENE_* macros switch on the line it last yielded from (protothread
+// style), so a sequence still reads top to bottom but never blocks input or
+// the LED animation. Anything that must survive a yield lives in the Scene
+// struct, not in locals.
+
+struct Scene {
+  uint16_t line;         // resume point, 0 = start
+  unsigned long t0;      // start of the current step
+  unsigned long wakeAt;  // SCENE_DELAY deadline
+  int i;                 // loop counter / current level
+  TextView caption;      // caption being typed
+};
+
+typedef bool (*SceneFn)(Scene& s, unsigned long now); // false once finished
+
+#define SCENE_BEGIN(s) switch ((s).line) { case 0:
+#define SCENE_YIELD(s) do { (s).line = __LINE__; return true; case __LINE__:; } while (0)
+#define SCENE_DELAY(s, now, ms) do { (s).wakeAt = (now) + (ms); (s).line = __LINE__; case __LINE__: \
+                                     if ((long)((now) - (s).wakeAt) < 0) return true; } while (0)
+#define SCENE_WAIT_UNTIL(s, cond) do { (s).line = __LINE__; case __LINE__: if (!(cond)) return true; } while (0)
+#define SCENE_END(s) } (s).line = 0; return false
+
+void sceneStart(SceneFn fn); // replaces whatever scene is running
+void sceneStop();
+bool sceneActive();
+SceneFn sceneCurrent(); // nullptr if none
+void sceneRun(unsigned long now);
@@ -0,0 +1,49 @@
+#pragma once
+#include <U8g2lib.h>
+#include "font.h"
+
+// ================= TEXT VIEWS =================
+// Non-owning slices of the flash-resident MSG_* strings. The typewriter keeps
+// views instead of String copies and renders a prefix by length, so typing a
+// message never touches the heap.
+
+// A whole line pre-rendered at build time, page-major like the u8g2 buffer:
+// byte page * w + column holds 8 rows of that column, LSB on top
+struct TextSprite {
+  int8_t x;            // ink box, from the pen position and the baseline
+  int8_t top;
+  uint8_t w;
+  uint8_t pages;
+  const uint8_t* data; // nullptr if the line has no ink
+};
+
+// One line of a MSG_* string, measured at build time by tools/gen_text_layout.py
+struct TextLayout {
+  const char* const* message; // the MSG_* variable it belongs to
+  uint8_t start;              // line slice within the message
+  uint8_t len;
+  const uint8_t* font;        // widths and sprite are only valid in this font
+  const uint8_t* widths;      // widths[n] == getStrWidth() of the first n chars
+  TextSprite sprite;
+};
+
+struct TextView {
+  const char* str;
+  uint8_t len;
+  const TextLayout* layout; // precomputed widths, nullptr for unknown strings
+
+  bool empty() const { return len == 0; }
+};
+
+TextView textView(const char* s); // nullptr gives an empty view
+
+// Splits at the first '\n' in place; false (views untouched) if there is none
+bool textSplitLine(TextView text, TextView& first, TextView& rest);
+
+// Same result as getStrWidth()/drawStr() on the first n characters. Views of
+// MSG_* lines just index their generated table, anything else is measured.
+// A whole MSG_* line in transparent font mode is copied from its sprite
+// instead of drawn glyph by glyph.
+u8g2_uint_t textWidth(U8G2& display, TextView text, uint8_t n);
+void textDraw(U8G2& display, int x, int y, TextView text, uint8_t n);
+void textDrawStr(U8G2& display, int x, int y, const char* s); // drawStr() through textDraw()
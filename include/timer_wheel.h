@@ -0,0 +1,71 @@
+#pragma once
+#include <stdint.h>
+
+// ================= TIMER WHEEL =================
+// One scheduler for everything loop() waits on (state timeouts, the next
+// typewriter character, the inactivity shutdown) instead of a timestamp per
+// feature compared with millis() on every pass. A Timer lives in its owner,
+// nothing is allocated, and sits in one slot of a hierarchical wheel: 4
+// levels of 64 slots, 1, 64, 4096 and 262144 ms wide. Arming and cancelling
+// are a list insert and unlink. advance() skips over empty stretches and
+// only ever walks the one slot whose time has come; a higher level's slot is
+// handed down to the levels below when the level under it wraps around.
+//
+// Times are millis() values, only ever compared by their difference, so the
+// 49-day wrap of millis() doesn't matter as long as a deadline is less than
+// 2^31 ms away. A deadline that has already passed fires on the next
+// advance(). Callbacks may arm and cancel any timer, their own included.
+
+#define TIMER_LEVELS    4
+#define TIMER_SLOT_BITS 6
+#define TIMER_SLOTS     (1 << TIMER_SLOT_BITS)
+
+struct Timer;
+typedef void (*TimerFn)(Timer& t, uint32_t now);
+
+struct Timer {
+  explicit Timer(TimerFn fn, void* arg = nullptr) : fn(fn), arg(arg) {}
+
+  TimerFn fn;
+  void* arg;
+  uint32_t deadline = 0;
+
+  // Wheel bookkeeping
+  Timer* next = nullptr;
+  Timer** pprev = nullptr; // the pointer that points at us, nullptr while not armed
+  uint8_t level = 0;
+  uint8_t slot = 0;
+};
+
+class TimerWheel {
+public:
+  explicit TimerWheel(uint32_t now = 0) : current(now) {}
+
+  void arm(Timer& t, uint32_t deadline); // re-arming an armed timer moves it
+  void cancel(Timer& t);                 // no-op if not armed
+  static bool armed(const Timer& t) { return t.pprev != nullptr; }
+
+  // Runs the callbacks of everything due up to and including `now`, in
+  // deadline order
+  void advance(uint32_t now);
+
+  // Earliest armed deadline (one already due counts as the wheel's time);
+  // false if nothing is armed
+  bool nextDeadline(uint32_t& at) const;
+
+  uint32_t time() const { return current; }
+  uint16_t count() const { return armedCount; }
+
+private:
+  void place(Timer& t);
+  void link(Timer& t, Timer** head, uint8_t level, uint8_t slot);
+  void unlink(Timer& t);
+  uint32_t quietTicks() const;
+  void tick();
+
+  Timer* slots[TIMER_LEVELS][TIMER_SLOTS] = {};
+  uint64_t occupied[TIMER_LEVELS] = {}; // bit per non-empty slot
+  Timer* due = nullptr;                 // armed with a deadline already reached
+  uint32_t current;
+  uint16_t armedCount = 0;
+};
@@ -0,0 +1,51 @@
+#pragma once
+#include <Arduino.h>
+#include "buttons.h"
+
+// ================= INTERACTION TRACE =================
+// From boot on, every debounced press, every state transition and, for each
+// transition, the moment its first changed tile was on the panel go into a
+// RAM log of 8-byte records. 't' over Serial dumps it as hex (tools/trace.py
+// saves that as a .trc file: TRACE_MAGIC, then the records as they are in
+// memory, little endian), 'T' prints press-to-first-pixel per transition.
+// The log lives in plain RAM, so read it before the cube goes to sleep.
+//
+// The simulator replays a .trc file (-r): the same presses at the same
+// microseconds on its virtual clock, then the same report for the replayed
+// run. Virtual time doesn't move while code runs or I2C is busy, so replayed
+// latencies are what the firmware's own logic adds (loop polling, typewriter
+// and scene timing), comparable between builds rather than with the board.
+
+#define TRACE_CAPACITY 512 // records (4 KB); recording stops when full
+#define TRACE_MAGIC    "VTR1"
+
+enum TraceKind : uint8_t {
+  TRACE_PRESS,      // a = ButtonId
+  TRACE_TRANSITION, // a = from state, b = to state, c = event (| TRACE_BY_PRESS)
+  TRACE_PIXEL,      // first changed tile after the last transition was sent
+};
+
+#define TRACE_BY_PRESS 0x80 // the transition came from the press just before it
+
+struct TraceRecord {
+  uint32_t us; // micros(); the edge time for presses
+  uint8_t kind;
+  uint8_t a;
+  uint8_t b;
+  uint8_t c;
+};
+static_assert(sizeof(TraceRecord) == 8, "trace records are 8 bytes in a .trc file");
+
+void traceButton(const ButtonPress& press);
+// flushesBefore: displayStats().frames before the transition drew anything
+void traceTransition(uint8_t from, uint8_t to, uint8_t event, uint32_t flushesBefore);
+void traceUpdate(); // once per loop() pass, after everything that draws
+
+uint16_t traceCount();
+const TraceRecord* traceRecords();
+void traceDump(Print& out); // "trace,<n>", one record per line as 16 hex digits, "end"
+
+// CSV at_ms,from,to,event,transition_us,pixel_us; times from the press, or
+// from the transition itself for timeouts
+void tracePrintReport(Print& out, const TraceRecord* records, uint16_t count,
+                      const char* const* stateNames, const char* const* eventNames);
@@ -0,0 +1,67 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+
+// ================= TRIPLE BUFFER =================
+// Latest-value handoff between one producer and one consumer. The producer
+// fills back() and publish()es it; the consumer take()s the newest published
+// slot. A frame that is overwritten before the consumer got to it is simply
+// dropped, so the consumer never works through a backlog of stale frames.
+//
+// Three slots mean the producer always has one that is neither the newest
+// published nor the one being read. Like SpscRing only atomic loads/stores
+// are used (no RISC-V "A" extension on the ESP32-C3): the consumer announces
+// the slot it is about to read, then re-checks that it is still the newest,
+// so the producer can never pick it as its next back buffer.
+
+template <typename T>
+class TripleBuffer {
+public:
+  // ---- producer ----
+  T& back() { return slots[backIdx]; }
+
+  // true if the previously published frame was never taken (dropped). A take()
+  // racing this call can still get that frame, so this may over-count slightly.
+  bool publish() {
+    bool dropped = taken.load() != seq;
+    seq = (seq + 1) & SEQ_MASK;
+    published.store((seq << 2) | backIdx);
+
+    uint8_t busy = reading.load();
+    for (uint8_t i = 0; i < 3; i++) {
+      if (i != backIdx && i != busy) { backIdx = i; break; }
+    }
+    return dropped;
+  }
+
+  // ---- consumer ----
+  // Newest unseen frame, valid until the next take(); nullptr if none
+  const T* take() {
+    for (;;) {
+      uint32_t p = published.load();
+      if ((p >> 2) == lastTaken) return nullptr;
+      reading.store(p & 3);
+      if (published.load() != p) continue; // overtaken while claiming, retry
+      lastTaken = p >> 2;
+      taken.store(lastTaken);
+      return &slots[p & 3];
+    }
+  }
+
+  // Published but not yet taken (callable from either side)
+  bool pending() const { return (published.load() >> 2) != taken.load(); }
+
+private:
+  static constexpr uint32_t SEQ_MASK = 0x3FFFFFFF; // what fits above the slot bits
+
+  T slots[3];
+
+  // seq_cst, so each side's store is seen before its following load
+  std::atomic<uint32_t> published{2}; // seq << 2 | slot, seq 0 = nothing yet
+  std::atomic<uint32_t> taken{0};     // seq of the last taken frame
+  std::atomic<uint8_t> reading{2};    // slot the consumer reads from
+
+  uint8_t backIdx = 0;     // producer only
+  uint32_t seq = 0;        // producer only
+  uint32_t lastTaken = 0;  // consumer only
+};
@@ -0,0 +1,52 @@
+#pragma once
+// Host stand-in with the library's pixel buffer semantics (colour order,
+// brightness pre-scaling, updateLength() reallocating); show() goes to the
+// simulator's LED log instead of a pin.
+#include <Arduino.h>
+
+typedef uint16_t neoPixelType;
+
+#define NEO_RGB ((0 << 6) | (0 << 4) | (1 << 2) | (2))
+#define NEO_RBG ((0 << 6) | (0 << 4) | (2 << 2) | (1))
+#define NEO_GRB ((1 << 6) | (1 << 4) | (0 << 2) | (2))
+#define NEO_GBR ((2 << 6) | (2 << 4) | (0 << 2) | (1))
+#define NEO_BRG ((1 << 6) | (1 << 4) | (2 << 2) | (0))
+#define NEO_BGR ((2 << 6) | (2 << 4) | (1 << 2) | (0))
+#define NEO_KHZ800 0x0000
+#define NEO_KHZ400 0x0100
+
+class Adafruit_NeoPixel {
+public:
+  Adafruit_NeoPixel(uint16_t n, int16_t pin = 6, neoPixelType type = NEO_GRB + NEO_KHZ800);
+  ~Adafruit_NeoPixel();
+
+  void begin();
+  void show();
+  bool canShow() const { return true; }
+  void setPin(int16_t p) { pin = p; }
+  void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b);
+  void setPixelColor(uint16_t n, uint32_t c);
+  void fill(uint32_t c = 0, uint16_t first = 0, uint16_t count = 0);
+  void setBrightness(uint8_t b);
+  void clear() { memset(pixels, 0, numBytes); }
+  void updateLength(uint16_t n);
+  void updateType(neoPixelType t);
+
+  uint8_t* getPixels() const { return pixels; }
+  uint8_t getBrightness() const { return brightness - 1; }
+  int16_t getPin() const { return pin; }
+  uint16_t numPixels() const { return numLEDs; }
+  uint32_t getPixelColor(uint16_t n) const;
+
+  static uint32_t Color(uint8_t r, uint8_t g, uint8_t b) {
+    return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+  }
+
+private:
+  uint16_t numLEDs = 0;
+  uint16_t numBytes = 0;
+  int16_t pin;
+  uint8_t brightness = 0; // stored +1, 0 = full (no scaling)
+  uint8_t* pixels = nullptr;
+  uint8_t rOffset, gOffset, bOffset;
+};
@@ -0,0 +1,88 @@
+#pragma once
+// Host stand-in for U8g2's C++ wrapper. Only the class is simulated: every
+// call goes to u8g2's own C core, which tools/sim_env.py builds from the
+// installed library, and the SSD1306 driver's I2C bytes go to the panel model
+// in sim_panel.cpp. Method names and signatures follow U8g2lib.h.
+#include <Arduino.h>
+#include "u8g2.h"
+
+// I2C byte and GPIO/delay callbacks of the simulated panel
+uint8_t simPanelByteCb(u8x8_t* u8x8, uint8_t msg, uint8_t arg_int, void* arg_ptr);
+uint8_t simPanelGpioCb(u8x8_t* u8x8, uint8_t msg, uint8_t arg_int, void* arg_ptr);
+
+class U8G2 {
+protected:
+  u8g2_t u8g2;
+
+public:
+  u8x8_t* getU8x8() { return u8g2_GetU8x8(&u8g2); }
+  u8g2_t* getU8g2() { return &u8g2; }
+
+  // ---- display control ----
+  bool begin() {
+    u8g2_InitDisplay(&u8g2);
+    u8g2_ClearDisplay(&u8g2);
+    u8g2_SetPowerSave(&u8g2, 0);
+    return true;
+  }
+  void initDisplay() { u8g2_InitDisplay(&u8g2); }
+  void setPowerSave(uint8_t isEnable) { u8g2_SetPowerSave(&u8g2, isEnable); }
+  void setContrast(uint8_t value) { u8g2_SetContrast(&u8g2, value); }
+  void clearDisplay() { u8g2_ClearDisplay(&u8g2); }
+
+  // ---- buffer ----
+  void clearBuffer() { u8g2_ClearBuffer(&u8g2); }
+  void sendBuffer() { u8g2_SendBuffer(&u8g2); }
+  void updateDisplay() { u8g2_UpdateDisplay(&u8g2); }
+  void updateDisplayArea(uint8_t tx, uint8_t ty, uint8_t tw, uint8_t th) { u8g2_UpdateDisplayArea(&u8g2, tx, ty, tw, th); }
+  uint8_t* getBufferPtr() { return u8g2_GetBufferPtr(&u8g2); }
+  uint8_t getBufferTileWidth() { return u8g2_GetBufferTileWidth(&u8g2); }
+  uint8_t getBufferTileHeight() { return u8g2_GetBufferTileHeight(&u8g2); }
+  u8g2_uint_t getDisplayWidth() { return u8g2_GetDisplayWidth(&u8g2); }
+  u8g2_uint_t getDisplayHeight() { return u8g2_GetDisplayHeight(&u8g2); }
+
+  // ---- graphics ----
+  void setDrawColor(uint8_t color) { u8g2_SetDrawColor(&u8g2, color); }
+  uint8_t getDrawColor() { return u8g2_GetDrawColor(&u8g2); }
+  void setBitmapMode(uint8_t isTransparent) { u8g2_SetBitmapMode(&u8g2, isTransparent); }
+  void drawPixel(u8g2_uint_t x, u8g2_uint_t y) { u8g2_DrawPixel(&u8g2, x, y); }
+  void drawHLine(u8g2_uint_t x, u8g2_uint_t y, u8g2_uint_t w) { u8g2_DrawHLine(&u8g2, x, y, w); }
+  void drawVLine(u8g2_uint_t x, u8g2_uint_t y, u8g2_uint_t h) { u8g2_DrawVLine(&u8g2, x, y, h); }
+  void drawLine(u8g2_uint_t x1, u8g2_uint_t y1, u8g2_uint_t x2, u8g2_uint_t y2) { u8g2_DrawLine(&u8g2, x1, y1, x2, y2); }
+  void drawBox(u8g2_uint_t x, u8g2_uint_t y, u8g2_uint_t w, u8g2_uint_t h) { u8g2_DrawBox(&u8g2, x, y, w, h); }
+  void drawFrame(u8g2_uint_t x, u8g2_uint_t y, u8g2_uint_t w, u8g2_uint_t h) { u8g2_DrawFrame(&u8g2, x, y, w, h); }
+  void drawRBox(u8g2_uint_t x, u8g2_uint_t y, u8g2_uint_t w, u8g2_uint_t h, u8g2_uint_t r) { u8g2_DrawRBox(&u8g2, x, y, w, h, r); }
+  void drawRFrame(u8g2_uint_t x, u8g2_uint_t y, u8g2_uint_t w, u8g2_uint_t h, u8g2_uint_t r) { u8g2_DrawRFrame(&u8g2, x, y, w, h, r); }
+  void drawCircle(u8g2_uint_t x0, u8g2_uint_t y0, u8g2_uint_t rad, uint8_t opt = U8G2_DRAW_ALL) { u8g2_DrawCircle(&u8g2, x0, y0, rad, opt); }
+  void drawDisc(u8g2_uint_t x0, u8g2_uint_t y0, u8g2_uint_t rad, uint8_t opt = U8G2_DRAW_ALL) { u8g2_DrawDisc(&u8g2, x0, y0, rad, opt); }
+  void drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2) { u8g2_DrawTriangle(&u8g2, x0, y0, x1, y1, x2, y2); }
+  void drawXBM(u8g2_uint_t x, u8g2_uint_t y, u8g2_uint_t w, u8g2_uint_t h, const uint8_t* bitmap) { u8g2_DrawXBM(&u8g2, x, y, w, h, bitmap); }
+  void drawXBMP(u8g2_uint_t x, u8g2_uint_t y, u8g2_uint_t w, u8g2_uint_t h, const uint8_t* bitmap) { u8g2_DrawXBMP(&u8g2, x, y, w, h, bitmap); }
+
+  // ---- text ----
+  void setFont(const uint8_t* font) { u8g2_SetFont(&u8g2, font); }
+  void setFontMode(uint8_t isTransparent) { u8g2_SetFontMode(&u8g2, isTransparent); }
+  void setFontDirection(uint8_t dir) { u8g2_SetFontDirection(&u8g2, dir); }
+  void setFontPosBaseline() { u8g2_SetFontPosBaseline(&u8g2); }
+  void setFontPosBottom() { u8g2_SetFontPosBottom(&u8g2); }
+  void setFontPosTop() { u8g2_SetFontPosTop(&u8g2); }
+  void setFontPosCenter() { u8g2_SetFontPosCenter(&u8g2); }
+  int8_t getAscent() { return u8g2_GetAscent(&u8g2); }
+  int8_t getDescent() { return u8g2_GetDescent(&u8g2); }
+  int8_t getMaxCharHeight() { return u8g2_GetMaxCharHeight(&u8g2); }
+  int8_t getMaxCharWidth() { return u8g2_GetMaxCharWidth(&u8g2); }
+  u8g2_uint_t drawGlyph(u8g2_uint_t x, u8g2_uint_t y, uint16_t encoding) { return u8g2_DrawGlyph(&u8g2, x, y, encoding); }
+  u8g2_uint_t drawStr(u8g2_uint_t x, u8g2_uint_t y, const char* s) { return u8g2_DrawStr(&u8g2, x, y, s); }
+  u8g2_uint_t drawUTF8(u8g2_uint_t x, u8g2_uint_t y, const char* s) { return u8g2_DrawUTF8(&u8g2, x, y, s); }
+  u8g2_uint_t getStrWidth(const char* s) { return u8g2_GetStrWidth(&u8g2, s); }
+  u8g2_uint_t getUTF8Width(const char* s) { return u8g2_GetUTF8Width(&u8g2, s); }
+};
+
+class U8G2_SSD1306_128X64_NONAME_F_HW_I2C : public U8G2 {
+public:
+  U8G2_SSD1306_128X64_NONAME_F_HW_I2C(const u8g2_cb_t* rotation, uint8_t reset = U8X8_PIN_NONE,
+                                      uint8_t clock = U8X8_PIN_NONE, uint8_t data = U8X8_PIN_NONE) {
+    (void)reset; (void)clock; (void)data;
+    u8g2_Setup_ssd1306_i2c_128x64_noname_f(&u8g2, rotation, simPanelByteCb, simPanelGpioCb);
+  }
+};
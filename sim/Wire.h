@@ -0,0 +1,12 @@
+#pragma once
+// Host stand-in: the display talks to the simulated panel directly (see U8g2lib.h)
+#include <Arduino.h>
+
+class TwoWire {
+public:
+  bool begin() { return true; }
+  bool begin(int sda, int scl, uint32_t frequency = 0) { (void)sda; (void)scl; (void)frequency; return true; }
+  bool setClock(uint32_t frequency) { (void)frequency; return true; }
+};
+
+extern TwoWire Wire;
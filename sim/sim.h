@@ -0,0 +1,83 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+
+// ================= HOST SIMULATOR =================
+// env:native builds src/ unchanged against the stand-ins in this directory:
+// Arduino core, Wire, Adafruit_NeoPixel, esp_sleep, driver/gpio (sleep
+// wakeups) and the u8g2 HW I2C display class (drawing itself is u8g2's real
+// C core and fonts, see tools/sim_env.py). Time is virtual: it only moves in
+// delay(), delayMicroseconds(), vTaskDelay() and light sleep, so a 3-minute
+// idle timeout runs in milliseconds and every run with the same script is
+// identical.
+//
+// Run .pio/build/native/program -h for the options. Serial output from the
+// firmware goes to stdout, everything from the simulator to stderr.
+
+// ---- virtual clock ----
+uint64_t simNowUs();
+void simAdvanceUs(uint64_t us); // applies scripted events that fall due on the way
+
+// ---- heap ----
+uint32_t simHeapAllocs(); // allocations so far, operator new and (on glibc) the malloc family
+
+// ---- scripted events ----
+enum SimEventKind : uint8_t {
+  SIM_PIN,    // drive a pin (fires CHANGE interrupts)
+  SIM_SERIAL, // bytes for Serial.read()
+  SIM_SNAP,   // write the panel to a PBM file
+  SIM_END,    // stop after the current loop() pass
+};
+
+struct SimEvent {
+  uint64_t atUs;
+  SimEventKind kind;
+  uint8_t pin;
+  uint8_t level;
+  char text[64]; // serial bytes or PBM path
+};
+
+bool simSchedule(const SimEvent& ev); // false if the queue is full
+bool simEnded();
+
+// ---- pins ----
+void simSetPin(uint8_t pin, uint8_t level);
+
+// ---- serial ----
+void simSerialInput(const char* text);
+
+// ---- OLED panel (SSD1306 model fed by the I2C byte stream) ----
+struct SimPanelStats {
+  uint32_t transfers; // I2C transactions
+  uint32_t bytes;     // I2C bytes incl. address byte
+  uint32_t dataBytes; // bytes written to display RAM
+  uint32_t frames;    // distinct panel images (counted by simPanelChanged)
+};
+
+bool simPanelChanged();                 // panel image changed since the last call
+bool simPanelWritePbm(const char* path); // what the panel shows, lit pixels black
+const uint8_t* simPanelRam();           // display RAM, 8 pages of 128 columns like the u8g2 buffer
+const SimPanelStats& simPanelStats();
+
+// ---- LED strips ----
+void simLedLog(FILE* out);         // CSV of every show(): ms,pin,RRGGBB...
+uint32_t simLedShows(int16_t pin); // show() calls on that pin so far
+
+// ---- deep sleep ----
+typedef void (*SimSleepHandler)();
+void simOnDeepSleep(SimSleepHandler handler); // called instead of sleeping, must not return
+
+// RTC slow memory: RTC_DATA_ATTR puts variables in their own section, so a
+// run can save them at deep sleep and a later run, started as a wake, can
+// put them back before setup() (needs GNU ld for the section bounds)
+bool simRtcSave(const char* path);
+bool simRtcLoad(const char* path); // false if missing or not from this build
+void simWakeFromSleep();           // esp_sleep_get_wakeup_cause() reports a GPIO wake
+
+// ---- light sleep ----
+struct SimLightSleepStats {
+  uint32_t sleeps;
+  uint32_t gpioWakes; // woken by a pin before the timer
+  uint64_t us;
+};
+const SimLightSleepStats& simLightSleepStats();
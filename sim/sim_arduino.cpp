@@ -0,0 +1,394 @@
+#include <stdarg.h>
+#include <stdlib.h>
+#include <new>
+#include "sim.h"
+#include <Arduino.h>
+#include <Wire.h>
+#include "esp_sleep.h"
+#include "driver/gpio.h"
+
+HardwareSerial Serial;
+TwoWire Wire;
+
+// ================= VIRTUAL CLOCK + EVENTS =================
+#define SIM_MAX_EVENTS 2048 // a full trace replay is two per press
+
+static uint64_t nowUs = 0;
+static SimEvent events[SIM_MAX_EVENTS]; // sorted by atUs
+static uint16_t eventCount = 0;
+static uint16_t nextEvent = 0;
+static bool ended = false;
+
+bool simSchedule(const SimEvent& ev) {
+  if (eventCount == SIM_MAX_EVENTS) return false;
+  // Insertion sort, stable so same-time events keep script order
+  uint16_t i = eventCount++;
+  while (i > nextEvent && events[i - 1].atUs > ev.atUs) {
+    events[i] = events[i - 1];
+    i--;
+  }
+  events[i] = ev;
+  return true;
+}
+
+static void apply(const SimEvent& ev) {
+  switch (ev.kind) {
+    case SIM_PIN: simSetPin(ev.pin, ev.level); break;
+    case SIM_SERIAL: simSerialInput(ev.text); break;
+    case SIM_SNAP:
+      if (!simPanelWritePbm(ev.text)) fprintf(stderr, "sim: cannot write %s\n", ev.text);
+      break;
+    case SIM_END: ended = true; break;
+  }
+}
+
+uint64_t simNowUs() {
+  return nowUs;
+}
+
+void simAdvanceUs(uint64_t us) {
+  uint64_t target = nowUs + us;
+  while (nextEvent < eventCount && events[nextEvent].atUs <= target) {
+    const SimEvent& ev = events[nextEvent++];
+    if (ev.atUs > nowUs) nowUs = ev.atUs;
+    apply(ev);
+  }
+  nowUs = target;
+}
+
+bool simEnded() {
+  return ended;
+}
+
+unsigned long millis() { return (unsigned long)(nowUs / 1000); }
+unsigned long micros() { return (unsigned long)nowUs; }
+void delay(uint32_t ms) { simAdvanceUs((uint64_t)ms * 1000); }
+void delayMicroseconds(uint32_t us) { simAdvanceUs(us); }
+void yield() {}
+
+// ================= HEAP =================
+// Counts every allocation, so a run can show it never touched the heap
+// (the board's heap fragments, the sim's doesn't). operator new everywhere;
+// malloc, calloc and realloc too where glibc lets them be wrapped.
+static uint32_t heapAllocs = 0;
+
+#ifdef __GLIBC__
+extern "C" void* __libc_malloc(size_t n);
+extern "C" void* __libc_calloc(size_t n, size_t size);
+extern "C" void* __libc_realloc(void* p, size_t n);
+#define RAW_MALLOC __libc_malloc
+
+extern "C" void* malloc(size_t n) {
+  heapAllocs++;
+  return __libc_malloc(n);
+}
+
+extern "C" void* calloc(size_t n, size_t size) {
+  heapAllocs++;
+  return __libc_calloc(n, size);
+}
+
+extern "C" void* realloc(void* p, size_t n) {
+  heapAllocs++;
+  return __libc_realloc(p, n);
+}
+#else
+#define RAW_MALLOC malloc
+#endif
+
+void* operator new(size_t n) {
+  heapAllocs++;
+  void* p = RAW_MALLOC(n ? n : 1);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+
+void* operator new[](size_t n) {
+  return operator new(n);
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+uint32_t simHeapAllocs() {
+  return heapAllocs;
+}
+
+// ================= GPIO =================
+#define SIM_PINS 32
+
+static uint8_t levels[SIM_PINS];
+static uint8_t modes[SIM_PINS];
+static void (*isrs[SIM_PINS])();
+static int isrModes[SIM_PINS];
+static bool isrMasked[SIM_PINS]; // gpio_intr_disable()
+
+static bool driven[SIM_PINS]; // set by the script, the pull-up loses
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin >= SIM_PINS) return;
+  modes[pin] = mode;
+  // Nothing external drives an input pin until the script does
+  if ((mode & PULLUP) && (mode & OUTPUT) != OUTPUT && !driven[pin]) levels[pin] = HIGH;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+  if (pin < SIM_PINS) levels[pin] = val ? HIGH : LOW;
+}
+
+int digitalRead(uint8_t pin) {
+  return pin < SIM_PINS ? levels[pin] : LOW;
+}
+
+void attachInterrupt(uint8_t pin, void (*isr)(), int mode) {
+  if (pin >= SIM_PINS) return;
+  isrs[pin] = isr;
+  isrModes[pin] = mode;
+  isrMasked[pin] = false;
+}
+
+void detachInterrupt(uint8_t pin) {
+  if (pin < SIM_PINS) isrs[pin] = nullptr;
+}
+
+// A level type (left there by gpio_wakeup_enable()) can't be cleared while
+// the pin stays at its level: the real ISR runs again the moment it returns,
+// for as long as the button is held. The sim can't run loop() in between, so
+// it stands for that with SIM_LEVEL_REFIRES calls, more than any ring holds.
+#define SIM_LEVEL_REFIRES 256
+
+static void fireLevel(uint8_t pin) {
+  int mode = isrModes[pin];
+  if (!isrs[pin] || isrMasked[pin]) return;
+  if (mode != GPIO_INTR_LOW_LEVEL && mode != GPIO_INTR_HIGH_LEVEL) return;
+  if (levels[pin] != (mode == GPIO_INTR_HIGH_LEVEL ? HIGH : LOW)) return;
+  for (uint16_t i = 0; i < SIM_LEVEL_REFIRES; i++) isrs[pin]();
+}
+
+void simSetPin(uint8_t pin, uint8_t level) {
+  if (pin >= SIM_PINS) return;
+  level = level ? HIGH : LOW;
+  driven[pin] = true;
+  if (levels[pin] == level) return;
+  levels[pin] = level;
+
+  int edge = level ? RISING : FALLING;
+  int mode = isrModes[pin];
+  if (isrs[pin] && !isrMasked[pin] && (mode == CHANGE || mode == edge)) isrs[pin]();
+  fireLevel(pin);
+}
+
+// ================= SERIAL =================
+#define SIM_SERIAL_RX 256
+
+static char rx[SIM_SERIAL_RX];
+static uint16_t rxHead = 0, rxTail = 0;
+
+void simSerialInput(const char* text) {
+  for (; *text; text++) {
+    uint16_t next = (rxHead + 1) % SIM_SERIAL_RX;
+    if (next == rxTail) return; // full, like the UART FIFO
+    rx[rxHead] = *text;
+    rxHead = next;
+  }
+}
+
+int HardwareSerial::available() {
+  return (rxHead - rxTail + SIM_SERIAL_RX) % SIM_SERIAL_RX;
+}
+
+int HardwareSerial::peek() {
+  return rxHead == rxTail ? -1 : (uint8_t)rx[rxTail];
+}
+
+int HardwareSerial::read() {
+  int c = peek();
+  if (c >= 0) rxTail = (rxTail + 1) % SIM_SERIAL_RX;
+  return c;
+}
+
+size_t Print::printf(const char* format, ...) {
+  char buf[256];
+  va_list args;
+  va_start(args, format);
+  int n = vsnprintf(buf, sizeof(buf), format, args);
+  va_end(args);
+  if (n < 0) return 0;
+  return write((const uint8_t*)buf, (size_t)n < sizeof(buf) ? n : sizeof(buf) - 1);
+}
+
+// ================= MATH =================
+// Own generator so runs are repeatable on every host libc
+static uint32_t rngState = 1;
+
+void randomSeed(unsigned long seed) {
+  if (seed) rngState = (uint32_t)seed;
+}
+
+static uint32_t nextRandom() {
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 17;
+  rngState ^= rngState << 5;
+  return rngState;
+}
+
+long random(long howbig) {
+  return howbig > 0 ? (long)(nextRandom() % (uint32_t)howbig) : 0;
+}
+
+long random(long howsmall, long howbig) {
+  return howsmall >= howbig ? howsmall : howsmall + random(howbig - howsmall);
+}
+
+long map(long x, long in_min, long in_max, long out_min, long out_max) {
+  if (in_max == in_min) return out_min;
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+// ================= SLEEP =================
+static SimSleepHandler sleepHandler = nullptr;
+static esp_sleep_wakeup_cause_t wakeCause = ESP_SLEEP_WAKEUP_UNDEFINED;
+
+// Bounds of the RTC_DATA_ATTR section, from the linker; weak so a build
+// without RTC variables still links
+extern uint8_t __start_sim_rtc[] __attribute__((weak));
+extern uint8_t __stop_sim_rtc[] __attribute__((weak));
+
+void simOnDeepSleep(SimSleepHandler handler) {
+  sleepHandler = handler;
+}
+
+esp_err_t esp_deep_sleep_enable_gpio_wakeup(uint64_t, esp_deepsleep_gpio_wake_up_mode_t) {
+  return ESP_OK;
+}
+
+// ---- light sleep ----
+static uint64_t timerWakeUs = 0; // 0: no timer wakeup
+static bool gpioWake = false;
+static uint8_t wakeLevels[SIM_PINS]; // per pin, its wakeup level + 1, 0 for none
+static SimLightSleepStats lightSleep;
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t us) {
+  timerWakeUs = us;
+  return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_gpio_wakeup() {
+  gpioWake = true;
+  return ESP_OK;
+}
+
+esp_err_t esp_sleep_disable_wakeup_source(esp_sleep_source_t source) {
+  if (source == ESP_SLEEP_WAKEUP_TIMER || source == ESP_SLEEP_WAKEUP_ALL) timerWakeUs = 0;
+  if (source == ESP_SLEEP_WAKEUP_GPIO || source == ESP_SLEEP_WAKEUP_ALL) gpioWake = false;
+  return ESP_OK;
+}
+
+// Like the IDF driver it also rewrites the pin's interrupt type to the
+// level, so attachInterrupt()'s edge mode is gone until set again
+esp_err_t gpio_wakeup_enable(gpio_num_t pin, gpio_int_type_t type) {
+  if (pin >= SIM_PINS || (type != GPIO_INTR_LOW_LEVEL && type != GPIO_INTR_HIGH_LEVEL)) return -1;
+  wakeLevels[pin] = (type == GPIO_INTR_HIGH_LEVEL ? HIGH : LOW) + 1;
+  isrModes[pin] = type;
+  fireLevel(pin);
+  return ESP_OK;
+}
+
+esp_err_t gpio_wakeup_disable(gpio_num_t pin) {
+  if (pin >= SIM_PINS) return -1;
+  wakeLevels[pin] = 0;
+  return ESP_OK;
+}
+
+esp_err_t gpio_set_intr_type(gpio_num_t pin, gpio_int_type_t type) {
+  if (pin >= SIM_PINS) return -1;
+  isrModes[pin] = type;
+  fireLevel(pin);
+  return ESP_OK;
+}
+
+// The pin's interrupt off and on, type and wakeup left alone
+esp_err_t gpio_intr_disable(gpio_num_t pin) {
+  if (pin >= SIM_PINS) return -1;
+  isrMasked[pin] = true;
+  return ESP_OK;
+}
+
+esp_err_t gpio_intr_enable(gpio_num_t pin) {
+  if (pin >= SIM_PINS) return -1;
+  isrMasked[pin] = false;
+  fireLevel(pin);
+  return ESP_OK;
+}
+
+static bool pinWakes() {
+  if (!gpioWake) return false;
+  for (uint8_t pin = 0; pin < SIM_PINS; pin++) {
+    if (wakeLevels[pin] && levels[pin] == wakeLevels[pin] - 1) return true;
+  }
+  return false;
+}
+
+// Like simAdvanceUs() up to the timer, but a pin reaching its wakeup level
+// ends it there. Without a timer only a pin (or the end of the script) does.
+esp_err_t esp_light_sleep_start() {
+  uint64_t startUs = nowUs;
+  uint64_t target = timerWakeUs ? nowUs + timerWakeUs : UINT64_MAX;
+  wakeCause = ESP_SLEEP_WAKEUP_TIMER;
+  lightSleep.sleeps++;
+
+  bool woken = pinWakes();
+  while (!woken && nextEvent < eventCount && events[nextEvent].atUs <= target) {
+    const SimEvent& ev = events[nextEvent++];
+    if (ev.atUs > nowUs) nowUs = ev.atUs;
+    apply(ev);
+    woken = pinWakes();
+  }
+  if (woken) {
+    wakeCause = ESP_SLEEP_WAKEUP_GPIO;
+    lightSleep.gpioWakes++;
+  } else if (target != UINT64_MAX) {
+    nowUs = target;
+  }
+  lightSleep.us += nowUs - startUs;
+  return ESP_OK;
+}
+
+const SimLightSleepStats& simLightSleepStats() {
+  return lightSleep;
+}
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause() {
+  return wakeCause; // a cold boot unless the run started with simWakeFromSleep()
+}
+
+void simWakeFromSleep() {
+  wakeCause = ESP_SLEEP_WAKEUP_GPIO;
+}
+
+bool simRtcSave(const char* path) {
+  FILE* f = fopen(path, "wb");
+  if (!f) return false;
+  size_t n = __stop_sim_rtc - __start_sim_rtc;
+  bool ok = fwrite(__start_sim_rtc, 1, n, f) == n;
+  return fclose(f) == 0 && ok;
+}
+
+bool simRtcLoad(const char* path) {
+  FILE* f = fopen(path, "rb");
+  if (!f) return false;
+  size_t n = __stop_sim_rtc - __start_sim_rtc;
+  uint8_t buf[4096];
+  // Same size or it's from another build, with other variables in there
+  bool ok = n <= sizeof(buf) && fread(buf, 1, sizeof(buf), f) == n;
+  fclose(f);
+  if (ok) memcpy(__start_sim_rtc, buf, n);
+  return ok;
+}
+
+void esp_deep_sleep_start() {
+  if (sleepHandler) sleepHandler();
+  exit(0);
+}
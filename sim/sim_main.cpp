@@ -0,0 +1,296 @@
+#include <chrono>
+#include <ctype.h>
+#include <unistd.h>
+#include "sim.h"
+#include <Arduino.h>
+#include "trace.h"
+
+// The firmware's entry points (src/main.cpp)
+void setup();
+void loop();
+void printTraceReport();
+
+// Button pins as wired in main.cpp (BTN_YES_PIN / BTN_NO_PIN), active low
+#define SIM_BTN_YES D1
+#define SIM_BTN_NO  D2
+#define SIM_PRESS_MS 100
+
+#define SIM_DEFAULT_LIMIT_MS 3600000UL // an hour of virtual time
+#define SIM_REPLAY_TAIL_MS   5000        // keep running after the last traced event
+
+static const char* USAGE =
+  "usage: program [-s script] [-e events] [-r trace.trc] [-t ms] [-f dir] [-l leds.csv]\n"
+  "               [-m rtc.bin] [-w yes|no]\n"
+  "  -s FILE  script, one event per line\n"
+  "  -e TEXT  events inline, separated by ';'\n"
+  "  -r FILE  replay the presses of a recorded trace, then print its latency report\n"
+  "  -t MS    stop at this virtual time (default 1 h; deep sleep also stops)\n"
+  "  -f DIR   write every new panel image to DIR/frame_<n>_<ms>.pbm\n"
+  "  -l FILE  log every LED show() as CSV\n"
+  "  -m FILE  RTC memory: saved here at deep sleep, read back by -w\n"
+  "  -w BTN   start as a wake from deep sleep by button yes|no, held for the\n"
+  "           first 100 ms\n"
+  "events: <ms> press yes|no|<pin> [hold_ms] | <ms> down|up yes|no|<pin>\n"
+  "        <ms> serial <text> | <ms> snap <file.pbm> | <ms> end\n";
+
+static const char* frameDir = nullptr;
+static FILE* ledFile = nullptr;
+static const char* rtcPath = nullptr;
+static uint32_t passes = 0;
+static uint32_t heapAfterSetup = 0;
+static TraceRecord recorded[TRACE_CAPACITY]; // the trace being replayed
+static uint16_t recordedCount = 0;
+static bool replaying = false;
+static std::chrono::steady_clock::time_point wallStart;
+
+// ================= SCRIPT =================
+static bool parsePin(const char* s, uint8_t& pin) {
+  if (!strcmp(s, "yes")) pin = SIM_BTN_YES;
+  else if (!strcmp(s, "no")) pin = SIM_BTN_NO;
+  else if (isdigit((unsigned char)*s)) pin = (uint8_t)atoi(s);
+  else return false;
+  return true;
+}
+
+static bool schedulePinUs(uint64_t atUs, uint8_t pin, uint8_t level) {
+  SimEvent ev = {};
+  ev.atUs = atUs;
+  ev.kind = SIM_PIN;
+  ev.pin = pin;
+  ev.level = level;
+  return simSchedule(ev);
+}
+
+static bool schedulePin(uint64_t atMs, uint8_t pin, uint8_t level) {
+  return schedulePinUs(atMs * 1000, pin, level);
+}
+
+// "<ms> <action> [args]"; false on a malformed line
+static bool parseEvent(char* line) {
+  while (isspace((unsigned char)*line)) line++;
+  if (!*line || *line == '#') return true;
+
+  char* rest;
+  uint64_t atMs = strtoull(line, &rest, 10);
+  if (rest == line) return false;
+
+  char action[16] = "", arg[64] = "";
+  int actionEnd = 0, argEnd = 0;
+  if (sscanf(rest, " %15s%n", action, &actionEnd) != 1) return false;
+  const char* args = rest + actionEnd;
+  bool hasArg = sscanf(args, " %63s%n", arg, &argEnd) == 1;
+
+  uint8_t pin;
+  if (!strcmp(action, "press") && hasArg && parsePin(arg, pin)) {
+    long hold = strtol(args + argEnd, nullptr, 10);
+    return schedulePin(atMs, pin, LOW) && schedulePin(atMs + (hold > 0 ? hold : SIM_PRESS_MS), pin, HIGH);
+  }
+  if (!strcmp(action, "down") && hasArg && parsePin(arg, pin)) return schedulePin(atMs, pin, LOW);
+  if (!strcmp(action, "up") && hasArg && parsePin(arg, pin)) return schedulePin(atMs, pin, HIGH);
+
+  SimEvent ev = {};
+  ev.atUs = atMs * 1000;
+  if (!strcmp(action, "serial") && hasArg) {
+    ev.kind = SIM_SERIAL;
+    while (*args == ' ') args++;
+    strncpy(ev.text, args, sizeof(ev.text) - 1);
+    ev.text[strcspn(ev.text, "\r\n")] = 0;
+  } else if (!strcmp(action, "snap") && hasArg) {
+    ev.kind = SIM_SNAP;
+    strncpy(ev.text, arg, sizeof(ev.text) - 1);
+  } else if (!strcmp(action, "end")) {
+    ev.kind = SIM_END;
+  } else {
+    return false;
+  }
+  return simSchedule(ev);
+}
+
+static bool parseScript(char* text, char separator) {
+  char* line = text;
+  while (line) {
+    char* next = strchr(line, separator);
+    if (next) *next++ = 0;
+    if (!parseEvent(line)) {
+      fprintf(stderr, "sim: bad event '%s'\n", line);
+      return false;
+    }
+    line = next;
+  }
+  return true;
+}
+
+static bool loadScript(const char* path) {
+  FILE* f = fopen(path, "r");
+  if (!f) {
+    fprintf(stderr, "sim: cannot open %s\n", path);
+    return false;
+  }
+  char line[128];
+  bool ok = true;
+  while (ok && fgets(line, sizeof(line), f)) ok = parseScript(line, '\n');
+  fclose(f);
+  return ok;
+}
+
+// ================= TRACE REPLAY =================
+// Presses go in at the microsecond the board saw their edge; the rest of
+// the trace is only there to compare transitions with
+static bool loadTrace(const char* path) {
+  FILE* f = fopen(path, "rb");
+  if (!f) {
+    fprintf(stderr, "sim: cannot open %s\n", path);
+    return false;
+  }
+  char magic[4];
+  bool ok = fread(magic, 1, 4, f) == 4 && !memcmp(magic, TRACE_MAGIC, 4);
+  if (ok) recordedCount = fread(recorded, sizeof(TraceRecord), TRACE_CAPACITY, f);
+  fclose(f);
+  if (!ok) {
+    fprintf(stderr, "sim: %s is not a trace file\n", path);
+    return false;
+  }
+
+  uint32_t lastUs = 0;
+  for (uint16_t i = 0; i < recordedCount; i++) {
+    const TraceRecord& r = recorded[i];
+    lastUs = r.us;
+    if (r.kind != TRACE_PRESS) continue;
+    uint8_t pin = r.a == BUTTON_YES ? SIM_BTN_YES : SIM_BTN_NO;
+    if (!schedulePinUs(r.us, pin, LOW) || !schedulePinUs(r.us + SIM_PRESS_MS * 1000, pin, HIGH)) {
+      fprintf(stderr, "sim: too many events in %s\n", path);
+      return false;
+    }
+  }
+
+  SimEvent end = {};
+  end.atUs = lastUs + SIM_REPLAY_TAIL_MS * 1000ULL;
+  end.kind = SIM_END;
+  replaying = true;
+  return simSchedule(end);
+}
+
+static void replayReport() {
+  printTraceReport();
+
+  // Same transitions in the same order, or the latencies aren't comparable
+  const TraceRecord* live = traceRecords();
+  uint16_t a = 0, b = 0, n = 0;
+  for (;;) {
+    while (a < recordedCount && recorded[a].kind != TRACE_TRANSITION) a++;
+    while (b < traceCount() && live[b].kind != TRACE_TRANSITION) b++;
+    if (a == recordedCount || b == traceCount()) break;
+    if (recorded[a].a != live[b].a || recorded[a].b != live[b].b || recorded[a].c != live[b].c) {
+      fprintf(stderr, "sim: replay diverged at transition %u (%lu ms)\n", n, (unsigned long)(live[b].us / 1000));
+      return;
+    }
+    a++, b++, n++;
+  }
+  bool same = (a == recordedCount) == (b == traceCount());
+  fprintf(stderr, "sim: replay %s, %u transitions\n", same ? "matches the trace" : "ended early", n);
+}
+
+// ================= RUN =================
+static void captureFrame() {
+  if (!simPanelChanged() || !frameDir) return;
+  char path[512];
+  snprintf(path, sizeof(path), "%s/frame_%05u_%08lu.pbm", frameDir, simPanelStats().frames, millis());
+  if (!simPanelWritePbm(path)) fprintf(stderr, "sim: cannot write %s\n", path);
+}
+
+static void summary(const char* reason) {
+  captureFrame();
+  if (ledFile) fflush(ledFile);
+  if (replaying) replayReport();
+  fflush(stdout);
+
+  double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wallStart).count();
+  const SimPanelStats& panel = simPanelStats();
+  fprintf(stderr, "sim: %s at %lu ms, %u loop passes, %.1f ms wall (%.0fx)\n",
+          reason, millis(), passes, wallMs, wallMs > 0 ? millis() / wallMs : 0.0);
+  // 9 clocks per byte at u8g2's 400 kHz for the SSD1306
+  fprintf(stderr, "sim: panel %u images, %u I2C transfers, %u bytes (%.1f ms bus time)\n",
+          panel.frames, panel.transfers, panel.bytes, panel.bytes * 9 / 400.0);
+  fprintf(stderr, "sim: %u heap allocations after setup()\n", simHeapAllocs() - heapAfterSetup);
+  const SimLightSleepStats& sleep = simLightSleepStats();
+  fprintf(stderr, "sim: light sleep %u times (%u woken by a pin), %.1f ms\n",
+          sleep.sleeps, sleep.gpioWakes, sleep.us / 1000.0);
+  for (int16_t pin = 0; pin < 32; pin++) {
+    if (simLedShows(pin)) fprintf(stderr, "sim: leds on pin %d, %u shows\n", pin, simLedShows(pin));
+  }
+}
+
+static void onDeepSleep() {
+  if (rtcPath && !simRtcSave(rtcPath)) fprintf(stderr, "sim: cannot write %s\n", rtcPath);
+  summary("deep sleep");
+}
+
+int main(int argc, char** argv) {
+  uint64_t limitMs = SIM_DEFAULT_LIMIT_MS;
+  const char* wakeBy = nullptr;
+  int opt;
+  while ((opt = getopt(argc, argv, "s:e:r:t:f:l:m:w:h")) != -1) {
+    switch (opt) {
+      case 's':
+        if (!loadScript(optarg)) return 2;
+        break;
+      case 'e':
+        if (!parseScript(optarg, ';')) return 2;
+        break;
+      case 'r':
+        if (!loadTrace(optarg)) return 2;
+        break;
+      case 't':
+        limitMs = strtoull(optarg, nullptr, 10);
+        break;
+      case 'f':
+        frameDir = optarg;
+        break;
+      case 'l':
+        ledFile = fopen(optarg, "w");
+        if (!ledFile) {
+          fprintf(stderr, "sim: cannot open %s\n", optarg);
+          return 2;
+        }
+        simLedLog(ledFile);
+        break;
+      case 'm':
+        rtcPath = optarg;
+        break;
+      case 'w':
+        wakeBy = optarg;
+        break;
+      default:
+        fputs(USAGE, opt == 'h' ? stdout : stderr);
+        return opt == 'h' ? 0 : 2;
+    }
+  }
+
+  simOnDeepSleep(onDeepSleep);
+
+  // The press that woke the chip is still down when setup() runs
+  if (wakeBy) {
+    uint8_t pin;
+    if (!parsePin(wakeBy, pin)) {
+      fputs(USAGE, stderr);
+      return 2;
+    }
+    if (rtcPath && !simRtcLoad(rtcPath)) fprintf(stderr, "sim: no RTC memory from %s, waking with it blank\n", rtcPath);
+    simWakeFromSleep();
+    simSetPin(pin, LOW);
+    schedulePin(SIM_PRESS_MS, pin, HIGH);
+  }
+  wallStart = std::chrono::steady_clock::now();
+
+  setup();
+  heapAfterSetup = simHeapAllocs();
+  captureFrame();
+  while (!simEnded() && millis() < limitMs) {
+    loop();
+    passes++;
+    captureFrame();
+  }
+
+  summary(simEnded() ? "end" : "time limit");
+  return 0;
+}
@@ -0,0 +1,108 @@
+#include "sim.h"
+#include <Adafruit_NeoPixel.h>
+
+// ================= LED LOG =================
+#define SIM_LED_PINS 32
+
+static FILE* ledLog = nullptr;
+static uint32_t shows[SIM_LED_PINS];
+
+void simLedLog(FILE* out) {
+  ledLog = out;
+  if (ledLog) fprintf(ledLog, "ms,pin,rgb\n");
+}
+
+uint32_t simLedShows(int16_t pin) {
+  return pin >= 0 && pin < SIM_LED_PINS ? shows[pin] : 0;
+}
+
+// ================= Adafruit_NeoPixel =================
+Adafruit_NeoPixel::Adafruit_NeoPixel(uint16_t n, int16_t pin, neoPixelType type) : pin(pin) {
+  updateType(type);
+  updateLength(n);
+}
+
+Adafruit_NeoPixel::~Adafruit_NeoPixel() {
+  free(pixels);
+}
+
+void Adafruit_NeoPixel::begin() {
+  if (pin >= 0) pinMode(pin, OUTPUT);
+}
+
+void Adafruit_NeoPixel::updateLength(uint16_t n) {
+  free(pixels);
+  numBytes = n * 3;
+  pixels = (uint8_t*)calloc(numBytes ? numBytes : 1, 1);
+  numLEDs = n;
+}
+
+void Adafruit_NeoPixel::updateType(neoPixelType t) {
+  rOffset = (t >> 4) & 0b11;
+  gOffset = (t >> 2) & 0b11;
+  bOffset = t & 0b11;
+}
+
+// What went out on the wire (brightness already applied), as RGB
+void Adafruit_NeoPixel::show() {
+  if (pin >= 0 && pin < SIM_LED_PINS) shows[pin]++;
+  if (!ledLog) return;
+
+  fprintf(ledLog, "%lu,%d,", millis(), pin);
+  for (uint16_t i = 0; i < numLEDs; i++) {
+    const uint8_t* p = &pixels[i * 3];
+    fprintf(ledLog, "%s%02x%02x%02x", i ? " " : "", p[rOffset], p[gOffset], p[bOffset]);
+  }
+  fputc('\n', ledLog);
+}
+
+void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b) {
+  if (n >= numLEDs) return;
+  if (brightness) { // see setBrightness()
+    r = (r * brightness) >> 8;
+    g = (g * brightness) >> 8;
+    b = (b * brightness) >> 8;
+  }
+  uint8_t* p = &pixels[n * 3];
+  p[rOffset] = r;
+  p[gOffset] = g;
+  p[bOffset] = b;
+}
+
+void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint32_t c) {
+  setPixelColor(n, (uint8_t)(c >> 16), (uint8_t)(c >> 8), (uint8_t)c);
+}
+
+void Adafruit_NeoPixel::fill(uint32_t c, uint16_t first, uint16_t count) {
+  if (first >= numLEDs) return;
+  uint16_t end = count ? first + count : numLEDs;
+  if (end > numLEDs) end = numLEDs;
+  for (uint16_t i = first; i < end; i++) setPixelColor(i, c);
+}
+
+// Like the library, the buffer holds scaled values, so changing the
+// brightness rescales what is already there (lossy)
+void Adafruit_NeoPixel::setBrightness(uint8_t b) {
+  uint8_t newBrightness = b + 1;
+  if (newBrightness == brightness) return;
+
+  uint8_t oldBrightness = brightness - 1;
+  uint16_t scale;
+  if (oldBrightness == 0) scale = 0;
+  else if (b == 255) scale = 65535 / oldBrightness;
+  else scale = (((uint16_t)newBrightness << 8) - 1) / oldBrightness;
+  for (uint16_t i = 0; i < numBytes; i++) pixels[i] = (pixels[i] * scale) >> 8;
+  brightness = newBrightness;
+}
+
+uint32_t Adafruit_NeoPixel::getPixelColor(uint16_t n) const {
+  if (n >= numLEDs) return 0;
+  const uint8_t* p = &pixels[n * 3];
+  uint8_t r = p[rOffset], g = p[gOffset], b = p[bOffset];
+  if (brightness) {
+    r = (r << 8) / brightness;
+    g = (g << 8) / brightness;
+    b = (b << 8) / brightness;
+  }
+  return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+}
@@ -0,0 +1,182 @@
+#include "sim.h"
+#include <U8g2lib.h>
+
+// ================= SSD1306 MODEL =================
+// Just enough of the controller to follow what u8g2's driver sends over I2C:
+// control byte (Co, D/C#), column/page pointers in page and horizontal
+// addressing mode, display on/off and inverse. Commands with arguments we
+// don't model are skipped by argument count. The image is taken as u8g2's R0
+// orientation, i.e. RAM column x is screen column x.
+
+#define PANEL_W 128
+#define PANEL_PAGES 8
+
+enum AddrMode : uint8_t { ADDR_HORIZONTAL, ADDR_VERTICAL, ADDR_PAGE };
+
+static uint8_t ram[PANEL_PAGES][PANEL_W];
+static uint8_t col = 0, page = 0;
+static uint8_t colStart = 0, colEnd = PANEL_W - 1;
+static uint8_t pageStart = 0, pageEnd = PANEL_PAGES - 1;
+static AddrMode addrMode = ADDR_PAGE; // reset default
+static bool displayOn = false;
+static bool inverted = false;
+static bool changed = false;
+
+// I2C parser
+static bool expectControl = false;
+static bool dataMode = false;
+static bool singleByte = false; // Co set: one byte, then another control byte
+static uint8_t pendingCmd = 0;
+static uint8_t argIndex = 0;
+static uint8_t argsLeft = 0;
+
+static SimPanelStats stats;
+
+static uint8_t argCount(uint8_t cmd) {
+  switch (cmd) {
+    case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3:
+    case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+      return 1;
+    case 0x21: case 0x22: case 0xA3:
+      return 2;
+    case 0x29: case 0x2A:
+      return 5;
+    case 0x26: case 0x27:
+      return 6;
+    default:
+      return 0;
+  }
+}
+
+static void commandArg(uint8_t cmd, uint8_t index, uint8_t arg) {
+  switch (cmd) {
+    case 0x20: addrMode = (AddrMode)(arg & 3); break;
+    case 0x21:
+      if (index == 0) colStart = col = arg & 0x7F;
+      else colEnd = arg & 0x7F;
+      break;
+    case 0x22:
+      if (index == 0) pageStart = page = arg & 7;
+      else pageEnd = arg & 7;
+      break;
+  }
+}
+
+static void command(uint8_t b) {
+  if (argsLeft) {
+    commandArg(pendingCmd, argIndex++, b);
+    argsLeft--;
+    return;
+  }
+
+  if (b <= 0x0F) {
+    col = (col & 0xF0) | b;
+  } else if (b <= 0x1F) {
+    col = (col & 0x0F) | ((b & 0x0F) << 4);
+  } else if (b >= 0xB0 && b <= 0xB7) {
+    page = b & 7;
+  } else if (b == 0xAE || b == 0xAF) {
+    changed |= displayOn != (b == 0xAF);
+    displayOn = b == 0xAF;
+  } else if (b == 0xA6 || b == 0xA7) {
+    changed |= inverted != (b == 0xA7);
+    inverted = b == 0xA7;
+  } else if ((argsLeft = argCount(b))) {
+    pendingCmd = b;
+    argIndex = 0;
+  }
+}
+
+static void writeRam(uint8_t b) {
+  if (ram[page][col] != b) changed = true;
+  ram[page][col] = b;
+  stats.dataBytes++;
+
+  switch (addrMode) {
+    case ADDR_PAGE:
+      col = (col + 1) & (PANEL_W - 1);
+      break;
+    case ADDR_HORIZONTAL:
+      if (col != colEnd) { col++; break; }
+      col = colStart;
+      page = page == pageEnd ? pageStart : page + 1;
+      break;
+    default: // vertical
+      if (page != pageEnd) { page++; break; }
+      page = pageStart;
+      col = col == colEnd ? colStart : col + 1;
+      break;
+  }
+}
+
+static void feed(uint8_t b) {
+  if (expectControl) {
+    dataMode = b & 0x40;
+    singleByte = b & 0x80;
+    expectControl = false;
+    return;
+  }
+  if (dataMode) writeRam(b);
+  else command(b);
+  if (singleByte) expectControl = true;
+}
+
+uint8_t simPanelByteCb(u8x8_t*, uint8_t msg, uint8_t arg_int, void* arg_ptr) {
+  switch (msg) {
+    case U8X8_MSG_BYTE_START_TRANSFER:
+      stats.transfers++;
+      stats.bytes++; // address byte
+      expectControl = true;
+      break;
+    case U8X8_MSG_BYTE_SEND: {
+      const uint8_t* data = (const uint8_t*)arg_ptr;
+      for (uint8_t i = 0; i < arg_int; i++) feed(data[i]);
+      stats.bytes += arg_int;
+      break;
+    }
+    default: // INIT, SET_DC, END_TRANSFER
+      break;
+  }
+  return 1;
+}
+
+uint8_t simPanelGpioCb(u8x8_t*, uint8_t msg, uint8_t arg_int, void*) {
+  switch (msg) {
+    case U8X8_MSG_DELAY_MILLI: delay(arg_int); break;
+    case U8X8_MSG_DELAY_10MICRO: delayMicroseconds(arg_int * 10); break;
+    default: break;
+  }
+  return 1;
+}
+
+// ================= OUTPUT =================
+bool simPanelChanged() {
+  if (!changed) return false;
+  changed = false;
+  stats.frames++;
+  return true;
+}
+
+bool simPanelWritePbm(const char* path) {
+  FILE* f = fopen(path, "wb");
+  if (!f) return false;
+
+  fprintf(f, "P4\n%d %d\n", PANEL_W, PANEL_PAGES * 8);
+  for (uint8_t y = 0; y < PANEL_PAGES * 8; y++) {
+    uint8_t row[PANEL_W / 8] = {};
+    for (uint8_t x = 0; x < PANEL_W; x++) {
+      bool lit = displayOn && (((ram[y >> 3][x] >> (y & 7)) & 1) != inverted);
+      if (lit) row[x >> 3] |= 0x80 >> (x & 7);
+    }
+    fwrite(row, 1, sizeof(row), f);
+  }
+  return fclose(f) == 0;
+}
+
+const uint8_t* simPanelRam() {
+  return &ram[0][0];
+}
+
+const SimPanelStats& simPanelStats() {
+  return stats;
+}
@@ -0,0 +1,61 @@
+#include "bench.h"
+
+#ifdef BENCH
+
+#ifdef ESP_PLATFORM
+#define BENCH_TARGET "esp32c3"
+#else
+#define BENCH_TARGET "host"
+#endif
+
+// A -DBODY_300 build has its own baseline
+#ifdef BODY_300
+#define BENCH_BODY "_body300"
+#else
+#define BENCH_BODY ""
+#endif
+
+volatile uint32_t benchSink;
+
+static uint32_t samples[BENCH_RUNS];
+
+static uint32_t timeOnce(const BenchCase& c) {
+  if (c.prepare) c.prepare(c.arg);
+  uint32_t t0 = cyclesNow();
+  c.run(c.arg);
+  return cyclesNow() - t0;
+}
+
+static void sortSamples() {
+  for (uint16_t i = 1; i < BENCH_RUNS; i++) {
+    uint32_t v = samples[i];
+    uint16_t j = i;
+    for (; j > 0 && samples[j - 1] > v; j--) samples[j] = samples[j - 1];
+    samples[j] = v;
+  }
+}
+
+void benchRun(Print& out, const BenchCase* cases, uint8_t count) {
+  out.printf("{\"target\":\"%s\",\"ticks_per_us\":%u,\"runs\":%u,\"results\":[\n",
+             BENCH_TARGET BENCH_BODY, (unsigned)CYCLES_PER_US, (unsigned)BENCH_RUNS);
+
+  for (uint8_t k = 0; k < count; k++) {
+    const BenchCase& c = cases[k];
+    for (uint8_t i = 0; i < BENCH_WARMUP; i++) timeOnce(c);
+
+    uint64_t total = 0;
+    for (uint16_t i = 0; i < BENCH_RUNS; i++) {
+      samples[i] = timeOnce(c);
+      total += samples[i];
+    }
+    sortSamples();
+
+    out.printf("{\"name\":\"%s\",\"min\":%u,\"median\":%u,\"mean\":%u}%s\n",
+               c.name, (unsigned)samples[0], (unsigned)samples[BENCH_RUNS / 2],
+               (unsigned)(total / BENCH_RUNS), k + 1 < count ? "," : "");
+    delay(1); // let the idle task in (task watchdog) between cases
+  }
+  out.printf("]}\n");
+}
+
+#endif
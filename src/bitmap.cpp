@@ -0,0 +1,128 @@
+#include "bitmap.h"
+#include "bitmap_data.h"
+
+static BitmapStats stats[BMP_COUNT];
+
+// MSB-first reader for the packed pixel runs
+struct BitStream {
+  const uint8_t* p;
+  uint8_t mask;
+
+  uint8_t bit() {
+    uint8_t b = (*p & mask) != 0;
+    mask >>= 1;
+    if (!mask) { mask = 0x80; p++; }
+    return b;
+  }
+
+  // Elias gamma: n zeros, then n+1 bits of value
+  uint32_t gamma() {
+    uint8_t n = 0;
+    while (!bit()) n++;
+    uint32_t v = 1;
+    while (n--) v = (v << 1) | bit();
+    return v;
+  }
+};
+
+#define COLOR_NONE 0xFF
+
+struct Canvas {
+  uint8_t* buf;
+  int w, h;
+  uint8_t fg, bg; // u8g2 draw colours for 1 and 0 bits (0 clear, 1 set, 2 xor)
+};
+
+static inline void applyColor(uint8_t& b, uint8_t mask, uint8_t color) {
+  if (color == 0) b &= ~mask;
+  else if (color == 1) b |= mask;
+  else b ^= mask;
+}
+
+// Eight horizontal pixels, bit k at x + k, into the page-major buffer
+static void plot8(const Canvas& c, int x, int y, uint8_t bits, uint8_t valid) {
+  if (y < 0 || y >= c.h) return;
+  uint8_t* col = c.buf + (y >> 3) * c.w + x;
+  uint8_t m = 1 << (y & 7);
+
+  if (c.bg == COLOR_NONE && c.fg == 1 && x >= 0 && x + 8 <= c.w) {
+    // Common case: transparent, plain draw colour, fully on screen
+    while (bits) {
+      col[__builtin_ctz(bits)] |= m;
+      bits &= bits - 1;
+    }
+    return;
+  }
+
+  for (uint8_t k = 0; k < 8; k++) {
+    if (!((valid >> k) & 1) || x + k < 0 || x + k >= c.w) continue;
+    uint8_t color = ((bits >> k) & 1) ? c.fg : c.bg;
+    if (color != COLOR_NONE) applyColor(col[k], m, color);
+  }
+}
+
+void bitmapDraw(U8G2& display, int x, int y, BitmapId id) {
+  uint32_t t0 = micros();
+  const PackedBitmap& bmp = BITMAPS[id];
+  u8g2_t* u = display.getU8g2();
+
+  Canvas c;
+  c.buf = display.getBufferPtr();
+  c.w = display.getBufferTileWidth() * 8;
+  c.h = display.getBufferTileHeight() * 8;
+  c.fg = u->draw_color;
+  c.bg = u->bitmap_transparency ? COLOR_NONE : (u->draw_color == 0 ? 1 : 0);
+
+  uint8_t prev[16] = {}; // row above, to undo the row delta
+  uint8_t stride = (bmp.w + 7) / 8;
+  BitStream in = { bmp.data, 0x80 };
+  uint8_t color = in.bit();
+  uint32_t left = in.gamma();
+
+  for (uint8_t row = 0; row < bmp.h; row++) {
+    for (uint8_t b = 0; b < stride; b++) {
+      uint8_t n = min(8, bmp.w - 8 * b);
+      uint8_t bits = 0;
+      for (uint8_t k = 0; k < n;) {
+        if (left == 0) {
+          color ^= 1;
+          left = in.gamma();
+        }
+        uint8_t take = left < (uint32_t)(n - k) ? left : n - k;
+        if (color) bits |= ((1u << take) - 1) << k;
+        k += take;
+        left -= take;
+      }
+      bits ^= prev[b];
+      prev[b] = bits;
+      plot8(c, x + 8 * b, y + row, bits, (1u << n) - 1);
+    }
+  }
+
+  BitmapStats& s = stats[id];
+  s.lastUs = micros() - t0;
+  if (s.lastUs > s.maxUs) s.maxUs = s.lastUs;
+  s.draws++;
+}
+
+const PackedBitmap& bitmapInfo(BitmapId id) {
+  return BITMAPS[id];
+}
+
+const BitmapStats& bitmapStats(BitmapId id) {
+  return stats[id];
+}
+
+void bitmapPrintStats(Print& out) {
+  out.println("name,w,h,raw_bytes,packed_bytes,draws,last_us,max_us");
+  uint32_t raw = 0, packed = 0;
+  for (uint8_t i = 0; i < BMP_COUNT; i++) {
+    const PackedBitmap& b = BITMAPS[i];
+    out.printf("%s,%u,%u,%u,%u,%lu,%lu,%lu\n", b.name, b.w, b.h, b.rawSize, b.size,
+               (unsigned long)stats[i].draws, (unsigned long)stats[i].lastUs, (unsigned long)stats[i].maxUs);
+    raw += b.rawSize;
+    packed += b.size;
+  }
+  out.print("flash_saved,");
+  out.println(raw - packed);
+}
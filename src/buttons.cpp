@@ -0,0 +1,74 @@
+#include "buttons.h"
+
+static uint8_t pins[BUTTON_COUNT];
+static SpscRing<ButtonEdge, 64> edges;
+static DebounceFilter filters[BUTTON_COUNT];
+static LatencyHistogram latency;
+
+static void IRAM_ATTR onYesEdge() {
+  edges.push({ (uint32_t)micros(), BUTTON_YES, (uint8_t)digitalRead(pins[BUTTON_YES]) });
+}
+
+static void IRAM_ATTR onNoEdge() {
+  edges.push({ (uint32_t)micros(), BUTTON_NO, (uint8_t)digitalRead(pins[BUTTON_NO]) });
+}
+
+void buttonsBegin(uint8_t yesPin, uint8_t noPin, uint16_t debounceMs) {
+  pins[BUTTON_YES] = yesPin;
+  pins[BUTTON_NO] = noPin;
+
+  for (uint8_t b = 0; b < BUTTON_COUNT; b++) {
+    pinMode(pins[b], INPUT_PULLUP);
+    filters[b].lockoutUs = debounceMs * 1000UL;
+    filters[b].stable = digitalRead(pins[b]); // a button held through boot is not a press
+  }
+
+  attachInterrupt(digitalPinToInterrupt(yesPin), onYesEdge, CHANGE);
+  attachInterrupt(digitalPinToInterrupt(noPin), onNoEdge, CHANGE);
+}
+
+static bool deliver(ButtonPress& press, ButtonId button, uint32_t edgeUs) {
+  press.us = edgeUs;
+  press.button = button;
+  latency.add((uint32_t)micros() - edgeUs);
+  return true;
+}
+
+bool buttonsPoll(ButtonPress& press) {
+  ButtonEdge e;
+  while (edges.pop(e)) {
+    if (filters[e.button].update(e.level, e.us)) return deliver(press, (ButtonId)e.button, e.us);
+  }
+
+  // Ring drained: catch up with anything that settled inside a lockout window
+  uint32_t nowUs = micros();
+  for (uint8_t b = 0; b < BUTTON_COUNT; b++) {
+    if (filters[b].update(digitalRead(pins[b]), nowUs)) return deliver(press, (ButtonId)b, nowUs);
+  }
+  return false;
+}
+
+bool buttonHeld(ButtonId button) {
+  return filters[button].stable == LOW;
+}
+
+const LatencyHistogram& buttonsLatency() {
+  return latency;
+}
+
+uint32_t buttonsDroppedEdges() {
+  return edges.droppedCount();
+}
+
+void buttonsPrintLatency(Print& out) {
+  out.println("bucket_lo_us,count");
+  for (uint8_t k = 0; k < LATENCY_BUCKETS; k++) {
+    out.print(k == 0 ? 0UL : (1UL << k));
+    out.print(',');
+    out.println(latency.counts[k]);
+  }
+  out.print("max_us,");
+  out.println(latency.maxUs);
+  out.print("dropped_edges,");
+  out.println(buttonsDroppedEdges());
+}
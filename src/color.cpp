@@ -0,0 +1,27 @@
+#include <string.h>
+#include "color.h"
+
+// Strip buffers have no alignment guarantee past the allocator's, and a
+// 3-byte pixel count leaves a tail; memcpy keeps the word loads legal and
+// compiles to plain lw/sw on aligned data.
+static inline uint32_t load(const uint8_t* p) {
+  uint32_t w;
+  memcpy(&w, p, 4);
+  return w;
+}
+
+static inline void store(uint8_t* p, uint32_t w) {
+  memcpy(p, &w, 4);
+}
+
+void colorScaleBuffer(uint8_t* px, uint16_t bytes, uint16_t s) {
+  uint16_t i = 0;
+  for (; i + 4 <= bytes; i += 4) store(px + i, colorScale(load(px + i), s));
+  for (; i < bytes; i++) px[i] = px[i] * s >> 8;
+}
+
+void colorLerpBuffer(uint8_t* px, const uint8_t* to, uint16_t bytes, uint16_t t) {
+  uint16_t i = 0;
+  for (; i + 4 <= bytes; i += 4) store(px + i, colorLerp(load(px + i), load(to + i), t));
+  for (; i < bytes; i++) px[i] = (px[i] * (256 - t) + to[i] * t) >> 8;
+}
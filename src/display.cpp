@@ -0,0 +1,258 @@
+#include "display.h"
+#include "triple_buffer.h"
+#include "profiler.h"
+
+#define TILE_COLS 16 // 128 px / 8
+#define TILE_ROWS 8  // 64 px / 8
+#define ROW_BYTES (TILE_COLS * 8)
+#define FRAME_BYTES (TILE_ROWS * ROW_BYTES)
+
+#define CACHE_SLOTS (DISPLAY_CACHE_BYTES / FRAME_BYTES)
+
+#define DISPLAY_TASK_STACK 3072
+#define DISPLAY_TASK_PRIO  2 // above loopTask (1); it sleeps while I2C runs
+
+struct Frame {
+  uint8_t px[FRAME_BYTES];
+  uint32_t seq; // stats.frames after its flush
+};
+
+static U8G2* disp = nullptr;
+static TripleBuffer<Frame> frames;
+static uint8_t shadow[FRAME_BYTES]; // what the panel currently shows
+static std::atomic<bool> forceFull{false};
+static std::atomic<bool> sending{false};
+static bool panelOn = false; // display task only (or loop() without one)
+static TaskHandle_t task = nullptr;
+static DisplayStats stats;
+static uint32_t firstTileUs;
+
+// Frame cache, loop() only
+struct CachedFrame {
+  DisplayKey key; // msg[0] nullptr while the slot is free
+  uint32_t lastUse; // cacheClock, for LRU
+  uint32_t renderUs;
+  uint8_t px[FRAME_BYTES];
+};
+static CachedFrame cache[CACHE_SLOTS > 0 ? CACHE_SLOTS : 1];
+static uint32_t cacheClock;
+static const CachedFrame* lastFlushed = nullptr; // the newest flush came from this slot
+static DisplayKey missKey; // msg[0] nullptr: no miss being drawn
+static uint32_t missUs;
+
+// Push one run of dirty tiles and mirror it into the shadow
+static void sendRun(const uint8_t* frame, uint8_t tx, uint8_t ty, uint8_t tw) {
+  const uint8_t* tiles = frame + ty * ROW_BYTES + tx * 8;
+  u8x8_DrawTile(disp->getU8x8(), tx, ty, tw, (uint8_t*)tiles);
+  if (stats.lastFrameTiles == 0) firstTileUs = micros();
+  memcpy(shadow + ty * ROW_BYTES + tx * 8, tiles, tw * 8);
+
+  stats.tilesSent += tw;
+  stats.lastFrameTiles += tw;
+  stats.lastFrameBytes += DISPLAY_AREA_OVERHEAD + tw * 8;
+}
+
+static void sendFrame(const Frame& f) {
+  const uint8_t* frame = f.px;
+  PROFILE_SCOPE(PROF_SEND_FRAME);
+  uint32_t t0 = micros();
+  bool full = forceFull.load();
+  forceFull.store(false);
+
+  stats.bytesFull += TILE_ROWS * (DISPLAY_AREA_OVERHEAD + ROW_BYTES);
+  stats.lastFrameTiles = 0;
+  stats.lastFrameBytes = 0;
+
+  for (uint8_t ty = 0; ty < TILE_ROWS; ty++) {
+    const uint8_t* row = frame + ty * ROW_BYTES;
+    const uint8_t* shadowRow = shadow + ty * ROW_BYTES;
+
+    // Quick reject: whole page row unchanged
+    if (!full && memcmp(row, shadowRow, ROW_BYTES) == 0) continue;
+
+    int runStart = -1;
+    for (uint8_t tx = 0; tx < TILE_COLS; tx++) {
+      bool dirty = full || memcmp(row + tx * 8, shadowRow + tx * 8, 8) != 0;
+      if (dirty && runStart < 0) {
+        runStart = tx;
+      } else if (!dirty && runStart >= 0) {
+        sendRun(frame, runStart, ty, tx - runStart);
+        runStart = -1;
+      }
+    }
+    if (runStart >= 0) sendRun(frame, runStart, ty, TILE_COLS - runStart);
+  }
+
+  if (stats.lastFrameTiles == 0) {
+    stats.framesSkipped++;
+  } else {
+    stats.paintUs = firstTileUs;
+    stats.paintSeq = f.seq; // last: loop() reads paintSeq first (see trace.cpp)
+  }
+  stats.bytesSent += stats.lastFrameBytes;
+  stats.lastTransferUs = micros() - t0;
+  stats.transferUs += stats.lastTransferUs;
+}
+
+// Sends whatever is newest until nothing new is left
+static void drainFrames() {
+  sending.store(true);
+  while (const Frame* f = frames.take()) sendFrame(*f);
+  if (!panelOn) {
+    disp->setPowerSave(0);
+    panelOn = true;
+  }
+  sending.store(false);
+}
+
+static void displayTask(void*) {
+  disp->initDisplay(); // flushes from before this wait in the triple buffer
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    drainFrames();
+  }
+}
+
+void displayBegin(U8G2& display) {
+  disp = &display;
+  // Display RAM holds whatever it held, so the first frame goes out whole
+  memset(shadow, 0, sizeof(shadow));
+  forceFull.store(true);
+  panelOn = false;
+
+  // Without the task every flush is sent inline, like sendBuffer() was
+  if (!task && xTaskCreate(displayTask, "display", DISPLAY_TASK_STACK, nullptr, DISPLAY_TASK_PRIO, &task) != pdPASS) {
+    task = nullptr;
+    disp->initDisplay();
+  }
+}
+
+void displayInvalidate() {
+  forceFull.store(true);
+  lastFlushed = nullptr; // a hit on it has to go out again
+}
+
+static void flushFrom(const uint8_t* px) {
+  PROFILE_SCOPE(PROF_DISPLAY_FLUSH);
+
+  uint32_t t0 = micros();
+  memcpy(frames.back().px, px, FRAME_BYTES);
+  frames.back().seq = ++stats.frames;
+  if (frames.publish()) stats.framesDropped++;
+
+  if (task) xTaskNotifyGive(task);
+  else drainFrames();
+  stats.blockedUs += micros() - t0;
+}
+
+void displayFlush() {
+  if (!disp) return;
+  lastFlushed = nullptr;
+  flushFrom(disp->getBufferPtr());
+}
+
+static bool sameKey(const DisplayKey& a, const DisplayKey& b) {
+  return a.msg[0] == b.msg[0] && a.msg[1] == b.msg[1] && a.msg[2] == b.msg[2] && a.variant == b.variant;
+}
+
+static CachedFrame* cacheFind(const DisplayKey& key) {
+  for (uint8_t i = 0; i < CACHE_SLOTS; i++) {
+    if (sameKey(cache[i].key, key)) return &cache[i];
+  }
+  return nullptr;
+}
+
+bool displayShowCached(const void* key, uint8_t variant) {
+  return displayShowCached(DisplayKey{ { key }, variant });
+}
+
+bool displayShowCached(const DisplayKey& key) {
+  if (!disp) return false;
+  CachedFrame* c = cacheFind(key);
+  if (!c) {
+    stats.cacheMisses++;
+    missKey = key;
+    missUs = micros();
+    return false;
+  }
+
+  c->lastUse = ++cacheClock;
+  stats.cacheHits++;
+  stats.cacheSavedUs += c->renderUs;
+  // Screens redrawn every pass repeat the frame they just flushed, which the
+  // display task would only find unchanged
+  if (lastFlushed != c) {
+    flushFrom(c->px);
+    lastFlushed = c;
+  }
+  return true;
+}
+
+void displayFlushCached(const void* key, uint8_t variant) {
+  displayFlushCached(DisplayKey{ { key }, variant });
+}
+
+void displayFlushCached(const DisplayKey& key) {
+  if (!disp) return;
+  uint32_t renderUs = missKey.msg[0] && sameKey(key, missKey) ? micros() - missUs : 0;
+  missKey = {};
+  displayFlush();
+  if (CACHE_SLOTS == 0) return;
+
+  CachedFrame* c = cacheFind(key);
+  for (uint8_t i = 0; !c && i < CACHE_SLOTS; i++) {
+    if (!cache[i].key.msg[0]) c = &cache[i];
+  }
+  if (!c) {
+    c = &cache[0];
+    for (uint8_t i = 1; i < CACHE_SLOTS; i++) {
+      if (cache[i].lastUse < c->lastUse) c = &cache[i];
+    }
+  }
+  c->key = key;
+  c->lastUse = ++cacheClock;
+  c->renderUs = renderUs;
+  memcpy(c->px, disp->getBufferPtr(), FRAME_BYTES);
+  lastFlushed = c;
+}
+
+void displaySync() {
+  uint32_t t0 = micros();
+  while (displayBusy()) vTaskDelay(1);
+  stats.blockedUs += micros() - t0;
+}
+
+bool displayBusy() {
+  return task && (frames.pending() || sending.load());
+}
+
+const DisplayStats& displayStats() {
+  return stats;
+}
+
+void displayResetStats() {
+  memset(&stats, 0, sizeof(stats));
+}
+
+void displayPrintStats(Print& out) {
+  const struct { const char* name; uint32_t value; } rows[] = {
+    { "frames", stats.frames },
+    { "frames_dropped", stats.framesDropped },
+    { "frames_skipped", stats.framesSkipped },
+    { "tiles_sent", stats.tilesSent },
+    { "bytes_sent", stats.bytesSent },
+    { "bytes_full", stats.bytesFull },
+    { "transfer_us", stats.transferUs },
+    { "last_transfer_us", stats.lastTransferUs },
+    { "blocked_us", stats.blockedUs },
+    { "cache_hits", stats.cacheHits },
+    { "cache_misses", stats.cacheMisses },
+    { "cache_hit_pct", stats.cacheHits ? stats.cacheHits * 100 / (stats.cacheHits + stats.cacheMisses) : 0 },
+    { "cache_saved_us", stats.cacheSavedUs },
+  };
+  for (const auto& r : rows) {
+    out.print(r.name);
+    out.print(',');
+    out.println(r.value);
+  }
+}
@@ -0,0 +1,111 @@
+#include "font.h"
+#include "font_data.h"
+
+// Byte offsets in the u8g2 font header (u8g2_read_font_info())
+#define HDR_BITS_PER_0     2
+#define HDR_BITS_PER_1     3
+#define HDR_BITS_PER_W     4
+#define HDR_BITS_PER_H     5
+#define HDR_BITS_PER_X     6
+#define HDR_BITS_PER_Y     7
+#define HDR_BITS_PER_DX    8
+#define GLYPH_HEADER_BYTES 2 // encoding, size of the entry
+
+// LSB-first reader, as u8g2_font_decode_get_unsigned_bits()
+struct GlyphBits {
+  const uint8_t* p;
+  uint8_t pos;
+
+  uint8_t get(uint8_t n) {
+    uint8_t v = *p >> pos;
+    uint8_t end = pos + n;
+    if (end >= 8) {
+      p++;
+      v |= *p << (8 - pos);
+      end -= 8;
+    }
+    pos = end;
+    return v & ((1u << n) - 1);
+  }
+
+  int8_t getSigned(uint8_t n) {
+    return (int8_t)get(n) - (int8_t)(1 << (n - 1));
+  }
+};
+
+const SubsetFont* fontFind(const uint8_t* data) {
+  for (const SubsetFont& f : FONTS) {
+    if (f.data == data) return &f;
+  }
+  return nullptr;
+}
+
+u8g2_uint_t fontDrawGlyph(U8G2& display, const SubsetFont& font, u8g2_uint_t x, u8g2_uint_t y, uint8_t c) {
+  u8g2_t* u = display.getU8g2();
+  if (u->font_decode.dir != 0) return display.drawGlyph(x, y, c);
+
+  uint8_t i = c - font.first;
+  if (i >= font.count || !font.index[i]) return 0; // u8g2 draws nothing either
+  const uint8_t* hdr = font.data;
+  GlyphBits in = { font.data + font.index[i] + GLYPH_HEADER_BYTES, 0 };
+
+  uint8_t w = in.get(hdr[HDR_BITS_PER_W]);
+  uint8_t h = in.get(hdr[HDR_BITS_PER_H]);
+  int8_t gx = in.getSigned(hdr[HDR_BITS_PER_X]);
+  int8_t gy = in.getSigned(hdr[HDR_BITS_PER_Y]);
+  int8_t dx = in.getSigned(hdr[HDR_BITS_PER_DX]);
+  if (w == 0) return dx;
+
+  // Top left of the glyph box, from the reference point drawGlyph() uses
+  y += u->font_calc_vref(u);
+  u8g2_uint_t left = x + gx;
+  u8g2_uint_t top = y - (h + gy);
+
+  uint8_t fg = u->draw_color;
+  uint8_t bg = fg == 0 ? 1 : 0;
+  bool solid = !u->font_decode.is_transparent;
+  uint8_t bits0 = hdr[HDR_BITS_PER_0];
+  uint8_t bits1 = hdr[HDR_BITS_PER_1];
+
+  // Runs of 0s then 1s in scan order, each pair repeated while the next
+  // bit is 1 (u8g2_font_decode_glyph() and u8g2_font_decode_len())
+  uint8_t lx = 0, ly = 0;
+  for (;;) {
+    uint8_t run[2];
+    run[0] = in.get(bits0);
+    run[1] = in.get(bits1);
+    do {
+      for (uint8_t color = 0; color < 2; color++) {
+        uint8_t cnt = run[color];
+        for (;;) {
+          uint8_t rem = w - lx;
+          uint8_t cur = cnt < rem ? cnt : rem;
+          if (color || solid) {
+            u->draw_color = color ? fg : bg;
+            u8g2_DrawHVLine(u, left + lx, top + ly, cur, 0);
+          }
+          if (cnt < rem) break;
+          cnt -= rem;
+          lx = 0;
+          ly++;
+        }
+        lx += cnt;
+      }
+    } while (in.get(1));
+    if (ly >= h) break;
+  }
+  u->draw_color = fg;
+  return dx;
+}
+
+void fontPrintStats(Print& out) {
+  out.println("name,glyphs,full_bytes,subset_bytes");
+  uint32_t full = 0, subset = 0;
+  for (const SubsetFont& f : FONTS) {
+    out.printf("%s,%u,%u,%u\n", f.name, f.data[0], f.fullSize, f.size);
+    full += f.fullSize;
+    subset += f.size;
+  }
+  out.print("flash_saved,");
+  out.println(full - subset);
+}
@@ -0,0 +1,109 @@
+#include "idle_sleep.h"
+#include "driver/gpio.h"
+#include "esp_sleep.h"
+
+static uint8_t pins[2];
+static IdleStats perState[IDLE_STATES] = {};
+static uint32_t passStartUs = 0;
+
+void idleBegin(uint8_t yesPin, uint8_t noPin) {
+  pins[0] = yesPin;
+  pins[1] = noPin;
+  esp_sleep_enable_gpio_wakeup();
+  passStartUs = micros();
+}
+
+// Light sleep only has level wakeups: wake on the level each button isn't
+// at now, so a held button wakes on release instead of straight away. The
+// pin's interrupt is masked first: a level interrupt can't be cleared while
+// the button stays down, so once interrupts came back on at wakeup it would
+// run buttons.cpp's ISR over and over, fill the edge ring and lose the
+// release. The wakeup itself doesn't need the interrupt enabled.
+static void armButtons() {
+  for (uint8_t pin : pins) {
+    gpio_intr_disable((gpio_num_t)pin);
+    gpio_wakeup_enable((gpio_num_t)pin, digitalRead(pin) == LOW ? GPIO_INTR_HIGH_LEVEL : GPIO_INTR_LOW_LEVEL);
+  }
+}
+
+// gpio_wakeup_enable() set the pins' interrupt type to that level too: back
+// to buttons.cpp's CHANGE edges before the interrupt is unmasked. The edge
+// that woke the chip never reached the ring; buttonsPoll() catches it up
+// from the live level on the pass that follows.
+static void disarmButtons() {
+  for (uint8_t pin : pins) {
+    gpio_wakeup_disable((gpio_num_t)pin);
+    gpio_set_intr_type((gpio_num_t)pin, GPIO_INTR_ANYEDGE);
+    gpio_intr_enable((gpio_num_t)pin);
+  }
+}
+
+void idleWait(uint32_t ms, uint8_t state, bool busy) {
+  static IdleStats ignored;
+  IdleStats& s = state < IDLE_STATES ? perState[state] : ignored;
+  uint32_t startUs = micros();
+  uint32_t waitUs = ms * 1000;
+  s.activeUs += startUs - passStartUs;
+
+  if (waitUs < IDLE_SLEEP_MIN_US) {
+    delay(ms);
+  } else if (busy || Serial) {
+    s.awake++;
+    delay(ms);
+  } else {
+    armButtons();
+    esp_sleep_enable_timer_wakeup(waitUs - IDLE_WAKE_MARGIN_US);
+    esp_light_sleep_start();
+    disarmButtons();
+    uint32_t wokeUs = micros();
+    s.sleptUs += wokeUs - startUs;
+    s.sleeps++;
+
+    // A press goes straight to the next pass, the timer spins out its margin
+    if (esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_GPIO) {
+      int32_t left = startUs + waitUs - wokeUs;
+      if (left > 0) delayMicroseconds(left);
+      else if ((uint32_t)-left > s.lateMaxUs) s.lateMaxUs = -left;
+    }
+  }
+
+  passStartUs = micros();
+  s.waitUs += passStartUs - startUs;
+}
+
+void idleStop() {
+  esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_TIMER);
+}
+
+const IdleStats& idleStats(uint8_t state) {
+  return perState[state];
+}
+
+static unsigned long permille(uint64_t part, uint64_t whole) {
+  return whole ? (unsigned long)(part * 1000 / whole) : 0;
+}
+
+void idlePrintStats(Print& out, const char* const* stateNames, uint8_t stateCount) {
+  out.println("state,seconds,active_pct,sleep_pct,sleeps,awake_waits,late_max_us");
+  uint64_t totalUs = 0;
+  uint64_t totalActiveUs = 0;
+  uint64_t totalSleptUs = 0;
+  for (uint8_t i = 0; i < stateCount && i < IDLE_STATES; i++) {
+    const IdleStats& s = perState[i];
+    uint64_t us = s.activeUs + s.waitUs;
+    totalUs += us;
+    totalActiveUs += s.activeUs;
+    totalSleptUs += s.sleptUs;
+    if (!us) continue;
+    unsigned long active = permille(s.activeUs, us);
+    unsigned long slept = permille(s.sleptUs, us);
+    out.printf("%s,%lu.%03lu,%lu.%lu,%lu.%lu,%lu,%lu,%lu\n", stateNames[i],
+               (unsigned long)(us / 1000000), (unsigned long)(us / 1000 % 1000),
+               active / 10, active % 10, slept / 10, slept % 10,
+               (unsigned long)s.sleeps, (unsigned long)s.awake, (unsigned long)s.lateMaxUs);
+  }
+  unsigned long active = permille(totalActiveUs, totalUs);
+  unsigned long slept = permille(totalSleptUs, totalUs);
+  out.printf("# total_active_pct,%lu.%lu\n", active / 10, active % 10);
+  out.printf("# total_sleep_pct,%lu.%lu\n", slept / 10, slept % 10);
+}
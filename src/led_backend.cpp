@@ -0,0 +1,111 @@
+#include "led_backend.h"
+
+#ifdef ESP_PLATFORM
+#include <driver/rmt.h>
+static_assert(sizeof(LedSymbol) == sizeof(rmt_item32_t), "LedSymbol must match rmt_item32_t");
+#endif
+
+static constexpr LedSymbol SYMBOL_0 = LedSymbol::make(LED_T0H, LED_T0L);
+static constexpr LedSymbol SYMBOL_1 = LedSymbol::make(LED_T1H, LED_T1L);
+
+size_t ledEncode(const uint8_t* src, size_t srcBytes, LedSymbol* dst, size_t maxSymbols, size_t* consumed) {
+  size_t n = 0, i = 0;
+  while (i < srcBytes && n + 8 <= maxSymbols) {
+    uint8_t b = src[i++];
+    for (uint8_t bit = 0; bit < 8; bit++, b <<= 1) {
+      dst[n++] = (b & 0x80) ? SYMBOL_1 : SYMBOL_0;
+    }
+  }
+  *consumed = i;
+  return n;
+}
+
+static bool within(uint16_t ticks, uint16_t nominal) {
+  int diffNs = ((int)ticks - (int)nominal) * LED_TICK_NS;
+  return diffNs <= LED_TOLERANCE_NS && diffNs >= -LED_TOLERANCE_NS;
+}
+
+LedDecodeResult ledDecode(const LedSymbol* symbols, size_t count, uint8_t* out, size_t maxBytes) {
+  LedDecodeResult r = { 0, 0 };
+  uint8_t b = 0;
+  for (size_t i = 0; i < count && r.bytes < maxBytes; i++) {
+    const LedSymbol& s = symbols[i];
+    bool one = within(s.duration0(), LED_T1H) && within(s.duration1(), LED_T1L);
+    bool zero = within(s.duration0(), LED_T0H) && within(s.duration1(), LED_T0L);
+    if (s.level0() != 1 || s.level1() != 0 || one == zero) r.timingErrors++;
+
+    // Classify by the high time, like the LED's own sampling point does
+    b = (b << 1) | (s.duration0() * LED_TICK_NS > 600);
+    if ((i & 7) == 7) out[r.bytes++] = b;
+  }
+  return r;
+}
+
+// ---- capture backend ----
+void CaptureLedBackend::send(const uint8_t* grb, uint16_t bytes) {
+  if (bytes > maxBytes) bytes = maxBytes;
+
+  uint32_t startUs = micros();
+  if (captured.frames && (int32_t)(startUs - lastEndUs) < LED_RESET_US) captured.gapErrors++; // also still sending
+
+  size_t n = 0, done = 0;
+  while (done < bytes) {
+    size_t used;
+    n += ledEncode(grb + done, bytes - done, symbols + n, chunk, &used);
+    if (!used) break; // a chunk under one byte's 8 symbols never gets anywhere
+    done += used;
+  }
+
+  LedDecodeResult r = ledDecode(symbols, n, decoded, maxBytes);
+  lastBytes = r.bytes;
+  captured.frames++;
+  captured.symbols += n;
+  captured.timingErrors += r.timingErrors;
+  if (r.bytes != bytes || memcmp(decoded, grb, bytes) != 0) captured.mismatches++;
+
+  // When the last bit would have left the wire
+  lastEndUs = startUs + (uint32_t)n * (LED_T0H + LED_T0L) * LED_TICK_NS / 1000;
+}
+
+#ifdef ESP_PLATFORM
+// ---- RMT backend ----
+// Called by the RMT driver (also from its ISR) to refill the channel memory
+static void rmtTranslate(const void* src, rmt_item32_t* dest, size_t srcSize, size_t wantedNum,
+                         size_t* translatedSize, size_t* itemNum) {
+  *itemNum = ledEncode((const uint8_t*)src, srcSize, (LedSymbol*)dest, wantedNum, translatedSize);
+}
+
+void RmtLedBackend::begin(uint16_t maxBytes) {
+  if (!tx) {
+    rmt_config_t cfg = RMT_DEFAULT_CONFIG_TX((gpio_num_t)pin, (rmt_channel_t)channel);
+    cfg.clk_div = LED_RMT_CLK_DIV;
+    rmt_config(&cfg);
+    rmt_driver_install((rmt_channel_t)channel, 0, 0);
+    rmt_translator_init((rmt_channel_t)channel, rmtTranslate);
+  }
+  if (maxBytes > capacity) {
+    delete[] tx;
+    tx = new uint8_t[maxBytes];
+    capacity = maxBytes;
+  }
+}
+
+bool RmtLedBackend::busy() {
+  return rmt_wait_tx_done((rmt_channel_t)channel, 0) != ESP_OK;
+}
+
+void RmtLedBackend::send(const uint8_t* grb, uint16_t bytes) {
+  if (bytes > capacity) bytes = capacity;
+
+  // The driver streams from tx while it sends, so the last frame has to be
+  // out (plus the latch gap) before tx can be reused. At the refresh target
+  // this never actually waits.
+  rmt_wait_tx_done((rmt_channel_t)channel, pdMS_TO_TICKS(50));
+  int32_t gap = (int32_t)(idleAtUs - micros());
+  if (gap > 0) delayMicroseconds(gap);
+
+  memcpy(tx, grb, bytes);
+  rmt_write_sample((rmt_channel_t)channel, tx, bytes, false);
+  idleAtUs = micros() + bytes * 8 * (LED_T0H + LED_T0L) * LED_TICK_NS / 1000 + LED_RESET_US;
+}
+#endif
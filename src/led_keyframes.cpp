@@ -0,0 +1,133 @@
+#include "led_keyframes.h"
+#include "led_math.h"
+#include "color.h"
+
+#define OWNED 0x01000000UL // above the packed colour: a track set this pixel
+
+static uint8_t clamp8(int16_t v) {
+  return v < 0 ? 0 : v > 255 ? 255 : v;
+}
+
+// Eased share of the way from one key to the next, Q16 in and out
+static uint32_t ease(Ease curve, uint32_t x) {
+  switch (curve) {
+    case EASE_STEP:   return 0;
+    case EASE_SINE:   return 32768 - sinQ15((x << 15) + 0x40000000); // -cos(pi x) / 2, shifted up
+    case EASE_IN:     return (x * x) >> 16;
+    case EASE_OUT:    return 65536 - (uint32_t)(((uint64_t)(65536 - x) * (65536 - x)) >> 16);
+    case EASE_LINEAR:
+    default:          return x;
+  }
+}
+
+ClipPlayer::ClipPlayer(Adafruit_NeoPixel* const* strips, const uint16_t* pixels, uint8_t stripCount)
+  : strips(strips), stripCount(min(stripCount, (uint8_t)CLIP_MAX_STRIPS)) {
+  for (uint8_t s = 0; s < this->stripCount; s++) this->pixels[s] = pixels[s];
+}
+
+void ClipPlayer::begin() {
+  if (frame) return;
+  uint32_t total = 0;
+  for (uint8_t s = 0; s < stripCount; s++) total += pixels[s];
+  frame = new uint32_t[total];
+  uint32_t* at = frame;
+  for (uint8_t s = 0; s < stripCount; s++) {
+    rgb[s] = at;
+    at += pixels[s];
+  }
+}
+
+void ClipPlayer::play(const Clip* next, unsigned long now) {
+  if (next == clip) return;
+  clip = next;
+  startMs = now;
+  memset(cursors, 0, sizeof(cursors));
+}
+
+bool ClipPlayer::done(unsigned long now) const {
+  if (!clip) return true;
+  if (clip->flags & CLIP_LOOP) return false;
+  return now - startMs >= (uint32_t)clip->lengthMs + clip->blendOutMs;
+}
+
+// Value at clip time t. cursor is the last key at or before t (0 before the
+// first one) and only moves as far as t moved since the previous call.
+int16_t ClipPlayer::sample(const Track& track, int32_t t, uint8_t& cursor) const {
+  const Key* keys = track.keys;
+  uint8_t c = cursor < track.keyCount ? cursor : 0;
+  while (c + 1 < track.keyCount && t >= keys[c + 1].ms) c++;
+  while (c > 0 && t < keys[c].ms) c--;
+  cursor = c;
+
+  if (t < keys[c].ms) return 0; // before the first key
+  if (c + 1 >= track.keyCount) return keys[c].value;
+  const Key& a = keys[c];
+  const Key& b = keys[c + 1];
+  uint32_t x = ((uint32_t)(t - a.ms) << 16) / (b.ms - a.ms);
+  int32_t d = b.value - a.value;
+  return a.value + (int16_t)((d * (int32_t)ease(b.ease, x) + 32768) >> 16);
+}
+
+void ClipPlayer::apply(unsigned long now) {
+  if (!clip || !frame) return;
+  bool looping = clip->flags & CLIP_LOOP;
+
+  int32_t base = 0;
+  uint32_t live = 0; // Q16 share of the frame underneath, while blending out
+  if (!looping) {
+    uint32_t len = clip->lengthMs;
+    uint32_t elapsed = now - startMs;
+    if (elapsed >= len && clip->blendOutMs) {
+      if (elapsed >= len + clip->blendOutMs) {
+        clip = nullptr;
+        return;
+      }
+      live = ((elapsed - len) << 16) / clip->blendOutMs;
+    }
+    base = min(elapsed, len);
+  }
+
+  for (uint8_t s = 0; s < stripCount; s++) memset(rgb[s], 0, pixels[s] * sizeof(uint32_t));
+
+  uint8_t tracks = min(clip->trackCount, (uint8_t)CLIP_MAX_TRACKS);
+  for (uint8_t i = 0; i < tracks; i++) {
+    const Track& tr = clip->tracks[i];
+    if (tr.strip >= stripCount) continue;
+
+    uint8_t cursor = cursors[i];
+    int32_t period = tr.keys[tr.keyCount - 1].ms;
+    if (looping && period) base = now % period;
+
+    uint16_t count = tr.channel == CH_BRIGHTNESS ? 1 : tr.count;
+    for (uint16_t k = 0; k < count; k++) {
+      int32_t t = base + tr.phaseMs - (int32_t)k * tr.staggerMs;
+      if (looping) {
+        t = period ? t % period : 0;
+        if (t < 0) t += period;
+      }
+      // Neighbouring pixels sit on the same or the next key pair, so each
+      // one starts from the cursor the one before it left
+      uint8_t v = clamp8(sample(tr, t, cursor));
+      if (k == 0) cursors[i] = cursor;
+
+      if (tr.channel == CH_BRIGHTNESS) {
+        strips[tr.strip]->setBrightness(v);
+        break;
+      }
+      uint16_t p = tr.first + k;
+      if (p >= pixels[tr.strip]) break;
+      uint8_t shift = 16 - 8 * tr.channel;
+      rgb[tr.strip][p] = (rgb[tr.strip][p] & ~(0xFFUL << shift)) | (uint32_t)v << shift | OWNED;
+    }
+  }
+
+  for (uint8_t s = 0; s < stripCount; s++) {
+    for (uint16_t p = 0; p < pixels[s]; p++) {
+      uint32_t c = rgb[s][p];
+      if (!(c & OWNED)) continue;
+      c &= ~OWNED;
+      if (live) c = colorLerp(c, strips[s]->getPixelColor(p), live >> 8);
+      strips[s]->setPixelColor(p, c);
+    }
+  }
+}
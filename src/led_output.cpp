@@ -0,0 +1,107 @@
+#include "led_output.h"
+#include "color.h"
+
+LedOutput::LedOutput(Adafruit_NeoPixel& strip, LedBackend& backend, uint16_t activeCount, uint16_t refreshHz,
+                     uint8_t bytesPerPixel)
+  : strip(strip), backend(backend), activeCount(activeCount), bytes(activeCount * bytesPerPixel),
+    intervalMs(refreshHz ? 1000 / refreshHz : 0) {}
+
+void LedOutput::begin() {
+  uint16_t bytesPerPixel = bytes / activeCount;
+  if (!physicalCount) {
+    // Once: a second strip.begin() would take the pin back from the RMT
+    physicalCount = strip.numPixels();
+    sent = new uint8_t[bytes];
+    strip.begin();
+    backend.begin(physicalCount * bytesPerPixel);
+
+    strip.clear();
+    backend.send(strip.getPixels(), physicalCount * bytesPerPixel);
+
+    // The tail keeps the black it just latched; from here on only the active
+    // pixels are clocked out
+    strip.updateLength(activeCount);
+  } else {
+    // Resets after that only blank the active pixels: updateLength() frees
+    // and mallocs the pixel buffer every time
+    strip.clear();
+    backend.send(strip.getPixels(), bytes);
+  }
+
+  memset(sent, 0, bytes);
+  lastShowMs = millis();
+}
+
+bool LedOutput::changed() const {
+  return limitScale != sentScale || memcmp(strip.getPixels(), sent, bytes) != 0;
+}
+
+uint32_t LedOutput::channelSum() const {
+  const uint8_t* px = strip.getPixels();
+  uint32_t sum = 0;
+  for (uint16_t i = 0; i < bytes; i++) sum += px[i];
+  return sum;
+}
+
+void LedOutput::send(unsigned long now) {
+  uint8_t* px = strip.getPixels();
+  memcpy(sent, px, bytes);
+  sentScale = limitScale;
+
+  uint32_t t0 = micros();
+  {
+    PROFILE_SCOPE(profileId);
+    // Scaled in place for the send (Adafruit's show() only reads the strip's
+    // own buffer), then put back from the copy
+    if (limitScale < 256) colorScaleBuffer(px, bytes, limitScale);
+    backend.send(px, bytes);
+    if (limitScale < 256) memcpy(px, sent, bytes);
+  }
+  uint32_t us = micros() - t0;
+
+  lastShowMs = now;
+  window.shows++;
+  window.showUs += us;
+  all.shows++;
+  all.showUs += us;
+}
+
+void LedOutput::roll(unsigned long now) {
+  if (now - windowStart < 1000) return;
+  done = window;
+  window = {};
+  windowStart = now;
+}
+
+bool LedOutput::update(unsigned long now) {
+  roll(now);
+
+  if (!changed()) {
+    window.unchanged++;
+    all.unchanged++;
+    return false;
+  }
+  if (now - lastShowMs < intervalMs) {
+    window.deferred++;
+    all.deferred++;
+    return false;
+  }
+  send(now);
+  return true;
+}
+
+void LedOutput::showNow() {
+  if (changed()) send(millis());
+}
+
+void LedOutput::printStats(Print& out, const char* name) const {
+  out.print(name);
+  out.print(',');
+  out.print(done.shows);
+  out.print(',');
+  out.print(done.showUs);
+  out.print(',');
+  out.print(done.unchanged);
+  out.print(',');
+  out.println(done.deferred);
+}
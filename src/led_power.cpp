@@ -0,0 +1,62 @@
+#include "led_power.h"
+
+uint32_t ledFrameUa(uint32_t channelSum) {
+  // 64-bit product: 300 white pixels are already 229500 * 20000
+  return (uint32_t)((uint64_t)channelSum * LED_CHANNEL_FULL_UA / 255);
+}
+
+uint16_t ledBudgetScale(uint32_t dynamicUa, uint32_t idleUa, uint32_t budgetUa) {
+  if (idleUa >= budgetUa) return 0;
+  uint32_t room = budgetUa - idleUa;
+  if (dynamicUa <= room) return 256;
+  // Rounded down: the bytes get floored again in colorScale(), so the frame
+  // that goes out is never over
+  return (uint16_t)(((uint64_t)room << 8) / dynamicUa);
+}
+
+LedPowerBudget::LedPowerBudget(LedOutput* const* outputs, uint8_t count, uint16_t budgetMa)
+  : outputs(outputs), count(min(count, (uint8_t)LED_POWER_OUTPUTS)), budgetUa((uint32_t)budgetMa * 1000) {}
+
+void LedPowerBudget::update(unsigned long now, uint8_t state) {
+  // The last frame's draw lasted until now
+  if (started && lastState < LED_POWER_STATES) {
+    uint32_t dt = now - lastMs;
+    LedPowerStats& s = perState[lastState];
+    s.uaMs += (uint64_t)lastUa * dt;
+    s.ms += dt;
+    if (lastUa > s.peakUa) s.peakUa = lastUa;
+    if (scale < 256) s.limitedMs += dt;
+  }
+
+  uint32_t dynamicUa = 0;
+  uint32_t idleUa = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    dynamicUa += ledFrameUa(outputs[i]->channelSum());
+    idleUa += (uint32_t)outputs[i]->physicalPixels() * LED_IDLE_UA;
+  }
+  scale = ledBudgetScale(dynamicUa, idleUa, budgetUa);
+  for (uint8_t i = 0; i < count; i++) outputs[i]->limit(scale);
+
+  lastUa = (uint32_t)(((uint64_t)dynamicUa * scale) >> 8) + idleUa;
+  lastState = state;
+  lastMs = now;
+  started = true;
+}
+
+void LedPowerBudget::printStats(Print& out, const char* const* stateNames, uint8_t stateCount) const {
+  out.println("state,seconds,uah,avg_ma,peak_ma,limited_s");
+  uint64_t totalUaMs = 0;
+  for (uint8_t i = 0; i < stateCount && i < LED_POWER_STATES; i++) {
+    const LedPowerStats& s = perState[i];
+    totalUaMs += s.uaMs;
+    if (!s.ms) continue;
+    out.printf("%s,%lu.%03lu,%lu,%lu.%lu,%lu.%lu,%lu.%03lu\n", stateNames[i],
+               (unsigned long)(s.ms / 1000), (unsigned long)(s.ms % 1000),
+               (unsigned long)(s.uaMs / 3600000),
+               (unsigned long)(s.uaMs / s.ms / 1000), (unsigned long)(s.uaMs / s.ms % 1000 / 100),
+               (unsigned long)(s.peakUa / 1000), (unsigned long)(s.peakUa % 1000 / 100),
+               (unsigned long)(s.limitedMs / 1000), (unsigned long)(s.limitedMs % 1000));
+  }
+  out.print("# total_uah,");
+  out.println((unsigned long)(totalUaMs / 3600000));
+}
@@ -2,14 +2,40 @@
 #include <Wire.h>
 #include <U8g2lib.h>
 #include "esp_sleep.h"
+#include "display.h"
+#include "led_math.h"
+#include "scene.h"
+#include "buttons.h"
+#include "text.h"
+#include "font.h"
+#include "bitmap.h"
+#include "led_output.h"
+#include "led_power.h"
+#include "led_backend.h"
+#include "led_keyframes.h"
+#include "led_layout.h"
+#include "color.h"
+#include "profiler.h"
+#include "bench.h"
+#include "trace.h"
+#include "timer_wheel.h"
+#include "idle_sleep.h"
+#include "app_state.h"
 
 // ================= OLED =================
 U8G2_SSD1306_128X64_NONAME_F_HW_I2C u8g2(U8G2_R0, U8X8_PIN_NONE);
 
 // ================= HARDWARE SETTINGS =================
-#define PHYSICAL_LED_COUNT 30 
-#define ACTIVE_LED_COUNT   9 
-#define BUTTON_LED_COUNT   3
+// Strip shapes (led_layout.h). Body: 30 pixels on the chain, the first 9
+// lit, the candle breathing 40 ms later on each. Buttons: RED, pink, GREEN.
+// -DBODY_300 (envs bench_300 and native_bench_300) builds the whole LED
+// path for a 300-pixel body in three segments instead, to measure it.
+#ifdef BODY_300
+using BodyLayout = StripLayout<300, Segment<100, 40>, Segment<100, 40, 20>, Segment<100, 40>>;
+#else
+using BodyLayout = StripLayout<30, Segment<9, 40>>;
+#endif
+using ButtonLayout = StripLayout<3, Segment<3>>;
 
 // PINS
 #define BUTTON_STRIP_PIN D9
@@ -17,34 +43,45 @@ U8G2_SSD1306_128X64_NONAME_F_HW_I2C u8g2(U8G2_R0, U8X8_PIN_NONE);
 #define BTN_YES_PIN      D1
 #define BTN_NO_PIN       D2
 #define BTN_YES_GPIO     GPIO_NUM_3 
+#define BTN_NO_GPIO      GPIO_NUM_4 // D2; both can wake it (GPIO0-5 only on the C3)
 
-Adafruit_NeoPixel buttonStrip(BUTTON_LED_COUNT, BUTTON_STRIP_PIN, NEO_GRB + NEO_KHZ800);
-Adafruit_NeoPixel bodyStrip(PHYSICAL_LED_COUNT, BODY_STRIP_PIN, NEO_GRB + NEO_KHZ800);
+Adafruit_NeoPixel buttonStrip(ButtonLayout::physical, BUTTON_STRIP_PIN, NEO_GRB + NEO_KHZ800);
+Adafruit_NeoPixel bodyStrip(BodyLayout::physical, BODY_STRIP_PIN, NEO_GRB + NEO_KHZ800);
 
 // ================= TIMING =================
 #define INACTIVITY_TIMEOUT   180000UL // 3min Sleep
 #define CELEBRATION_DURATION 10000UL // 10s Love then Reset
 #define DEBOUNCE_DELAY       50
+#define LED_REFRESH_HZ       60 // cap on show() rate per strip, 0 = every loop pass
+#define LED_BUDGET_MA        200 // both strips together; brighter frames get dimmed (led_power.h)
+
+// Both strips stream from the RMT in the background, one TX channel each.
+// Build with -DLED_BACKEND_NEOPIXEL to go back to Adafruit's blocking show().
+#if defined(ESP_PLATFORM) && !defined(LED_BACKEND_NEOPIXEL)
+RmtLedBackend buttonTx(BUTTON_STRIP_PIN, 0);
+RmtLedBackend bodyTx(BODY_STRIP_PIN, 1);
+#else
+NeoPixelShowBackend buttonTx(buttonStrip);
+NeoPixelShowBackend bodyTx(bodyStrip);
+#endif
+
+// Strips are only sent from loop(), when their pixels actually changed
+LedOutput buttonOut(buttonStrip, buttonTx, ButtonLayout::active, LED_REFRESH_HZ);
+LedOutput bodyOut(bodyStrip, bodyTx, BodyLayout::active, LED_REFRESH_HZ);
+
+LedOutput* const LED_OUTPUTS[] = { &bodyOut, &buttonOut };
+LedPowerBudget ledPower(LED_OUTPUTS, 2, LED_BUDGET_MA);
 
 // ================= BITMAP DATA =================
-static const unsigned char image_cards_hearts_bits[] U8X8_PROGMEM = {0x00,0x00,0x00,0x00,0x1c,0x1c,0x3e,0x3e,0x7f,0x7f,0xff,0x7f,0xff,0x7f,0xff,0x7f,0xfe,0x3f,0xfc,0x1f,0xf8,0x0f,0xf0,0x07,0xe0,0x03,0xc0,0x01,0x80,0x00,0x00,0x00};
-
-static const unsigned char image_BLE_Pairing_bits[] U8X8_PROGMEM = {0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x0e,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x80,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x40,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x20,0x00,0x08,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x20,0x00,0x30,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x10,0x00,0xc0,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x10,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x08,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x08,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x58,0x01,0x3c,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x80,0xaf,0x0a,0xdc,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x60,0xf0,0x17,0xf8,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x10,0x00,0x3c,0xf0,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x08,0x00,0xe0,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x08,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0xe4,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x14,0x0e,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x0c,0x30,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x08,0xc0,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x10,0x00,0x03,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x20,0x00,0x1c,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x40,0x00,0xe0,0x43,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x80,0x01,0x00,0x38,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x26,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x58,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0xf0,0x2a,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0xe0,0x55,0x01,0x00,0x00,0xff,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x80,0xbf,0x32,0x00,0xe0,0x00,0x7e,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0xc0,0xff,0x07,0x00,0x10,0x00,0x80,0xff,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0xf0,0xff,0x03,0x00,0x0c,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x5c,0xff,0x00,0x00,0x03,0x00,0x00,0x00,0x02,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0xab,0x5e,0x00,0xc0,0x00,0x00,0x00,0x00,0x0c,0x00,0x00,0x00,0x00,0x00,0x00,0xc0,0x54,0x28,0x00,0x30,0x00,0x00,0x00,0x00,0x30,0x00,0x00,0x00,0x00,0x00,0x00,0x3e,0x80,0x02,0x00,0x0c,0x00,0x00,0x00,0x00,0x40,0x00,0x00,0x00,0x00,0x00,0xf8,0x01,0x40,0x10,0x00,0x03,0x00,0x00,0x00,0x20,0x80,0x00,0x00,0x00,0x00,0xf0,0x07,0x00,0x80,0x00,0x00,0x00,0xe0,0x07,0x40,0xf1,0x01,0x01,0x00,0x00,0xff,0x0f,0x00,0x00,0x00,0x00,0x00,0x00,0x54,0x1f,0x80,0xfc,0x07,0x02,0x00,0x00,0x01,0x00,0x00,0x00,0x20,0x02,0x00,0x80,0x8a,0x3b,0x00,0xff,0x1f,0x04,0x00,0x00,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x44,0x7d,0x00,0xff,0x3f,0x08,0x00,0x00,0x02,0x00,0x00,0x00,0xa0,0x08,0x00,0x00,0xa2,0x7e,0x00,0xf2,0xff,0x10,0x00,0x00,0x04,0x18,0x00,0x00,0x40,0x00,0x00,0x00,0x50,0x87,0x00,0xfc,0x3f,0x61,0x00,0x00,0x18,0x0e,0x00,0x00,0xa0,0x02,0x00,0x00,0xaa,0x01,0x01,0xf0,0x3f,0x86,0x01,0x00,0x20,0x04,0x00,0x00,0x40,0x01,0x00,0x40,0xd5,0x00,0x02,0xc0,0x7e,0x08,0x01,0x00,0x40,0x02,0x0c,0x00,0xa0,0x0a,0x00,0x00,0x6a,0x00,0x7c,0x80,0xfc,0xf0,0x00,0x00,0x40,0x82,0x5f,0x55,0x55,0x01,0x00,0x50,0x35,0x00,0x80,0x01,0xf9,0x00,0x00,0x00,0x80,0xfc,0xbe,0xaa,0xaa,0x0a,0x00,0x00,0x1a,0x00,0x00,0x06,0xfa,0x00,0x00,0x00,0x80,0x50,0xff,0x5f,0xf5,0x05,0x00,0x54,0x0d,0x00,0x00,0x18,0xf2,0x01,0x00,0x00,0x00,0xe1,0x01,0xfe,0xff,0x2a,0x00,0x80,0x06,0x00,0x00,0x78,0xf2,0x01,0x00,0x00,0x00,0x3e,0x00,0x00,0xc0,0x05,0x00,0x55,0x03,0x00,0x00,0xb8,0x61,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x80,0x2b,0x00,0xa0,0x01,0x00,0x00,0x38,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x15,0x00,0xd5,0x00,0x00,0x00,0x30,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x2b,0x00,0x68,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x16,0x00,0x15,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x2c,0x00,0x0e,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x54,0x00,0x03,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x28,0x00,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x50,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0xb0,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x60,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0xc0,0x02,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x80,0x05,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x0b,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x16};
-
-static const unsigned char image_DolphinNice_bits[] U8X8_PROGMEM = {0x00,0x00,0x00,0xf8,0x7f,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x80,0x07,0x80,0x07,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x70,0x00,0x00,0x18,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x0c,0x00,0x00,0x20,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x02,0x00,0x00,0x40,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x01,0x00,0x00,0x80,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x80,0x00,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x40,0x00,0x00,0x00,0x00,0x02,0x00,0x00,0x00,0x00,0x00,0x00,0x20,0x00,0x00,0x00,0x00,0x02,0x00,0x00,0x00,0x00,0x00,0x00,0x20,0x00,0x00,0x00,0x00,0x04,0x00,0x00,0x00,0x00,0x00,0x00,0x10,0x00,0x00,0x00,0x00,0x08,0x00,0x00,0x00,0x00,0x00,0x00,0x08,0xe0,0x0f,0x00,0x00,0x0c,0xf8,0x00,0x00,0x00,0x00,0x00,0x08,0x10,0x10,0x00,0x80,0x1a,0x07,0x07,0x00,0x00,0x00,0x00,0x04,0x08,0x20,0x00,0x40,0xf5,0x00,0x08,0x00,0x00,0x00,0x00,0x02,0xc4,0x4f,0x00,0xa0,0x1e,0x00,0x10,0x00,0x00,0x00,0x00,0x02,0x64,0x5c,0x00,0xc0,0x03,0x00,0x20,0x00,0x00,0x00,0x00,0x02,0xe4,0x5c,0x00,0x60,0x00,0x00,0x20,0x00,0x00,0x00,0x00,0x02,0xe4,0x5c,0x00,0x00,0x00,0x00,0x40,0x00,0x00,0x00,0x00,0x01,0xe4,0x5f,0x00,0x00,0x00,0x00,0x40,0x00,0x00,0x00,0x00,0x01,0xe4,0x5f,0x00,0x00,0x00,0x80,0x47,0x00,0x00,0x00,0x00,0x01,0xca,0x2f,0x00,0x00,0x00,0x60,0x48,0x00,0x00,0x00,0x00,0x01,0x95,0x1f,0x00,0x00,0x00,0x1c,0x50,0x00,0x00,0x00,0x00,0x81,0x6a,0x20,0x00,0x00,0x80,0x03,0x20,0x00,0x00,0x00,0x00,0x01,0x15,0x00,0x00,0x00,0x60,0x00,0x20,0x00,0x00,0x00,0x00,0x81,0x0a,0x00,0x00,0x00,0x18,0x00,0x20,0x00,0x00,0x00,0x00,0x01,0x0d,0x00,0x00,0x00,0x06,0x00,0x20,0x00,0x18,0x00,0x00,0x01,0x0a,0x00,0x00,0x80,0x01,0x00,0x10,0x00,0x24,0x00,0x00,0x01,0x0c,0x00,0x00,0x60,0x00,0x00,0x10,0x00,0x44,0x00,0x00,0x01,0x08,0x08,0x00,0x18,0x00,0x00,0x08,0x00,0x84,0x07,0x00,0x01,0x00,0x30,0x00,0x06,0x00,0x00,0x04,0x00,0x44,0x18,0x00,0x01,0x00,0xc0,0x81,0x01,0x00,0x00,0x02,0x00,0x24,0x20,0x00,0x01,0x00,0x00,0x7e,0x00,0x00,0x40,0x01,0x00,0x24,0x40,0x00,0x01,0x00,0x00,0x00,0x00,0x00,0xa8,0x00,0x00,0x14,0x80,0x00,0x01,0x00,0x00,0x00,0x00,0x00,0x74,0x00,0x00,0x12,0x80,0x00,0x01,0x00,0x00,0x00,0x00,0x80,0x1a,0x00,0x00,0x11,0x80,0x00,0x01,0x00,0x00,0x00,0x00,0x40,0x0d,0x00,0xc0,0x10,0x80,0x80,0x01,0x00,0x00,0x00,0x00,0xa8,0x02,0x00,0x30,0x20,0x80,0x80,0x03,0x00,0x00,0x00,0x40,0x55,0x01,0x00,0x0c,0x40,0x40,0xc0,0x03,0x00,0x00,0x00,0xaa,0xaa,0x01,0x00,0x03,0x80,0x3f,0xe0,0x03,0x00,0x00,0x00,0x55,0xd5,0x01,0xe0,0x00,0x00,0x10,0xe0,0x03,0x00,0x00,0x00,0xa8,0xaa,0x0f,0x1c,0x00,0x00,0x08,0xf0,0x03,0x00,0x00,0x00,0x00,0x55,0xfb,0x03,0x00,0x00,0x04,0xf0,0x03,0x00,0x00,0x00,0x00,0x00,0x56,0x00,0x00,0x00,0x02,0xf8,0x02,0x00,0x00,0x00,0x00,0x00,0x2a,0x01,0x00,0x00,0x01,0x78,0x03,0x00,0x00,0x00,0x00,0x00,0x54,0x00,0x00,0x80,0x00,0xbc,0x02,0x00,0x00,0x00,0x00,0x00,0xac,0x00,0x00,0x40,0x00,0x5c,0x05,0x00,0x00,0x00,0x00,0x00,0x58,0x02,0x00,0x20,0x00,0xbe,0x06,0x00,0x00,0x00,0x00,0x00,0xa8,0x00,0x00,0x10,0x00,0x5e,0x05,0x00,0x00,0x00,0x00,0x00,0x50,0x02,0x00,0x08,0x00,0xaf,0x06,0x00,0x00,0x00,0x00,0x00,0xb0,0x00,0x00,0x04,0x00,0x57,0x05,0x00,0x00,0x00,0x00,0x00,0x50,0x01,0x00,0x03,0x00,0xaf,0x06,0x00,0x00,0x00,0x00,0x00,0xa0,0x04,0x80,0x00,0x00,0x57,0x05,0x00,0x00,0x00,0x00,0x00,0x60,0x01,0x60,0x00,0x00,0xa3,0x06,0x00,0x00,0x00,0x00,0x00,0xa0,0x02,0x10,0x00,0x00,0x53,0x05,0x00,0x00,0x00,0x00,0x00,0x40,0x09,0x0c,0x00,0x00,0xa1,0x06,0x00,0x00,0x00,0x00,0x00,0xc0,0x02,0x03,0x00,0x00,0x41,0x05,0x00,0x00,0x00,0x00,0x00,0x40,0xe1,0x00,0x00,0x00,0xa1,0x06,0x00,0x00,0x00,0x00,0x00,0x80,0x1e,0x00,0x00,0x00,0x40,0x05,0x00,0x00,0x00,0x00,0x00,0x80,0x03,0x00,0x00,0x00};
-
-static const unsigned char image_Connected_bits[] U8X8_PROGMEM = {0x00,0xf8,0x3f,0x00,0x00,0x00,0x00,0x00,0x00,0x06,0xc0,0x00,0x00,0x00,0x00,0x00,0x80,0x01,0x00,0x03,0x00,0x00,0x00,0x00,0x40,0x00,0x00,0x04,0x00,0x00,0x00,0x00,0x20,0x00,0x00,0x08,0x00,0x00,0x00,0x00,0x10,0x00,0x00,0x10,0x00,0x00,0x00,0x00,0x08,0x00,0x00,0x10,0x00,0x00,0x00,0x00,0x08,0x00,0x00,0x20,0x00,0x00,0x00,0x00,0x04,0x78,0x00,0x20,0x3c,0x00,0x00,0x00,0x04,0x84,0x00,0x40,0x43,0x00,0x00,0x00,0x02,0x7a,0x01,0xc0,0x80,0x00,0x00,0x00,0x02,0xdd,0x02,0x30,0x80,0xe0,0x00,0x00,0x02,0x9d,0x02,0x0c,0xf0,0x20,0x79,0x00,0x02,0xfd,0x02,0x03,0x7c,0x20,0x86,0x00,0x01,0xfd,0x02,0x00,0x3e,0x20,0x02,0x01,0x01,0xfa,0x01,0x80,0x1f,0x40,0x02,0x02,0x01,0x14,0x02,0xc0,0x0f,0x40,0x02,0x02,0x01,0x08,0x00,0xe0,0x07,0x40,0x02,0x02,0x01,0x08,0x00,0xf0,0x03,0x80,0x04,0x02,0x01,0x00,0x00,0xf8,0x01,0x80,0x18,0x01,0x01,0x00,0x01,0x86,0x7f,0x80,0xe0,0x01,0x01,0x00,0x86,0x01,0x9e,0x80,0x00,0x01,0x01,0x00,0xf8,0xff,0x81,0x80,0x00,0x01,0x01,0x00,0x00,0x00,0x80,0x40,0x00,0x01,0x01,0x00,0x00,0x00,0x40,0x40,0x00,0x01,0x01,0x00,0x00,0x00,0x38,0x40,0x00,0x01,0x01,0x00,0x00,0x00,0x06,0x20,0x00,0x01,0x01,0x00,0x00,0xff,0x01,0x20,0x00,0x01,0x01,0x00,0x00,0xfc,0x00,0x10,0x00,0x01,0x01,0x00,0x00,0x80,0x00,0x10,0x00,0x01};
-
-static const unsigned char image_Error_bits[] U8X8_PROGMEM = {0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0xf0,0x7f,0x00,0x00,0x00,0x00,0x00,0x00,0x0c,0x80,0x01,0x00,0x00,0x00,0x00,0x00,0x03,0x00,0x06,0x00,0x00,0x00,0x00,0x80,0x00,0x00,0x08,0x00,0x00,0x00,0x00,0x40,0x00,0x00,0x10,0x00,0x00,0x00,0x00,0x20,0x00,0x00,0x20,0x00,0x00,0x00,0x00,0x10,0x00,0x00,0x20,0x00,0x00,0x00,0x00,0x10,0x00,0x00,0x40,0x00,0x00,0x00,0x00,0x08,0xf0,0x00,0x40,0x00,0x00,0x03,0x18,0x08,0x08,0x01,0x80,0x00,0x00,0x07,0x1c,0x04,0xf4,0x02,0x80,0x7c,0x00,0x0e,0x0e,0x04,0xba,0x05,0x80,0x83,0x00,0x1c,0x07,0x04,0x3a,0x05,0x70,0x00,0x01,0xb8,0x03,0x04,0xfa,0x05,0x0e,0x00,0x02,0xf0,0x01,0x02,0xfa,0x05,0x00,0xc0,0x03,0xe0,0x00,0x02,0xf4,0x02,0x00,0x30,0x02,0xf0,0x01,0x02,0x08,0x01,0x00,0x0c,0x02,0xb8,0x03,0x02,0xf0,0x00,0x00,0x03,0x02,0x1c,0x07,0x02,0x00,0x00,0xc0,0x00,0x01,0x0e,0x0e,0x02,0x00,0x00,0x30,0x80,0x00,0x07,0x1c,0x02,0x00,0x00,0x0c,0x40,0x00,0x03,0x18,0x02,0x00,0x00,0x03,0x20,0x00,0x00,0x00,0x02,0x00,0x40,0x00,0x18,0x00,0x00,0x00,0x02,0x00,0x00,0x00,0x06,0x00,0x00,0x00,0x02,0x00,0x00,0x80,0x01,0x00,0x00,0x00,0x02,0x00,0x00,0xe0,0x01,0x00,0x00,0x00,0x02,0x00,0x00,0xf8,0x01,0x00,0x00,0x00,0x02,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x02,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x02,0x00,0x00,0x00,0x01,0x00,0x00,0x00};
-
-static const unsigned char image_passport_happy1_bits[] U8X8_PROGMEM = {0xfe,0xff,0xff,0xff,0xff,0x1f,0xff,0xff,0xff,0xff,0xff,0x3f,0xff,0x0f,0x80,0xff,0xff,0x3f,0xff,0xf1,0x7f,0xfe,0xff,0x3f,0xff,0x0e,0x80,0xf9,0xff,0x3f,0x7f,0x01,0x00,0xf6,0xff,0x3f,0xbf,0x00,0x00,0xe8,0xff,0x3f,0x5f,0x00,0x00,0xd0,0xff,0x3f,0x2f,0x00,0x00,0xd0,0x03,0x3f,0x17,0x00,0x00,0xa0,0xfc,0x3e,0x17,0x00,0x00,0x20,0x03,0x3d,0x0b,0x00,0x00,0xc0,0x00,0x3a,0x0b,0x00,0x00,0x20,0x00,0x3a,0x05,0xe0,0x00,0x10,0xe0,0x3b,0x05,0xf8,0x03,0x08,0xf8,0x3b,0x05,0xfc,0x03,0x04,0xfc,0x3d,0x03,0xfe,0x01,0x02,0xfe,0x3e,0x03,0x9e,0x07,0x00,0x7f,0x3f,0x03,0x4e,0x08,0x80,0xbf,0x3f,0x03,0x2e,0x00,0xc0,0xdf,0x3f,0x03,0x14,0x00,0xe0,0xef,0x3f,0x03,0x10,0x00,0xf0,0xf7,0x3f,0x03,0x10,0x00,0xf8,0xfb,0x3f,0x01,0x00,0x01,0xfc,0xf9,0x3f,0x01,0x00,0x01,0xfe,0xe7,0x3f,0x01,0x00,0x86,0x87,0x9f,0x3f,0x01,0x00,0xf8,0x03,0x7e,0x3e,0x01,0x00,0xe0,0x07,0xf8,0x39,0x01,0x00,0x00,0x7f,0xe0,0x37,0x01,0x00,0x00,0x80,0xff,0x2b,0x01,0x30,0x06,0x00,0x00,0x28,0x01,0x48,0x09,0x00,0x00,0x28,0x01,0x88,0x08,0x00,0x00,0x36,0x01,0x88,0x08,0x00,0xe0,0x39,0x01,0x84,0x10,0xfa,0x1f,0x3e,0x01,0x84,0x10,0xf0,0xe3,0x3f,0x01,0x82,0x20,0x80,0xfb,0x3f,0x01,0x82,0x20,0x00,0xfa,0x3f,0x01,0x81,0x40,0x00,0xfa,0x3f,0x01,0x81,0x40,0x00,0xf4,0x3f,0x81,0x80,0x80,0x00,0xf4,0x3f,0x41,0x80,0x00,0x01,0xf4,0x3f,0x41,0xc0,0x01,0x01,0xe8,0x3f,0x21,0xc0,0x01,0x02,0xe8,0x3f,0x11,0xc0,0x01,0x04,0xd0,0x3f,0x0d,0xe0,0x03,0x18,0xd0,0x3f,0x03,0xe0,0x03,0xe0,0xa0,0x3f,0x01,0xf0,0x07,0x00,0x67,0x3f,0xfe,0xff,0xff,0xff,0xff,0x1f};
-
-static const unsigned char image_passport_bad1_bits[] U8X8_PROGMEM = {0xfe,0xff,0xff,0xff,0xff,0x1f,0xff,0xff,0xff,0xff,0xff,0x3f,0xff,0xff,0x01,0xf8,0xff,0x3f,0xff,0x7f,0xfe,0xe7,0xff,0x3f,0xff,0x9f,0x01,0x98,0xff,0x3f,0xff,0x6f,0x00,0x60,0xfe,0x3f,0xff,0x17,0x00,0x80,0xfd,0x3f,0xff,0x0b,0x00,0x00,0xfa,0x3f,0xff,0x05,0x00,0x00,0xf4,0x3f,0xff,0x02,0x00,0x00,0xf4,0x3f,0x7f,0x01,0x00,0x00,0xe8,0x3f,0xbf,0x00,0x00,0x00,0xe8,0x3f,0xbf,0x00,0x00,0x00,0xd0,0x3f,0x5f,0x00,0x06,0x00,0xd0,0x3f,0x5f,0x00,0x08,0x00,0xa0,0x3f,0x2f,0x00,0x10,0x00,0xa0,0x3f,0x2f,0x00,0x67,0x00,0xa0,0x3f,0x2f,0x80,0xce,0x01,0xa0,0x3f,0x17,0x40,0x9e,0x03,0xa0,0x3f,0x17,0x40,0x36,0x00,0xa0,0x3f,0x17,0x40,0x7e,0x00,0xa0,0x3f,0x17,0x40,0x7c,0x00,0xa0,0x3f,0x17,0x80,0x40,0x00,0xa0,0x3f,0x17,0xc0,0x3f,0x00,0xa0,0x3f,0x17,0x20,0x08,0x00,0xa0,0x3f,0x17,0x00,0x10,0x00,0xaa,0x3f,0x1b,0x00,0x00,0x00,0x30,0x3f,0x1b,0x00,0x00,0x00,0xc0,0x3e,0x1b,0x00,0x00,0x00,0x00,0x3d,0x1b,0x00,0x0e,0x00,0x00,0x3a,0x0d,0x00,0x31,0x00,0x00,0x34,0x0d,0x00,0xc0,0x00,0x00,0x28,0x0d,0x00,0x00,0x03,0x00,0x28,0x0d,0x00,0x00,0x0c,0x00,0x28,0x0b,0x00,0x00,0x30,0xf0,0x2b,0x0b,0x00,0x00,0xc0,0x0f,0x2c,0x0b,0x00,0x80,0x01,0x00,0x28,0x09,0x00,0x00,0x0e,0x00,0x34,0x09,0x00,0x00,0xfc,0x00,0x3b,0x09,0x00,0x00,0xf0,0xff,0x3d,0x09,0x00,0x00,0xc0,0x7f,0x3e,0x09,0x00,0x00,0x00,0xbf,0x3f,0x09,0x00,0x00,0x00,0xbc,0x3f,0x09,0x00,0x00,0x00,0xa0,0x3f,0x09,0x00,0x00,0x00,0xa0,0x3f,0x09,0x00,0x00,0x00,0xa0,0x3f,0x09,0x00,0x00,0x00,0xa0,0x3f,0x09,0x00,0x00,0x00,0xa0,0x3f,0xfe,0xff,0xff,0xff,0xff,0x1f};
-
-static const unsigned char image_Scanning_bits[] U8X8_PROGMEM = {0x00,0xc0,0xff,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0xf0,0x00,0x07,0x00,0x00,0x00,0x00,0x03,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0xac,0x03,0x18,0x00,0x00,0x00,0x00,0x03,0x00,0x00,0x00,0x00,0x10,0x00,0x00,0x56,0x05,0x60,0x00,0x00,0x00,0x80,0x02,0x00,0x00,0x00,0x00,0x08,0x00,0x00,0x81,0x0a,0x80,0x00,0x00,0x00,0x80,0x02,0x00,0x00,0x00,0x00,0x04,0x00,0x80,0x00,0x15,0x00,0x01,0x00,0x00,0x40,0x02,0x00,0x00,0x00,0x00,0x02,0x00,0x40,0x00,0x38,0x00,0x02,0x00,0x00,0x40,0x02,0x00,0x00,0x00,0x00,0x82,0x00,0x20,0x00,0x74,0x00,0x04,0x00,0x00,0x40,0x82,0x01,0x00,0x00,0x00,0x41,0x00,0x20,0x00,0x68,0x00,0x04,0x00,0x00,0x20,0x82,0x02,0x06,0x00,0x00,0x21,0x00,0x10,0x00,0xd0,0xe0,0x0f,0x00,0x00,0x20,0x82,0x02,0x0a,0x0c,0x80,0x20,0x08,0x10,0x00,0xa0,0x1c,0x10,0x00,0x00,0x20,0x82,0x02,0x0a,0x14,0x80,0x10,0x04,0x08,0xe0,0xd3,0x03,0x10,0x00,0x00,0x10,0x82,0x02,0x0a,0x14,0x80,0x10,0x02,0x08,0x90,0xa7,0x40,0x24,0x00,0x00,0x10,0x82,0x02,0x0a,0x14,0x80,0x10,0x02,0x08,0xc8,0x7f,0x84,0x28,0x00,0x00,0x10,0x84,0x02,0x0a,0xff,0x80,0x10,0x02,0x88,0x67,0x3e,0x88,0x28,0x00,0x00,0x10,0x84,0xfa,0xff,0xff,0x80,0x10,0x02,0x44,0x64,0x2e,0x88,0x28,0x00,0x00,0x10,0xfc,0xaf,0xff,0x15,0x80,0x10,0x04,0x44,0xe4,0x2f,0x88,0x2a,0x00,0x00,0x18,0xd4,0xdf,0x1f,0x14,0x80,0x20,0x08,0x44,0xe4,0x2f,0x50,0xff,0x00,0xfe,0x1f,0xec,0x3f,0x0a,0x14,0x00,0x21,0x00,0x44,0xc4,0x2f,0xea,0x00,0x01,0x01,0x1a,0xfc,0x02,0x0a,0x14,0x00,0x41,0x00,0x84,0x88,0x2f,0x1d,0x00,0x82,0x7d,0x1e,0x84,0x02,0x0a,0x18,0x00,0x82,0x00,0x86,0x1f,0xc6,0x06,0x00,0x84,0x7d,0x16,0x84,0x02,0x0a,0x00,0x00,0x02,0x00,0x46,0xf5,0xc3,0x01,0x00,0x44,0x01,0x22,0x84,0x02,0x0c,0x00,0x00,0x04,0x00,0x87,0x0a,0x7c,0x00,0x00,0x44,0x03,0x22,0x88,0x02,0x00,0x00,0x00,0x08,0x00,0x45,0x05,0x08,0x00,0x7e,0xa4,0x03,0x42,0x88,0x02,0x00,0x00,0x00,0x10,0x00,0x86,0x06,0x00,0xc0,0x81,0xa5,0x07,0x42,0x08,0x03,0x00,0x00,0x00,0x00,0x00,0x05,0x00,0x00,0x30,0x00,0xd2,0xff,0x81,0x08,0x00,0x00,0x00,0x00,0x00,0x00,0x06,0x00,0x00,0x0c,0x00,0xd2,0x1f,0x80,0x08,0x00,0x00,0x00,0x00,0x00,0x00,0x05,0x80,0x00,0x03,0x00,0xd1,0x1f,0x00,0x09,0x00,0x00,0x00,0x00,0x00,0x00,0x06,0x00,0xe1,0x00,0x80,0xe9,0x0f,0x00,0x12,0x00,0x00,0x00,0x00,0x00,0x00,0x05,0x00,0x1e,0x00,0xc0,0xe8,0x0f,0x00,0x14,0x00,0x00,0x00,0x00,0x00,0x00,0x06,0x00,0x00,0x00,0x70,0xee,0x0f,0x00,0x18,0x00,0x00,0x00,0x00,0x00,0x00,0x07,0x00,0x00,0x00,0x3c,0xf9,0x0f,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x03,0x00,0x00,0xaa,0x9f,0xf0,0x0f,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x01,0x40,0x55,0xfd,0x5f,0xf0,0x17,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x03,0x80,0xea,0xff,0x3f,0xe0,0x17,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x01,0x40,0xd5,0xff,0x1f,0xe0,0x17,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x02,0x80,0xaa,0xff,0x0f,0xe0,0x13,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x01,0x00,0x55,0x55,0x03,0xf0,0x15,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x02,0x00,0xaa,0xaa,0x00,0xb0,0x0a,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x01,0x00,0x54,0x75,0x00,0x58,0x0d,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x02,0x00,0xa8,0x0f,0x00,0xa8,0x06,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x05,0x00,0x7c,0x00,0x00,0x5c,0x03,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x02,0x00,0x00,0x00,0x00,0xae,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x05,0x00,0x00,0x00,0x00,0xd7,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x0a,0x00,0x00,0x00,0x80,0x7b,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x15,0x00,0x00,0x00,0xc0,0x1f,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x2a,0x00,0x00,0x00,0xf0,0x07,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x55,0x00,0x00,0x00,0xfc,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0xaa,0x00,0x00,0x00,0x1f,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00};
+// Screen art is in assets/*.xbm, packed at build time (see bitmap.h)
 
 // ================= TEXT CONFIGURATION (EDIT HERE) =================
+// Every line is measured at build time (tools/gen_text_layout.py) in
+// t0_13b unless marked "// font: <u8g2 font>"; one wider than 128 px
+// fails the build.
+
 // 0. INTRO SEQUENCE
+const char* MSG_HI = "HI!";
 const char* MSG_INTRO_1 = "I am a dumb\ncube";
 const char* MSG_VALENTINE_CHECK = "is valentines\nnext week?";
 const char* MSG_GOODNIGHT = "oops!\nsorry";
@@ -58,14 +95,19 @@ const char* MSG_INTRO_4_1 = "do you think";
 const char* MSG_INTRO_4_2 = "im cute???";
 const char* MSG_CUTE_YES = "knew it";
 const char* MSG_CUTE_NO = "wrong answer";
+const char* MSG_KNEW_IT = "Knew it";
+const char* MSG_WRONG_1 = "Wrong";
+const char* MSG_WRONG_2 = "Answer";
 const char* MSG_INTRO_5 = "now for the\nactual question";
 const char* MSG_INTRO_6 = "my owner\nwants to ask you";
 
 // 1. BOOT SCREEN
 const char* MSG_BOOT_1 = "Gargi, will you be";
-const char* MSG_BOOT_2 = "my Valentine?⁠";
+const char* MSG_BOOT_2 = "my Valentine?";
 
 // 2. IDLE MODE (ESCALATING "NO" RESPONSES)
+const char* MSG_IDLE_1 = "Gargi, will you";
+const char* MSG_IDLE_2 = "Be my valentine ?";
 const char* NO_RESPONSES[] = { 
   "Abe??", 
   "HO????", 
@@ -82,9 +124,10 @@ const char* MSG_FAIR_1 = "Finally! That";
 const char* MSG_FAIR_2 = "was fair right?";
 
 // 5. CONTROL MODE (If they say No to Fair Right)
-const char* MSG_CONTROL_1 = "im controlling you";
-const char* MSG_CONTROL_2 = "now!!!!";
+const char* MSG_CONTROL_1 = "im controlling you"; // font: u8g2_font_ncenB08_tr
+const char* MSG_CONTROL_2 = "now!!!!";            // font: u8g2_font_ncenB08_tr
 const char* MSG_CONTROL_3 = "SAY YES!!!";
+const char* MSG_CONTROL_US = "US ";
 
 // 6. VICTORY MESSAGES
 // Standard Win (Immediate Yes)
@@ -110,64 +153,22 @@ const char* MSG_SLEEP_2 = "<3";
 
 
 // ================= STATE MACHINE =================
-enum AppState {
-  STATE_INTRO_DOLPHIN,   // Dolphin "HI!" screen
-  STATE_INTRO_1,         // "I am a dumb cube"
-  STATE_VALENTINE_CHECK, // "Is valentines next week?"
-  STATE_GOODNIGHT,       // "oops! goodnight" before sleep
-  STATE_INTRO_REMEMBER,  // "remember"
-  STATE_INTRO_GREEN,     // "GREEN means yes" with Connected icon
-  STATE_INTRO_RED,       // "RED means no" with Error icon
-  STATE_INTRO_2,         // "i have only one purpose"
-  STATE_INTRO_3,         // "that is to ask you"
-  STATE_INTRO_4,         // "do you think im cute???"
-  STATE_CUTE_RESPONSE,   // "knew it" or "wrong answer"
-  STATE_INTRO_5,         // "now for the actual question"
-  STATE_INTRO_6,         // "my owner wants to ask you"
-  STATE_IDLE,            // "Will you be my Valentine?"
-  STATE_NO_RESPONSE,     // Showing NO response message
-  STATE_SWAP_MODE,       // Trick mode
-  STATE_FAIR_RIGHT,      // "Fair right?" (Yes/No available)
-  STATE_FINAL_PLEA,      // Control mode (Force Win)
-  STATE_CELEBRATION,     // "She said YES!"
-  STATE_FINAL_ANIMATION, // Final animation with hearts and BLE pairing
-  STATE_JOB_DONE,        // "with that my job here is done"
-  STATE_LEAVE_QUESTION,  // "Should i fuck off now?"
-  STATE_DEFIANT_RESPONSE // "you cant control me i have rights"
-};
-
+// States and events are in app_state.h
 AppState currentState = STATE_INTRO_DOLPHIN;
 
 // Logic Variables
 int noCount = 0;
-unsigned long lastActivityTime = 0;
 unsigned long stateStartTime = 0; 
-bool isTrickReveal = false;
 bool lastCuteResponseWasYes = false;
+bool introDone = false; // got as far as the question once
 
 // Non-blocking timer system
-unsigned long noResponseDisplayTime = 0;
-bool showingNoResponse = false;
-bool noResponseTimerStarted = false;
-unsigned long typewriterStartTime = 0;
 int typewriterCharIndex = 0;
 bool typewriterActive = false;
-String typewriterText1 = "";
-String typewriterText2 = "";
-String typewriterText3 = "";
+TextView typewriterText[3] = {};
 int typewriterLine = 1;
-unsigned long trickRevealStartTime = 0;
-bool trickRevealWaiting = false;
-unsigned long controlScreenStartTime = 0;
 bool showingControlScreen2 = false; 
 
-// Button Debounce Variables
-unsigned long lastDebounceTime = 0;
-bool btnYesStable = HIGH;
-bool btnNoStable = HIGH;
-bool lastBtnYesReading = HIGH;
-bool lastBtnNoReading = HIGH;
-
 // Forward declarations
 void updateLEDs();
 void showDolphinScreen();
@@ -183,211 +184,175 @@ void showFinalAnimationScreen();
 void showValentineScreen();
 void startNonBlockingTypewriter(const char* l1, const char* l2 = NULL, const char* l3 = NULL);
 void updateNonBlockingTypewriter();
-void startNoResponseTimer(); 
+void animShutdown();
+void animShutdown(AppState resumeAs);
+void enterState(AppState next, unsigned long now);
+void typewriterDone(unsigned long now);
+void onStateTimeout(Timer& t, uint32_t now);
+void onTypewriterTick(Timer& t, uint32_t now);
+void onInactivity(Timer& t, uint32_t now);
+
+// ================= TIMERS =================
+// Everything the loop waits for, on one wheel (see timer_wheel.h)
+TimerWheel timers;
+Timer stateTimer(onStateTimeout);        // the current state's timeout
+Timer typewriterTimer(onTypewriterTick); // next character
+Timer inactivityTimer(onInactivity);     // shutdown after INACTIVITY_TIMEOUT without a press
+
+// Pushes the inactivity shutdown back
+void noteActivity(unsigned long now) {
+  timers.arm(inactivityTimer, now + INACTIVITY_TIMEOUT);
+}
 
 // ================= HARD RESET =================
+// No wait for the blank frame to latch: the backend keeps the reset gap
+// before the next send, and enterDeepSleep() waits anyway
 void forceHardReset() {
-  buttonStrip.begin();
-  bodyStrip.begin();
-  buttonStrip.clear();
-  bodyStrip.clear();
-  buttonStrip.show();
-  bodyStrip.show();
-  delay(20); 
+  buttonOut.begin();
+  bodyOut.begin();
   buttonStrip.setBrightness(150); // Soft brightness
   bodyStrip.setBrightness(150);
 }
 
 // ================= DISPLAY HELPERS (TYPEWRITER) =================
-void oledTypewriter(const char* l1, const char* l2 = NULL, const char* l3 = NULL) {
-  u8g2.setFont(u8g2_font_t0_13b_tr);
-  
-  char buf1[32] = "";
-  char buf2[32] = "";
-  char buf3[32] = "";
-  
-  // --- TYPE LINE 1 ---
-  if (l1) {
-    int len = strlen(l1);
-    for(int i=0; i<len; i++) {
-      buf1[i] = l1[i];
-      buf1[i+1] = '\0';
-      
-      u8g2.clearBuffer();
-      int w = u8g2.getStrWidth(buf1);
-      int x = (128-w)/2;
-      int y = l2 ? 25 : 36;
-      u8g2.drawStr(x, y, buf1);
-      u8g2.drawStr(x + w + 1, y, "_"); 
-      u8g2.sendBuffer();
-      
-      updateLEDs(); // KEEP ANIMATIONS ALIVE!
-      delay(30 + random(30)); 
-    }
-  }
+// Frame i of typing a caption: i+1 chars plus cursor, the whole text once i == len
+void drawTypedText(int x, int y, TextView text, int i) {
+  bool typing = i < text.len;
+  uint8_t n = typing ? i + 1 : text.len;
+  textDraw(u8g2, x, y, text, n);
+  if (typing) u8g2.drawStr(x + textWidth(u8g2, text, n) + 1, y, "_");
+}
 
-  // --- TYPE LINE 2 ---
-  if (l2) {
-    int len = strlen(l2);
-    for(int i=0; i<len; i++) {
-      buf2[i] = l2[i];
-      buf2[i+1] = '\0';
-      
-      u8g2.clearBuffer();
-      int w1 = u8g2.getStrWidth(l1); u8g2.drawStr((128-w1)/2, 25, l1);
-      
-      int w2 = u8g2.getStrWidth(buf2);
-      int x = (128-w2)/2;
-      u8g2.drawStr(x, 45, buf2);
-      u8g2.drawStr(x + w2 + 1, 45, "_"); 
-      u8g2.sendBuffer();
-      updateLEDs();
-      delay(30 + random(30));
-    }
-  }
+// ================= LED EFFECTS =================
+// Keyframed sequences, see led_keyframes.h. updateLEDs() lays stateFx (the
+// looping effect of the current state) over the live frame, then sceneFx
+// (boot and shutdown) over everything.
+#define STRIP_BODY    0
+#define STRIP_BUTTONS 1
+
+Adafruit_NeoPixel* const LED_STRIPS[] = { &bodyStrip, &buttonStrip };
+const uint16_t LED_ACTIVE[] = { BodyLayout::active, ButtonLayout::active };
+ClipPlayer stateFx(LED_STRIPS, LED_ACTIVE, 2);
+ClipPlayer sceneFx(LED_STRIPS, LED_ACTIVE, 2);
+
+// Boot: the body fills with pink one pixel per 60 ms, the middle button fades
+// in pink, RED and GREEN fade in beside it, the pink fades out again, then
+// everything cross-fades into the idle breathing
+const Key BOOT_BODY_R[] = { { 0, 180, EASE_STEP } };
+const Key BOOT_BODY_G[] = { { 0, 50, EASE_STEP } };
+const Key BOOT_BODY_B[] = { { 0, 80, EASE_STEP } };
+const Key BOOT_PINK_R[] = { { 540, 0, EASE_STEP }, { 1076, 200, EASE_LINEAR }, { 1756, 200, EASE_STEP }, { 2076, 0, EASE_LINEAR } };
+const Key BOOT_PINK_G[] = { { 540, 0, EASE_STEP }, { 1076, 50, EASE_LINEAR }, { 1756, 50, EASE_STEP }, { 2076, 0, EASE_LINEAR } };
+const Key BOOT_PINK_B[] = { { 540, 0, EASE_STEP }, { 1076, 67, EASE_LINEAR }, { 1756, 67, EASE_STEP }, { 2076, 0, EASE_LINEAR } };
+const Key BOOT_SIDES[]  = { { 1076, 0, EASE_STEP }, { 1756, 255, EASE_LINEAR } };
+
+const Track BOOT_TRACKS[] = {
+  { STRIP_BODY,    CH_RED,   0, BodyLayout::active, 0, 60, CLIP_KEYS(BOOT_BODY_R) },
+  { STRIP_BODY,    CH_GREEN, 0, BodyLayout::active, 0, 60, CLIP_KEYS(BOOT_BODY_G) },
+  { STRIP_BODY,    CH_BLUE,  0, BodyLayout::active, 0, 60, CLIP_KEYS(BOOT_BODY_B) },
+  { STRIP_BUTTONS, CH_RED,   1, 1, 0, 0, CLIP_KEYS(BOOT_PINK_R) },
+  { STRIP_BUTTONS, CH_GREEN, 1, 1, 0, 0, CLIP_KEYS(BOOT_PINK_G) },
+  { STRIP_BUTTONS, CH_BLUE,  1, 1, 0, 0, CLIP_KEYS(BOOT_PINK_B) },
+  { STRIP_BUTTONS, CH_RED,   0, 1, 0, 0, CLIP_KEYS(BOOT_SIDES) }, // RED
+  { STRIP_BUTTONS, CH_GREEN, 2, 1, 0, 0, CLIP_KEYS(BOOT_SIDES) }, // GREEN
+};
+const Clip BOOT_FX = { CLIP_TRACKS(BOOT_TRACKS), 2076, 600, 0 };
+
+// Wake from deep sleep: the same pink runs along the body four times as
+// fast, then cross-fades into the breathing
+const Track RESUME_TRACKS[] = {
+  { STRIP_BODY, CH_RED,   0, BodyLayout::active, 0, 15, CLIP_KEYS(BOOT_BODY_R) },
+  { STRIP_BODY, CH_GREEN, 0, BodyLayout::active, 0, 15, CLIP_KEYS(BOOT_BODY_G) },
+  { STRIP_BODY, CH_BLUE,  0, BodyLayout::active, 0, 15, CLIP_KEYS(BOOT_BODY_B) },
+};
+const Clip RESUME_FX = { CLIP_TRACKS(RESUME_TRACKS), 135, 200, 0 };
 
-  // --- TYPE LINE 3 ---
-  if (l3) {
-    int len = strlen(l3);
-    for(int i=0; i<len; i++) {
-      buf3[i] = l3[i];
-      buf3[i+1] = '\0';
-      
-      u8g2.clearBuffer();
-      int w1 = u8g2.getStrWidth(l1); u8g2.drawStr((128-w1)/2, 25, l1);
-      int w2 = u8g2.getStrWidth(l2); u8g2.drawStr((128-w2)/2, 45, l2);
-      
-      int w3 = u8g2.getStrWidth(buf3);
-      int x = (128-w3)/2;
-      u8g2.drawStr(x, 60, buf3);
-      u8g2.drawStr(x + w3 + 1, 60, "_"); 
-
-      u8g2.sendBuffer();
-      updateLEDs();
-      delay(30 + random(30));
-    }
-  }
+// Shutdown: body and button brightness fade out, then hold black
+const Key SHUTDOWN_FADE[]   = { { 0, 150, EASE_STEP }, { 600, 0, EASE_LINEAR } };
+const Key SHUTDOWN_FADE_B[] = { { 0, 50, EASE_STEP }, { 600, 0, EASE_LINEAR } };
 
-  // Final render
-  u8g2.clearBuffer();
-  if(l1) { int w = u8g2.getStrWidth(l1); u8g2.drawStr((128-w)/2, l2?25:36, l1); }
-  if(l2) { int w = u8g2.getStrWidth(l2); u8g2.drawStr((128-w)/2, 45, l2); }
-  if(l3) { int w = u8g2.getStrWidth(l3); u8g2.drawStr((128-w)/2, 60, l3); }
-  u8g2.sendBuffer();
+const Track SHUTDOWN_TRACKS[] = {
+  { STRIP_BODY,    CH_RED,        0, BodyLayout::active, 0, 0, CLIP_KEYS(SHUTDOWN_FADE) },
+  { STRIP_BODY,    CH_BLUE,       0, BodyLayout::active, 0, 0, CLIP_KEYS(SHUTDOWN_FADE_B) },
+  { STRIP_BUTTONS, CH_BRIGHTNESS, 0, 0, 0, 0, CLIP_KEYS(SHUTDOWN_FADE) },
+};
+const Clip SHUTDOWN_FX = { CLIP_TRACKS(SHUTDOWN_TRACKS), 600, 0, 0 };
+
+// Swap mode: YES and NO trade red and green every 150 ms
+const Key FLASH_ON[]  = { { 0, 255, EASE_STEP }, { 150, 0, EASE_STEP }, { 300, 255, EASE_STEP } };
+const Key FLASH_OFF[] = { { 0, 0, EASE_STEP }, { 150, 255, EASE_STEP }, { 300, 0, EASE_STEP } };
+
+const Track SWAP_FLASH_TRACKS[] = {
+  { STRIP_BUTTONS, CH_GREEN, 0, 1, 0, 0, CLIP_KEYS(FLASH_ON) },
+  { STRIP_BUTTONS, CH_RED,   0, 1, 0, 0, CLIP_KEYS(FLASH_OFF) },
+  { STRIP_BUTTONS, CH_RED,   2, 1, 0, 0, CLIP_KEYS(FLASH_ON) },
+  { STRIP_BUTTONS, CH_GREEN, 2, 1, 0, 0, CLIP_KEYS(FLASH_OFF) },
+};
+const Clip SWAP_FLASH_FX = { CLIP_TRACKS(SWAP_FLASH_TRACKS), 0, 0, CLIP_LOOP };
+
+// Celebration: a pink wave running along the body, 0.5 rad (127 ms) per
+// pixel, over the 1600 ms period of sin(t / 800 * PI); the buttons pulse
+// green-white with 100 + 155 * sin(t / 300), below zero reading as off.
+// Half-sine eases from trough to crest reproduce both exactly.
+const Key CELEB_FULL[]   = { { 0, 255, EASE_STEP } };
+const Key CELEB_WAVE_G[] = { { 0, 20, EASE_STEP }, { 800, 100, EASE_SINE }, { 1600, 20, EASE_SINE } };
+const Key CELEB_WAVE_B[] = { { 0, 30, EASE_STEP }, { 800, 120, EASE_SINE }, { 1600, 30, EASE_SINE } };
+const Key CELEB_BUTTONS_G[] = { { 0, 200, EASE_STEP } };
+const Key CELEB_PULSE[]  = { { 0, -14, EASE_STEP }, { 942, 64, EASE_SINE }, { 1885, -14, EASE_SINE } }; // win pulse / 4
+
+const Track CELEBRATION_TRACKS[] = {
+  { STRIP_BODY,    CH_RED,   0, BodyLayout::active, 0, 0, CLIP_KEYS(CELEB_FULL) },
+  { STRIP_BODY,    CH_GREEN, 0, BodyLayout::active, 400, -127, CLIP_KEYS(CELEB_WAVE_G) },
+  { STRIP_BODY,    CH_BLUE,  0, BodyLayout::active, 400, -127, CLIP_KEYS(CELEB_WAVE_B) },
+  { STRIP_BUTTONS, CH_RED,   0, ButtonLayout::active, 471, 0, CLIP_KEYS(CELEB_PULSE) },
+  { STRIP_BUTTONS, CH_GREEN, 0, ButtonLayout::active, 0, 0, CLIP_KEYS(CELEB_BUTTONS_G) },
+  { STRIP_BUTTONS, CH_BLUE,  0, ButtonLayout::active, 471, 0, CLIP_KEYS(CELEB_PULSE) },
+};
+const Clip CELEBRATION_FX = { CLIP_TRACKS(CELEBRATION_TRACKS), 0, 0, CLIP_LOOP };
+
+const Clip* stateClip(AppState state) {
+  switch (state) {
+    case STATE_SWAP_MODE:   return &SWAP_FLASH_FX;
+    case STATE_CELEBRATION: return &CELEBRATION_FX;
+    default:                return nullptr;
+  }
 }
 
 // ================= ANIMATIONS =================
+// The LED boot runs on its own while the dolphin is already up and taking
+// presses; the first one cuts it short (see handleButtonPress)
 void animBoot() {
-  u8g2.clearBuffer(); u8g2.sendBuffer();
-  
-  // 1. Soft Pink Flow (Body) - 50% longer
-  for(int i=0; i<ACTIVE_LED_COUNT; i++) {
-    bodyStrip.setPixelColor(i, bodyStrip.Color(180, 50, 80)); 
-    bodyStrip.show();
-    delay(60); // 40ms -> 60ms
-  }
-
-  // 2. Smooth Pink Button Animation - 2nd LED first, then 1st and 3rd
-  // Phase 1: 2nd LED (middle) pink fade in
-  for(int b=0; b<=200; b+=3) {
-      buttonStrip.setPixelColor(1, buttonStrip.Color(b, b/4, b/3)); // Pink
-      buttonStrip.show();
-      delay(8); // Smoother, 50% longer
-  }
-  
-  // Phase 2: 1st and 3rd LEDs fade in simultaneously while 2nd stays lit
-  for(int b=0; b<=255; b+=3) {
-    // Keep 2nd LED at full pink brightness
-    buttonStrip.setPixelColor(1, buttonStrip.Color(200, 50, 67)); // Pink
-    // Fade in 1st (RED) and 3rd (GREEN) 
-    buttonStrip.setPixelColor(0, buttonStrip.Color(b, 0, 0)); // RED
-    buttonStrip.setPixelColor(2, buttonStrip.Color(0, b, 0)); // GREEN
-    buttonStrip.show();
-    delay(8); // 5ms -> 8ms (50% longer, smoother)
-  }
-  
-  // Phase 3: Fade out 2nd LED to black for final button state
-  for(int b=200; b>=0; b-=5) {
-    buttonStrip.setPixelColor(1, buttonStrip.Color(b, b/4, b/3)); // Pink fade out
-    buttonStrip.show();
-    delay(8);
-  }
-  
-  // Phase 4: Smooth transition to match idle animation calculations exactly
-  unsigned long transitionStartTime = millis();
-  for(int step=0; step<=50; step++) {
-    float progress = step / 50.0;
-    unsigned long now = transitionStartTime + (step * 12); // Simulate time progression
-    
-    // Calculate what idle animation values WILL BE at transition end
-    float breathe = (exp(sin(now / 2500.0 * PI)) - 0.36787944) * 108.0;
-    int targetVal = map(breathe, 0, 255, 20, 100);
-    int targetR = targetVal;
-    int targetG = targetVal / 4;
-    int targetB = targetVal / 3;
-    
-    int targetSoftPulse = 80 + (int)(sin(now / 800.0) * 60);
-    
-    // Fade from boot values to calculated idle values
-    for(int i=0; i<ACTIVE_LED_COUNT; i++) {
-      int offset = i * 40;
-      float breatheWithOffset = (exp(sin((now - offset) / 2500.0 * PI)) - 0.36787944) * 108.0;
-      int targetValWithOffset = map(breatheWithOffset, 0, 255, 20, 100);
-      
-      int r = 180 - (int)(progress * (180 - targetValWithOffset));
-      int g = 50 - (int)(progress * (50 - targetValWithOffset/4));  
-      int b = 80 - (int)(progress * (80 - targetValWithOffset/3));
-      bodyStrip.setPixelColor(i, bodyStrip.Color(r, g, b));
-    }
-    
-    // Fade buttons to exact idle pulse values
-    int redVal = 255 - (int)(progress * (255 - targetSoftPulse));
-    int greenVal = 255 - (int)(progress * (255 - targetSoftPulse));
-    buttonStrip.setPixelColor(0, buttonStrip.Color(redVal, 0, 0));
-    buttonStrip.setPixelColor(2, buttonStrip.Color(0, greenVal, 0));
-    
-    bodyStrip.show();
-    buttonStrip.show();
-    delay(12);
-  }
-  
-  // Show dolphin intro screen
+  sceneFx.play(&BOOT_FX, millis());
   showDolphinScreen();
 }
 
 // ================= INTRO SCREEN FUNCTIONS =================
-void showDolphinScreen() {
-  u8g2.clearBuffer();
-  u8g2.setFontMode(1);
-  u8g2.setBitmapMode(1);
-  u8g2.setFont(u8g2_font_t0_13b_tr);
-  
+bool sceneDolphin(Scene& s, unsigned long now) {
+  SCENE_BEGIN(s);
   // Typewriter "HI!"
-  char buf[4] = "";
-  const char* text = "HI!";
-  int len = strlen(text);
-  
-  for(int i=0; i<=len; i++) {
-    if(i < len) {
-      buf[i] = text[i];
-      buf[i+1] = '\0';
-    }
-    
+  s.caption = textView(MSG_HI);
+  for(s.i=0; s.i<=s.caption.len; s.i++) {
     u8g2.clearBuffer();
-    u8g2.drawXBMP(7, 3, 96, 59, image_DolphinNice_bits);
-    u8g2.drawStr(92, 17, buf);
-    if(i < len) u8g2.drawStr(92 + u8g2.getStrWidth(buf) + 1, 17, "_");
-    
-    u8g2.sendBuffer();
-    updateLEDs();
-    delay(80 + random(40));
+    u8g2.setFontMode(1);
+    u8g2.setBitmapMode(1);
+    u8g2.setFont(u8g2_font_t0_13b_tr);
+    bitmapDraw(u8g2, 7, 3, BMP_DOLPHIN_NICE);
+    drawTypedText(92, 17, s.caption, s.i);
+    displayFlush();
+    SCENE_DELAY(s, now, 80 + random(40));
   }
   
   // Final display
   u8g2.clearBuffer();
-  u8g2.drawXBMP(7, 3, 96, 59, image_DolphinNice_bits);
-  u8g2.drawStr(92, 17, text);
-  u8g2.sendBuffer();
+  bitmapDraw(u8g2, 7, 3, BMP_DOLPHIN_NICE);
+  textDrawStr(u8g2, 92, 17, MSG_HI);
+  displayFlush();
+  SCENE_END(s);
+}
+
+void showDolphinScreen() {
+  typewriterActive = false;
+  sceneStart(sceneDolphin);
 }
 
 void showIntroMessage(const char* message) {
@@ -398,327 +363,379 @@ void showRememberScreen() {
   startNonBlockingTypewriter(MSG_REMEMBER);
 }
 
-void showGreenYesScreen() {
-  u8g2.setFont(u8g2_font_t0_13b_tr);
-  u8g2.setFontMode(1);
-  u8g2.setBitmapMode(1);
-  
-  char buf[32] = "";
-  const char* text = MSG_GREEN_YES;
-  int len = strlen(text);
-  
-  for(int i=0; i<=len; i++) {
-    if(i < len) {
-      buf[i] = text[i];
-      buf[i+1] = '\0';
-    }
-    
+bool sceneGreenYes(Scene& s, unsigned long now) {
+  SCENE_BEGIN(s);
+  s.caption = textView(MSG_GREEN_YES);
+  for(s.i=0; s.i<=s.caption.len; s.i++) {
     u8g2.clearBuffer();
-    u8g2.drawXBMP(34, 7, 58, 30, image_Connected_bits);
-    u8g2.drawStr(11, 56, buf);
-    if(i < len) u8g2.drawStr(11 + u8g2.getStrWidth(buf) + 1, 56, "_");
-    
-    u8g2.sendBuffer();
-    updateLEDs();
-    delay(80 + random(40));
+    u8g2.setFont(u8g2_font_t0_13b_tr);
+    u8g2.setFontMode(1);
+    u8g2.setBitmapMode(1);
+    bitmapDraw(u8g2, 34, 7, BMP_CONNECTED);
+    drawTypedText(11, 56, s.caption, s.i);
+    displayFlush();
+    SCENE_DELAY(s, now, 80 + random(40));
   }
   
   // Final display
   u8g2.clearBuffer();
-  u8g2.drawXBMP(34, 7, 58, 30, image_Connected_bits);
-  u8g2.drawStr(11, 56, text);
-  u8g2.sendBuffer();
+  bitmapDraw(u8g2, 34, 7, BMP_CONNECTED);
+  textDrawStr(u8g2, 11, 56, MSG_GREEN_YES);
+  displayFlush();
+  SCENE_END(s);
 }
 
-void showRedNoScreen() {
-  u8g2.setFont(u8g2_font_t0_13b_tr);
-  u8g2.setFontMode(1);
-  u8g2.setBitmapMode(1);
-  
-  char buf[32] = "";
-  const char* text = MSG_RED_NO;
-  int len = strlen(text);
-  
-  for(int i=0; i<=len; i++) {
-    if(i < len) {
-      buf[i] = text[i];
-      buf[i+1] = '\0';
-    }
-    
+void showGreenYesScreen() {
+  typewriterActive = false;
+  sceneStart(sceneGreenYes);
+}
+
+bool sceneRedNo(Scene& s, unsigned long now) {
+  SCENE_BEGIN(s);
+  s.caption = textView(MSG_RED_NO);
+  for(s.i=0; s.i<=s.caption.len; s.i++) {
     u8g2.clearBuffer();
-    u8g2.drawXBMP(33, 6, 62, 31, image_Error_bits);
-    u8g2.drawStr(21, 56, buf);
-    if(i < len) u8g2.drawStr(21 + u8g2.getStrWidth(buf) + 1, 56, "_");
-    
-    u8g2.sendBuffer();
-    updateLEDs();
-    delay(80 + random(40));
+    u8g2.setFont(u8g2_font_t0_13b_tr);
+    u8g2.setFontMode(1);
+    u8g2.setBitmapMode(1);
+    bitmapDraw(u8g2, 33, 6, BMP_ERROR);
+    drawTypedText(21, 56, s.caption, s.i);
+    displayFlush();
+    SCENE_DELAY(s, now, 80 + random(40));
   }
   
   // Final display
   u8g2.clearBuffer();
-  u8g2.drawXBMP(33, 6, 62, 31, image_Error_bits);
-  u8g2.drawStr(21, 56, text);
-  u8g2.sendBuffer();
+  bitmapDraw(u8g2, 33, 6, BMP_ERROR);
+  textDrawStr(u8g2, 21, 56, MSG_RED_NO);
+  displayFlush();
+  SCENE_END(s);
 }
 
-void showPassportHappyScreen() {
-  u8g2.setFont(u8g2_font_t0_13b_tr);
-  u8g2.setFontMode(1);
-  u8g2.setBitmapMode(1);
-  
-  char buf[32] = "";
-  const char* text = "Knew it";
-  int len = strlen(text);
-  
-  for(int i=0; i<=len; i++) {
-    if(i < len) {
-      buf[i] = text[i];
-      buf[i+1] = '\0';
-    }
-    
+void showRedNoScreen() {
+  typewriterActive = false;
+  sceneStart(sceneRedNo);
+}
+
+bool scenePassportHappy(Scene& s, unsigned long now) {
+  SCENE_BEGIN(s);
+  s.caption = textView(MSG_KNEW_IT);
+  for(s.i=0; s.i<=s.caption.len; s.i++) {
     u8g2.clearBuffer();
-    u8g2.drawXBMP(9, 7, 46, 49, image_passport_happy1_bits);
-    u8g2.drawStr(68, 36, buf);
-    if(i < len) u8g2.drawStr(68 + u8g2.getStrWidth(buf) + 1, 36, "_");
-    
-    u8g2.sendBuffer();
-    updateLEDs();
-    delay(80 + random(40));
+    u8g2.setFont(u8g2_font_t0_13b_tr);
+    u8g2.setFontMode(1);
+    u8g2.setBitmapMode(1);
+    bitmapDraw(u8g2, 9, 7, BMP_PASSPORT_HAPPY);
+    drawTypedText(68, 36, s.caption, s.i);
+    displayFlush();
+    SCENE_DELAY(s, now, 80 + random(40));
   }
   
   // Final display
   u8g2.clearBuffer();
-  u8g2.drawXBMP(9, 7, 46, 49, image_passport_happy1_bits);
-  u8g2.drawStr(68, 36, text);
-  u8g2.sendBuffer();
+  bitmapDraw(u8g2, 9, 7, BMP_PASSPORT_HAPPY);
+  textDrawStr(u8g2, 68, 36, MSG_KNEW_IT);
+  displayFlush();
+  SCENE_END(s);
 }
 
-void showPassportBadScreen() {
-  u8g2.setFont(u8g2_font_t0_13b_tr);
-  u8g2.setFontMode(1);
-  u8g2.setBitmapMode(1);
-  
+void showPassportHappyScreen() {
+  typewriterActive = false;
+  sceneStart(scenePassportHappy);
+}
+
+bool scenePassportBad(Scene& s, unsigned long now) {
+  SCENE_BEGIN(s);
   // First line: "Wrong"
-  char buf1[32] = "";
-  const char* text1 = "Wrong";
-  int len1 = strlen(text1);
-  
-  for(int i=0; i<=len1; i++) {
-    if(i < len1) {
-      buf1[i] = text1[i];
-      buf1[i+1] = '\0';
-    }
-    
+  s.caption = textView(MSG_WRONG_1);
+  for(s.i=0; s.i<=s.caption.len; s.i++) {
     u8g2.clearBuffer();
-    u8g2.drawXBMP(9, 7, 46, 49, image_passport_bad1_bits);
-    u8g2.drawStr(75, 29, buf1);
-    if(i < len1) u8g2.drawStr(75 + u8g2.getStrWidth(buf1) + 1, 29, "_");
-    
-    u8g2.sendBuffer();
-    updateLEDs();
-    delay(80 + random(40));
+    u8g2.setFont(u8g2_font_t0_13b_tr);
+    u8g2.setFontMode(1);
+    u8g2.setBitmapMode(1);
+    bitmapDraw(u8g2, 9, 7, BMP_PASSPORT_BAD);
+    drawTypedText(75, 29, s.caption, s.i);
+    displayFlush();
+    SCENE_DELAY(s, now, 80 + random(40));
   }
   
   // Second line: "Answer"
-  char buf2[32] = "";
-  const char* text2 = "Answer";
-  int len2 = strlen(text2);
-  
-  for(int i=0; i<=len2; i++) {
-    if(i < len2) {
-      buf2[i] = text2[i];
-      buf2[i+1] = '\0';
-    }
-    
+  s.caption = textView(MSG_WRONG_2);
+  for(s.i=0; s.i<=s.caption.len; s.i++) {
     u8g2.clearBuffer();
-    u8g2.drawXBMP(9, 7, 46, 49, image_passport_bad1_bits);
-    u8g2.drawStr(75, 29, text1);
-    u8g2.drawStr(72, 44, buf2);
-    if(i < len2) u8g2.drawStr(72 + u8g2.getStrWidth(buf2) + 1, 44, "_");
-    
-    u8g2.sendBuffer();
-    updateLEDs();
-    delay(80 + random(40));
+    u8g2.setFont(u8g2_font_t0_13b_tr);
+    bitmapDraw(u8g2, 9, 7, BMP_PASSPORT_BAD);
+    textDrawStr(u8g2, 75, 29, MSG_WRONG_1);
+    drawTypedText(72, 44, s.caption, s.i);
+    displayFlush();
+    SCENE_DELAY(s, now, 80 + random(40));
   }
   
   // Final display
   u8g2.clearBuffer();
-  u8g2.drawXBMP(9, 7, 46, 49, image_passport_bad1_bits);
-  u8g2.drawStr(75, 29, text1);
-  u8g2.drawStr(72, 44, text2);
-  u8g2.sendBuffer();
+  bitmapDraw(u8g2, 9, 7, BMP_PASSPORT_BAD);
+  textDrawStr(u8g2, 75, 29, MSG_WRONG_1);
+  textDrawStr(u8g2, 72, 44, MSG_WRONG_2);
+  displayFlush();
+  SCENE_END(s);
+}
+
+void showPassportBadScreen() {
+  typewriterActive = false;
+  sceneStart(scenePassportBad);
 }
 
 void showControlScreen1() {
+  if (displayShowCached(MSG_CONTROL_1)) return;
   u8g2.clearBuffer();
   u8g2.setFontMode(1);
   u8g2.setBitmapMode(1);
-  u8g2.drawXBMP(0, 15, 116, 49, image_Scanning_bits);
+  bitmapDraw(u8g2, 0, 15, BMP_SCANNING);
   u8g2.setFont(u8g2_font_ncenB08_tr);
-  u8g2.drawStr(0, 11, MSG_CONTROL_1);
-  u8g2.drawStr(73, 59, MSG_CONTROL_2);
-  u8g2.sendBuffer();
+  textDrawStr(u8g2, 0, 11, MSG_CONTROL_1);
+  textDrawStr(u8g2, 73, 59, MSG_CONTROL_2);
+  displayFlushCached(MSG_CONTROL_1);
 }
 
 void showControlScreen2() {
+  if (displayShowCached(MSG_CONTROL_3)) return;
   u8g2.clearBuffer();
   u8g2.setFontMode(1);
   u8g2.setBitmapMode(1);
-  u8g2.drawXBMP(0, 15, 116, 49, image_Scanning_bits);
+  bitmapDraw(u8g2, 0, 15, BMP_SCANNING);
   u8g2.setFont(u8g2_font_t0_13b_tr);
-  u8g2.drawStr(29, 11, MSG_CONTROL_3);
-  u8g2.sendBuffer();
+  textDrawStr(u8g2, 29, 11, MSG_CONTROL_3);
+  displayFlushCached(MSG_CONTROL_3);
 }
 
 void showFinalAnimationScreen() {
+  if (displayShowCached(MSG_CONTROL_US)) return;
   u8g2.clearBuffer();
   u8g2.setFontMode(1);
   u8g2.setBitmapMode(1);
   u8g2.setFont(u8g2_font_t0_13b_tr);
-  u8g2.drawStr(55, 23, "US ");
-  u8g2.drawXBMP(55, 31, 15, 16, image_cards_hearts_bits);
-  u8g2.drawXBMP(0, 0, 128, 64, image_BLE_Pairing_bits);
-  u8g2.sendBuffer();
+  textDrawStr(u8g2, 55, 23, MSG_CONTROL_US);
+  bitmapDraw(u8g2, 55, 31, BMP_CARDS_HEARTS);
+  bitmapDraw(u8g2, 0, 0, BMP_BLE_PAIRING);
+  displayFlushCached(MSG_CONTROL_US);
 }
 
-void showValentineScreen() {
-  // Custom typewriter with blinking heart
-  u8g2.setFont(u8g2_font_t0_13b_tr);
-  u8g2.setFontMode(1);
-  u8g2.setBitmapMode(1);
-  
-  char buf1[32] = "";
-  char buf2[32] = "";
-  const char* line1 = "Gargi, will you";
-  const char* line2 = "Be my valentine ?";
-  
+// Custom typewriter with blinking heart
+bool sceneValentine(Scene& s, unsigned long now) {
+  SCENE_BEGIN(s);
   // Type line 1
-  int len1 = strlen(line1);
-  for(int i=0; i<=len1; i++) {
-    if(i < len1) {
-      buf1[i] = line1[i];
-      buf1[i+1] = '\0';
-    }
-    
+  s.caption = textView(MSG_IDLE_1);
+  for(s.i=0; s.i<=s.caption.len; s.i++) {
     u8g2.clearBuffer();
-    u8g2.drawStr(11, 18, buf1);
-    if(i < len1) u8g2.drawStr(11 + u8g2.getStrWidth(buf1) + 1, 18, "_");
+    u8g2.setFont(u8g2_font_t0_13b_tr);
+    u8g2.setFontMode(1);
+    u8g2.setBitmapMode(1);
+    drawTypedText(11, 18, s.caption, s.i);
     
     // Blinking heart
-    if((millis() / 300) % 2 == 0) {
-      u8g2.drawXBMP(56, 41, 15, 16, image_cards_hearts_bits);
+    if((now / 300) % 2 == 0) {
+      bitmapDraw(u8g2, 56, 41, BMP_CARDS_HEARTS);
     }
     
-    u8g2.sendBuffer();
-    updateLEDs();
-    delay(80 + random(40));
+    displayFlush();
+    SCENE_DELAY(s, now, 80 + random(40));
   }
   
   // Type line 2
-  int len2 = strlen(line2);
-  for(int i=0; i<=len2; i++) {
-    if(i < len2) {
-      buf2[i] = line2[i];
-      buf2[i+1] = '\0';
-    }
-    
+  s.caption = textView(MSG_IDLE_2);
+  for(s.i=0; s.i<=s.caption.len; s.i++) {
     u8g2.clearBuffer();
-    u8g2.drawStr(11, 18, line1);
-    u8g2.drawStr(3, 33, buf2);
-    if(i < len2) u8g2.drawStr(3 + u8g2.getStrWidth(buf2) + 1, 33, "_");
+    u8g2.setFont(u8g2_font_t0_13b_tr);
+    textDrawStr(u8g2, 11, 18, MSG_IDLE_1);
+    drawTypedText(3, 33, s.caption, s.i);
     
     // Blinking heart
-    if((millis() / 300) % 2 == 0) {
-      u8g2.drawXBMP(56, 41, 15, 16, image_cards_hearts_bits);
+    if((now / 300) % 2 == 0) {
+      bitmapDraw(u8g2, 56, 41, BMP_CARDS_HEARTS);
     }
     
-    u8g2.sendBuffer();
-    updateLEDs();
-    delay(80 + random(40));
+    displayFlush();
+    SCENE_DELAY(s, now, 80 + random(40));
   }
   
   // Final display with steady heart
   u8g2.clearBuffer();
-  u8g2.drawStr(11, 18, line1);
-  u8g2.drawStr(3, 33, line2);
-  u8g2.drawXBMP(56, 41, 15, 16, image_cards_hearts_bits);
-  u8g2.sendBuffer();
+  textDrawStr(u8g2, 11, 18, MSG_IDLE_1);
+  textDrawStr(u8g2, 3, 33, MSG_IDLE_2);
+  bitmapDraw(u8g2, 56, 41, BMP_CARDS_HEARTS);
+  displayFlush();
+  SCENE_END(s);
 }
 
-void animShutdown() {
-  oledTypewriter(MSG_SLEEP_1, MSG_SLEEP_2); 
+void showValentineScreen() {
+  typewriterActive = false;
+  sceneStart(sceneValentine);
+}
+
+// ================= SLEEP & WAKE =================
+// Deep sleep resets the chip, only RTC slow memory survives. The state the
+// cube fell asleep in goes there, and a wake by either button skips boot
+// and intro and goes straight back to it (see resumeTarget()).
+#define RESUME_MAGIC 0x52534D31 // "RSM1"
+
+struct ResumeState {
+  uint32_t magic;  // RTC memory is garbage after power-up
+  uint8_t state;   // AppState before the shutdown, STATE_SHUTDOWN once the leave question was answered
+  uint8_t noCount;
+  bool introDone;
+};
+RTC_DATA_ATTR ResumeState resume;
+
+void saveResumeState(AppState from) {
+  resume.magic = RESUME_MAGIC;
+  resume.state = from;
+  resume.noCount = noCount;
+  resume.introDone = introDone;
+}
+
+// The leave question answered (YES, or NO and the defiant answer): the
+// shutdown saves STATE_SHUTDOWN, and there is nothing left to ask
+static bool conversationOver(AppState slept) {
+  return slept == STATE_DEFIANT_RESPONSE || slept == STATE_SHUTDOWN;
+}
+bool conversationEnded = false; // woke after that, holding the hearts
+
+// Screens that only make sense right after what led to them fall back to
+// the nearest one that stands on its own. After the YES the cube goes back
+// to the hearts: still on its way to the leave question if that hadn't
+// come yet, for good if it had been answered (resumeFromSleep() holds them).
+// Only a leave question nobody answered is asked again.
+AppState resumeTarget(AppState slept) {
+  switch (slept) {
+    case STATE_GOODNIGHT:       return STATE_VALENTINE_CHECK;
+    case STATE_CUTE_RESPONSE:   return STATE_INTRO_4;
+    case STATE_NO_RESPONSE:
+    case STATE_SWAP_MODE:
+    case STATE_TRICK_REVEAL:
+    case STATE_FAIR_RIGHT:
+    case STATE_FINAL_PLEA:      return STATE_IDLE;
+    case STATE_CELEBRATION:
+    case STATE_DEFIANT_RESPONSE:
+    case STATE_SHUTDOWN:        return STATE_FINAL_ANIMATION;
+    default:                    return slept < STATE_COUNT ? slept : STATE_INTRO_DOLPHIN;
+  }
+}
+
+// The screen a state shows when it is entered, without the transition
+void showResumeScreen(AppState state) {
+  switch (state) {
+    case STATE_INTRO_DOLPHIN:   showDolphinScreen(); break;
+    case STATE_INTRO_1:         showIntroMessage(MSG_INTRO_1); break;
+    case STATE_VALENTINE_CHECK: startNonBlockingTypewriter(MSG_VALENTINE_CHECK); break;
+    case STATE_INTRO_REMEMBER:  showRememberScreen(); break;
+    case STATE_INTRO_GREEN:     showGreenYesScreen(); break;
+    case STATE_INTRO_RED:       showRedNoScreen(); break;
+    case STATE_INTRO_2:         startNonBlockingTypewriter(MSG_INTRO_2_1, MSG_INTRO_2_2); break;
+    case STATE_INTRO_3:         showIntroMessage(MSG_INTRO_3); break;
+    case STATE_INTRO_4:         startNonBlockingTypewriter(MSG_INTRO_4_1, MSG_INTRO_4_2); break;
+    case STATE_INTRO_5:         startNonBlockingTypewriter(MSG_INTRO_5); break;
+    case STATE_INTRO_6:         startNonBlockingTypewriter(MSG_INTRO_6); break;
+    case STATE_FINAL_ANIMATION: showFinalAnimationScreen(); break;
+    case STATE_JOB_DONE:        startNonBlockingTypewriter(MSG_JOB_DONE_1, MSG_JOB_DONE_2); break;
+    case STATE_LEAVE_QUESTION:  startNonBlockingTypewriter(MSG_LEAVE_QUESTION); break;
+    case STATE_IDLE:
+    default:                    showValentineScreen(); break;
+  }
+}
+
+// setup() for a wake: true if there was something to go back to
+bool resumeFromSleep() {
+  if (esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_GPIO || resume.magic != RESUME_MAGIC) return false;
+
+  noCount = resume.noCount;
+  introDone = resume.introDone;
+  AppState slept = (AppState)resume.state;
+  AppState target = resumeTarget(slept);
+  if (introDone && target < STATE_IDLE) target = STATE_IDLE;
+
+  unsigned long now = millis();
+  sceneFx.play(&RESUME_FX, now);
+  showResumeScreen(target);
+  enterState(target, now);
+  conversationEnded = conversationOver(slept);
+  if (conversationEnded) timers.cancel(stateTimer); // the hearts stay until the next sleep
+  return true;
+}
+
+void enterDeepSleep() {
+  idleStop();
+  esp_deep_sleep_enable_gpio_wakeup((1ULL << BTN_YES_GPIO) | (1ULL << BTN_NO_GPIO), ESP_GPIO_WAKEUP_GPIO_LOW);
+  delay(100);
+  esp_deep_sleep_start();
+}
+
+bool sceneShutdown(Scene& s, unsigned long now) {
+  SCENE_BEGIN(s);
+  SCENE_WAIT_UNTIL(s, !typewriterActive); // "Goodnight... <3"
   
   // Fade out softly
-  for(int b=150; b>=0; b-=5) {
-    for(int i=0; i<ACTIVE_LED_COUNT; i++) {
-       bodyStrip.setPixelColor(i, bodyStrip.Color(b, 0, b/3));
-    }
-    buttonStrip.setBrightness(b);
-    bodyStrip.show();
-    buttonStrip.show();
-    delay(20);
-  }
+  sceneFx.play(&SHUTDOWN_FX, now);
+  SCENE_WAIT_UNTIL(s, sceneFx.done(now));
+  
   forceHardReset();
-  u8g2.clearDisplay();
+  u8g2.clearBuffer();
+  displayFlush();
+  displaySync(); // the display task must finish blanking the panel first
+  enterDeepSleep();
+  SCENE_END(s);
+}
+
+// resumeAs: where a wake picks up (see resumeTarget())
+void animShutdown(AppState resumeAs) {
+  saveResumeState(resumeAs);
+  currentState = STATE_SHUTDOWN;
+  timers.cancel(stateTimer);
+  startNonBlockingTypewriter(MSG_SLEEP_1, MSG_SLEEP_2);
+  sceneStart(sceneShutdown);
+}
+
+// Inactivity: the screen it was on, or still the end of the conversation
+void animShutdown() {
+  animShutdown(conversationEnded ? STATE_SHUTDOWN : currentState);
+}
+
+// Candlelight tint: full red, a quarter green, a third blue
+#define CANDLE colorRgb(255, 64, 85)
+
+// Candlelight breathing on every lit pixel, each at its layout's offset
+template <typename Layout>
+void drawCandle(Adafruit_NeoPixel& strip, unsigned long now) {
+  Layout::forEach([&](uint16_t i, uint32_t offsetMs) {
+    int val = ledBreathe(now - offsetMs);
+    strip.setPixelColor(i, colorScale(CANDLE, val + 1)); // (val, val/4, val/3) give or take 1
+  });
 }
 
 // Non-blocking Animation Loop
 void updateLEDs() {
+  PROFILE_SCOPE(PROF_UPDATE_LEDS);
   unsigned long now = millis();
   
-  // 1. BODY STRIP: SOFT ROMANCE (Always Active)
-  if (currentState == STATE_CELEBRATION) {
-      float wave = 0.5 + 0.5 * sin(now / 1000.0 * PI);
-      for(int i=0; i<ACTIVE_LED_COUNT; i++) {
-          float localWave = 0.5 + 0.5 * sin((now / 800.0 * PI) + (i * 0.5));
-          int r = 255;
-          int g = 20 + (80 * localWave);
-          int b = 30 + (90 * localWave);
-          bodyStrip.setPixelColor(i, bodyStrip.Color(r, g, b));
-      }
-  } else {
-    // CANDLELIGHT BREATHING (IDLE)
-    for(int i=0; i<ACTIVE_LED_COUNT; i++) {
-      int offset = i * 40; 
-      float breathe = (exp(sin((now - offset) / 2500.0 * PI)) - 0.36787944) * 108.0;
-      int val = map(breathe, 0, 255, 20, 100);
-      bodyStrip.setPixelColor(i, bodyStrip.Color(val, val/4, val/3)); 
-    }
-  }
-  for(int i=ACTIVE_LED_COUNT; i<PHYSICAL_LED_COUNT; i++) bodyStrip.setPixelColor(i, 0);
+  // 1. BODY STRIP: CANDLELIGHT BREATHING (Always Active)
+  drawCandle<BodyLayout>(bodyStrip, now);
 
   // 2. BUTTON STRIP
-  if (!isTrickReveal) {
-      int softPulse = 80 + (int)(sin(now / 800.0) * 60); 
-      int panicPulse = 100 + (int)(sin(now / 150.0) * 100); 
+  if (currentState != STATE_TRICK_REVEAL) {
+      int softPulse = ledSoftPulse(now); 
+      int panicPulse = ledPanicPulse(now); 
 
       buttonStrip.clear();
 
       switch (currentState) {
         case STATE_SWAP_MODE:
-          if ((now / 150) % 2 == 0) {
-             buttonStrip.setPixelColor(0, buttonStrip.Color(0, 255, 0)); // Pure Green
-             buttonStrip.setPixelColor(2, buttonStrip.Color(255, 0, 0)); // Pure Red
-          } else {
-             buttonStrip.setPixelColor(0, buttonStrip.Color(255, 0, 0)); // Pure Red
-             buttonStrip.setPixelColor(2, buttonStrip.Color(0, 255, 0)); // Pure Green
-          }
-          break;
+        case STATE_CELEBRATION:
+          break; // keyframed, see stateClip()
 
         case STATE_FINAL_PLEA:
           buttonStrip.setPixelColor(0, buttonStrip.Color(0, panicPulse, 50)); 
           buttonStrip.setPixelColor(2, buttonStrip.Color(0, panicPulse, 50));
           break;
 
-        case STATE_CELEBRATION:
-          {
-            int winPulse = 100 + (int)(sin(now / 300.0) * 155); 
-            if (winPulse < 0) winPulse = 0;
-            buttonStrip.fill(buttonStrip.Color(winPulse/4, 200, winPulse/4));
-          }
-          break;
-
         case STATE_FAIR_RIGHT:
         default: // IDLE & FAIR RIGHT
           buttonStrip.setPixelColor(0, buttonStrip.Color(softPulse, 0, 0)); 
@@ -727,427 +744,958 @@ void updateLEDs() {
       }
   }
 
-  bodyStrip.show();
-  buttonStrip.show();
+  // 3. KEYFRAMED EFFECTS: the state's own, then boot/shutdown on top
+  stateFx.play(stateClip(currentState), now);
+  stateFx.apply(now);
+  sceneFx.apply(now);
 }
 
 // ================= NON-BLOCKING TYPEWRITER SYSTEM =================
+// Timing control - 30% faster
+static uint32_t typewriterDelay() {
+  return 56 + random(28);
+}
+
 void startNonBlockingTypewriter(const char* l1, const char* l2, const char* l3) {
+  sceneStop();
   typewriterActive = true;
   typewriterCharIndex = 0;
   typewriterLine = 1;
-  typewriterStartTime = millis();
+  timers.arm(typewriterTimer, millis() + typewriterDelay());
   
-  // Handle newline characters in l1
-  if (l1) {
-    String text1 = String(l1);
-    int newlinePos = text1.indexOf('\n');
-    if (newlinePos != -1 && !l2) {
-      // Split on newline if no l2 provided
-      typewriterText1 = text1.substring(0, newlinePos);
-      typewriterText2 = text1.substring(newlinePos + 1);
-      typewriterText3 = l3 ? String(l3) : "";
-    } else {
-      typewriterText1 = text1;
-      typewriterText2 = l2 ? String(l2) : "";
-      typewriterText3 = l3 ? String(l3) : "";
-    }
-  } else {
-    typewriterText1 = "";
-    typewriterText2 = l2 ? String(l2) : "";
-    typewriterText3 = l3 ? String(l3) : "";
-  }
+  typewriterText[0] = textView(l1);
+  typewriterText[1] = textView(l2);
+  typewriterText[2] = textView(l3);
+  
+  // Split on newline if no l2 provided
+  if (!l2) textSplitLine(typewriterText[0], typewriterText[0], typewriterText[1]);
 }
 
+#define TYPED_FRAME 0xFF // frame cache variant of a finished typewriter screen
+
+// A finished caption is all of its lines: captions can share a first line,
+// and equal literals (MSG_WIN_STD_1, MSG_WIN_FINAL_1) even its address
+DisplayKey typedFrameKey(const TextView* text) {
+  return { { text[0].str, text[1].str, text[2].str }, TYPED_FRAME };
+}
+
+// First n chars of text centred on row y, optionally with the cursor after them
+void drawCenteredPrefix(TextView text, uint8_t n, int y, bool cursor) {
+  int w = textWidth(u8g2, text, n);
+  textDraw(u8g2, (128-w)/2, y, text, n);
+  if (cursor) u8g2.drawStr((128-w)/2 + w + 1, y, "_");
+}
+
+// One character, the timer calls it every typewriterDelay()
 void updateNonBlockingTypewriter() {
+  PROFILE_SCOPE(PROF_TYPEWRITER);
   if (!typewriterActive) return;
   
   unsigned long now = millis();
-  if (now - typewriterStartTime < 56 + random(28)) return; // Timing control - 30% faster
-  
-  typewriterStartTime = now;
   u8g2.setFont(u8g2_font_t0_13b_tr);
-  u8g2.clearBuffer();
   
-  // Display completed lines
-  if (typewriterLine > 1 && typewriterText1.length() > 0) {
-    int w1 = u8g2.getStrWidth(typewriterText1.c_str());
-    u8g2.drawStr((128-w1)/2, typewriterText2.length() > 0 ? 25 : 36, typewriterText1.c_str());
-  }
-  if (typewriterLine > 2 && typewriterText2.length() > 0) {
-    int w2 = u8g2.getStrWidth(typewriterText2.c_str());
-    u8g2.drawStr((128-w2)/2, 45, typewriterText2.c_str());
-  }
+  const TextView* text = typewriterText;
+  const TextView& target = text[typewriterLine - 1];
+  bool lineDone = typewriterCharIndex >= target.len;
   
-  // Current line being typed
-  String currentText = "";
-  String* targetText = nullptr;
-  int yPos = 36;
+  // Check if this tick completes all available lines. The finished screen
+  // comes back whenever the same text is typed again.
+  bool line2Done = text[1].empty() || (typewriterLine >= 2);
+  bool line3Done = text[2].empty() || (typewriterLine >= 3);
+  bool finished = lineDone && line2Done && line3Done;
+  DisplayKey key = typedFrameKey(text);
   
-  if (typewriterLine == 1 && typewriterText1.length() > 0) {
-    targetText = &typewriterText1;
-    yPos = typewriterText2.length() > 0 ? 25 : 36;
-  } else if (typewriterLine == 2 && typewriterText2.length() > 0) {
-    targetText = &typewriterText2;
-    yPos = 45;
-  } else if (typewriterLine == 3 && typewriterText3.length() > 0) {
-    targetText = &typewriterText3;
-    yPos = 60;
+  if (!finished || !displayShowCached(key)) {
+    u8g2.clearBuffer();
+    const int lineY[3] = { text[1].empty() ? 36 : 25, 45, 60 };
+    
+    // Display completed lines
+    if (typewriterLine > 1) drawCenteredPrefix(text[0], text[0].len, lineY[0], false);
+    if (typewriterLine > 2) drawCenteredPrefix(text[1], text[1].len, lineY[1], false);
+    
+    // Current line being typed, or complete
+    int yPos = lineY[typewriterLine - 1];
+    if (!lineDone) drawCenteredPrefix(target, typewriterCharIndex + 1, yPos, true);
+    else drawCenteredPrefix(target, target.len, yPos, false);
+    
+    if (finished) displayFlushCached(key);
+    else displayFlush();
   }
   
-  if (targetText && typewriterCharIndex < targetText->length()) {
-    currentText = targetText->substring(0, typewriterCharIndex + 1);
-    int w = u8g2.getStrWidth(currentText.c_str());
-    u8g2.drawStr((128-w)/2, yPos, currentText.c_str());
-    u8g2.drawStr((128-w)/2 + w + 1, yPos, "_");
+  if (!lineDone) {
     typewriterCharIndex++;
   } else {
     // Current line complete, move to next or finish
-    if (targetText) {
-      int w = u8g2.getStrWidth(targetText->c_str());
-      u8g2.drawStr((128-w)/2, yPos, targetText->c_str());
-    }
-    
     typewriterCharIndex = 0;
     typewriterLine++;
     
-    // Check if we've completed all available lines
-    bool line1Done = (typewriterText1.length() == 0) || (typewriterLine > 1);
-    bool line2Done = (typewriterText2.length() == 0) || (typewriterLine > 2);
-    bool line3Done = (typewriterText3.length() == 0) || (typewriterLine > 3);
-    
-    if (line1Done && line2Done && line3Done) {
+    if (finished) {
       typewriterActive = false;
+      typewriterDone(now);
     }
   }
-  
-  u8g2.sendBuffer();
 }
 
-void startNoResponseTimer() {
-  showingNoResponse = true;
-  noResponseTimerStarted = false; // Timer will start when typewriter finishes
-  noResponseDisplayTime = 0;
+void onTypewriterTick(Timer& t, uint32_t now) {
+  if (!typewriterActive) return;
+  updateNonBlockingTypewriter();
+  if (typewriterActive) timers.arm(t, now + typewriterDelay());
 }
 
 // ================= IDLE DISPLAY UPDATE =================
 void updateIdleDisplay() {
-  if (currentState == STATE_IDLE && !typewriterActive) {
+  PROFILE_SCOPE(PROF_IDLE_DISPLAY);
+  if (currentState == STATE_IDLE && !typewriterActive && !sceneActive()) {
+    // Blinking heart: two frames, drawn once each
+    bool heart = (millis() / 300) % 2 == 0;
+    if (displayShowCached(MSG_IDLE_1, heart)) return;
+
     u8g2.clearBuffer();
     u8g2.setFont(u8g2_font_t0_13b_tr);
     u8g2.setFontMode(1);
     u8g2.setBitmapMode(1);
     
-    u8g2.drawStr(11, 18, "Gargi, will you");
-    u8g2.drawStr(3, 33, "Be my valentine ?");
+    textDrawStr(u8g2, 11, 18, MSG_IDLE_1);
+    textDrawStr(u8g2, 3, 33, MSG_IDLE_2);
     
-    // Blinking heart
-    if((millis() / 300) % 2 == 0) {
-      u8g2.drawXBMP(56, 41, 15, 16, image_cards_hearts_bits);
+    if (heart) {
+      bitmapDraw(u8g2, 56, 41, BMP_CARDS_HEARTS);
     }
     
-    u8g2.sendBuffer();
+    displayFlushCached(MSG_IDLE_1, heart);
   }
 }
 
+// ================= BOOT TIMING =================
+// From reset (micros() 0, after the ROM and bootloader) to input being read
+// and to the first tile on the panel; 'd' prints both
+struct BootTiming {
+  bool wake;             // resumed from deep sleep instead of a cold boot
+  bool looping;
+  bool painted;
+  uint32_t inputUs;      // first loop() pass, presses count from here on
+  uint32_t firstPixelUs;
+
+  void update(uint32_t loopStartUs) {
+    if (!looping) {
+      looping = true;
+      inputUs = loopStartUs;
+    }
+    if (!painted && displayStats().paintSeq) {
+      painted = true;
+      firstPixelUs = displayStats().paintUs;
+    }
+  }
+} bootTiming;
+
 // ================= SETUP =================
 void setup() {
   Serial.begin(115200);
   forceHardReset();
+  stateFx.begin();
+  sceneFx.begin();
 
-  pinMode(BTN_YES_PIN, INPUT_PULLUP);
-  pinMode(BTN_NO_PIN, INPUT_PULLUP);
+  buttonsBegin(BTN_YES_PIN, BTN_NO_PIN, DEBOUNCE_DELAY);
+  idleBegin(BTN_YES_PIN, BTN_NO_PIN);
 
   Wire.begin();
-  u8g2.begin();
+  displayBegin(u8g2); // panel init runs in the display task
 
-  lastBtnYesReading = digitalRead(BTN_YES_PIN);
-  lastBtnNoReading = digitalRead(BTN_NO_PIN);
-  btnYesStable = lastBtnYesReading;
-  btnNoStable = lastBtnNoReading;
+#ifdef PROFILER
+  bodyOut.profileAs(PROF_SHOW_BODY);
+  buttonOut.profileAs(PROF_SHOW_BUTTONS);
+#endif
 
-  animBoot();
-  lastActivityTime = millis();
+  bootTiming.wake = resumeFromSleep();
+  if (!bootTiming.wake) animBoot();
+  noteActivity(millis());
 }
 
-// ================= LOOP =================
-void loop() {
-  unsigned long now = millis();
-  
-  // --- 1. INPUT READING ---
-  bool readYes = digitalRead(BTN_YES_PIN);
-  bool readNo = digitalRead(BTN_NO_PIN);
-  bool btnPressed = false;
-  bool isYesBtn = false; 
-
-  if (readYes != lastBtnYesReading || readNo != lastBtnNoReading) {
-    lastDebounceTime = now;
+// ================= TRANSITION TABLE =================
+// Every state lists what YES, NO and its timeout do. An action draws the
+// screen for the transition and returns the state actually entered: its
+// `next`, its `alt` (for guarded branches) or STATE_NONE to ignore the event.
+enum TimeoutFrom : uint8_t {
+  FROM_ENTRY,          // counted from entering the state
+  FROM_TYPEWRITER_END  // counted from when its text finished typing
+};
+
+struct Transition;
+typedef AppState (*TransitionAction)(const Transition& t, AppEvent ev, unsigned long now);
+
+struct Transition {
+  AppState next = STATE_UNSET;
+  AppState alt = STATE_NONE;
+  TransitionAction action = nullptr;
+};
+
+struct StateRow {
+  AppState state;
+  uint16_t timeoutMs;  // 0 = no timeout
+  TimeoutFrom from;
+  Transition on[EVT_COUNT];
+};
+
+// ---- actions ----
+AppState actIntro1(const Transition& t, AppEvent, unsigned long) {
+  showIntroMessage(MSG_INTRO_1);
+  return t.next;
+}
+
+AppState actValentineCheck(const Transition& t, AppEvent, unsigned long) {
+  startNonBlockingTypewriter(MSG_VALENTINE_CHECK);
+  return t.next;
+}
+
+AppState actRemember(const Transition& t, AppEvent, unsigned long) {
+  showRememberScreen();
+  return t.next;
+}
+
+AppState actGoodnight(const Transition& t, AppEvent, unsigned long) {
+  startNonBlockingTypewriter(MSG_GOODNIGHT);
+  return t.next;
+}
+
+AppState actGreenYes(const Transition& t, AppEvent, unsigned long) {
+  showGreenYesScreen();
+  return t.next;
+}
+
+AppState actRedNo(const Transition& t, AppEvent, unsigned long) {
+  showRedNoScreen();
+  return t.next;
+}
+
+AppState actIntro2(const Transition& t, AppEvent, unsigned long) {
+  startNonBlockingTypewriter(MSG_INTRO_2_1, MSG_INTRO_2_2);
+  return t.next;
+}
+
+AppState actIntro3(const Transition& t, AppEvent, unsigned long) {
+  showIntroMessage(MSG_INTRO_3);
+  return t.next;
+}
+
+AppState actIntro4(const Transition& t, AppEvent, unsigned long) {
+  startNonBlockingTypewriter(MSG_INTRO_4_1, MSG_INTRO_4_2);
+  return t.next;
+}
+
+AppState actCuteAnswer(const Transition& t, AppEvent ev, unsigned long) {
+  lastCuteResponseWasYes = (ev == EVT_YES);
+  if (lastCuteResponseWasYes) showPassportHappyScreen();
+  else showPassportBadScreen();
+  return t.next;
+}
+
+// Only advance to next intro message if they said yes, else ask again
+AppState actAfterCuteAnswer(const Transition& t, AppEvent, unsigned long) {
+  if (lastCuteResponseWasYes) {
+    startNonBlockingTypewriter(MSG_INTRO_5);
+    return t.next;
   }
-  lastBtnYesReading = readYes;
-  lastBtnNoReading = readNo;
+  startNonBlockingTypewriter(MSG_INTRO_4_1, MSG_INTRO_4_2);
+  return t.alt;
+}
 
-  if ((now - lastDebounceTime) > DEBOUNCE_DELAY) {
-    if (readYes != btnYesStable) {
-      btnYesStable = readYes;
-      if (btnYesStable == LOW) { btnPressed = true; isYesBtn = true; }
-    }
-    if (readNo != btnNoStable) {
-      btnNoStable = readNo;
-      if (btnNoStable == LOW) { btnPressed = true; isYesBtn = false; }
-    }
+AppState actIntro6(const Transition& t, AppEvent, unsigned long) {
+  startNonBlockingTypewriter(MSG_INTRO_6);
+  return t.next;
+}
+
+AppState actValentine(const Transition& t, AppEvent, unsigned long) {
+  introDone = true;
+  showValentineScreen();
+  return t.next;
+}
+
+AppState actWinStandard(const Transition& t, AppEvent, unsigned long) {
+  startNonBlockingTypewriter(MSG_WIN_STD_1, MSG_WIN_STD_2, MSG_WIN_STD_3);
+  return t.next;
+}
+
+AppState actWinFinal(const Transition& t, AppEvent, unsigned long) {
+  startNonBlockingTypewriter(MSG_WIN_FINAL_1, MSG_WIN_FINAL_2, MSG_WIN_FINAL_3);
+  return t.next;
+}
+
+AppState actNoAnswer(const Transition& t, AppEvent, unsigned long) {
+  noCount++;
+  if (noCount >= TRIGGER_COUNT) {
+    startNonBlockingTypewriter(MSG_TRICK_PROMPT);
+    return t.alt;
   }
+  startNonBlockingTypewriter(NO_RESPONSES[noCount - 1]);
+  return t.next;
+}
 
-  // --- 2. LOGIC ---
-  if (btnPressed) {
-    lastActivityTime = now; 
+// IMMEDIATE UPDATE BEFORE TEXT STARTS
+AppState actTrickReveal(const Transition& t, AppEvent ev, unsigned long) {
+  buttonStrip.clear();
+  if (ev == EVT_YES) { 
+    buttonStrip.setPixelColor(0, buttonStrip.Color(255, 0, 0)); 
+    buttonStrip.setPixelColor(2, buttonStrip.Color(0, 255, 0));
+  } else { 
+    buttonStrip.setPixelColor(0, buttonStrip.Color(0, 255, 0));
+    buttonStrip.setPixelColor(2, buttonStrip.Color(255, 0, 0)); 
+  }
+  buttonOut.showNow(); // FORCE SHOW NOW
 
-    // INTRO SEQUENCE NAVIGATION
-    if (currentState == STATE_INTRO_DOLPHIN) {
-      currentState = STATE_INTRO_1;
-      showIntroMessage(MSG_INTRO_1);
-    }
-    else if (currentState == STATE_INTRO_1) {
-      currentState = STATE_VALENTINE_CHECK;
-      startNonBlockingTypewriter(MSG_VALENTINE_CHECK);
-    }
-    else if (currentState == STATE_VALENTINE_CHECK) {
-      if (isYesBtn) {
-        currentState = STATE_INTRO_REMEMBER;
-        showRememberScreen();
-      } else {
-        currentState = STATE_GOODNIGHT;
-        startNonBlockingTypewriter(MSG_GOODNIGHT);
-        stateStartTime = now;
-      }
-    }
-    else if (currentState == STATE_INTRO_REMEMBER) {
-      currentState = STATE_INTRO_GREEN;
-      showGreenYesScreen();
-    }
-    else if (currentState == STATE_INTRO_GREEN) {
-      currentState = STATE_INTRO_RED;
-      showRedNoScreen();
-    }
-    else if (currentState == STATE_INTRO_RED) {
-      currentState = STATE_INTRO_2;
-      startNonBlockingTypewriter(MSG_INTRO_2_1, MSG_INTRO_2_2);
-    }
-    else if (currentState == STATE_INTRO_2) {
-      currentState = STATE_INTRO_3;
-      showIntroMessage(MSG_INTRO_3);
-    }
-    else if (currentState == STATE_INTRO_3) {
-      currentState = STATE_INTRO_4;
-      startNonBlockingTypewriter(MSG_INTRO_4_1, MSG_INTRO_4_2);
-    }
-    else if (currentState == STATE_INTRO_4) {
-      currentState = STATE_CUTE_RESPONSE;
-      if (isYesBtn) {
-        lastCuteResponseWasYes = true;
-        showPassportHappyScreen();
-      } else {
-        lastCuteResponseWasYes = false;
-        showPassportBadScreen();
-      }
-      stateStartTime = now; // Start timer for auto-advance
-    }
-    else if (currentState == STATE_INTRO_5) {
-      currentState = STATE_INTRO_6;
-      startNonBlockingTypewriter(MSG_INTRO_6);
-    }
-    else if (currentState == STATE_INTRO_6) {
-      currentState = STATE_IDLE;
-      showValentineScreen();
-    }
-    // STATE_CUTE_RESPONSE is handled by auto-advance timer, no manual button handling needed
-    // MAIN VALENTINE SEQUENCE
-    else if (currentState == STATE_CELEBRATION) {
-      if (now - stateStartTime > 500) { 
-        currentState = STATE_JOB_DONE;
-        startNonBlockingTypewriter(MSG_JOB_DONE_1, MSG_JOB_DONE_2);
-        stateStartTime = now;
-        lastActivityTime = now; 
-      }
-    }
-    else if (currentState == STATE_JOB_DONE) {
-      currentState = STATE_LEAVE_QUESTION;
-      startNonBlockingTypewriter(MSG_LEAVE_QUESTION);
-    }
-    else if (currentState == STATE_LEAVE_QUESTION) {
-      if (isYesBtn) {
-        // Go directly to deep sleep
-        animShutdown();
-        esp_deep_sleep_enable_gpio_wakeup(1ULL << BTN_YES_GPIO, ESP_GPIO_WAKEUP_GPIO_LOW);
-        delay(100);
-        esp_deep_sleep_start();
-      } else {
-        currentState = STATE_DEFIANT_RESPONSE;
-        startNonBlockingTypewriter(MSG_CANT_CONTROL_1, MSG_CANT_CONTROL_2);
-        stateStartTime = now;
-      }
-    }
-    else if (currentState == STATE_DEFIANT_RESPONSE) {
-      // Any button press goes directly to deep sleep
-      animShutdown();
-      esp_deep_sleep_enable_gpio_wakeup(1ULL << BTN_YES_GPIO, ESP_GPIO_WAKEUP_GPIO_LOW);
-      delay(100);
-      esp_deep_sleep_start();
-    }
-    else if (currentState == STATE_FINAL_PLEA) {
-      currentState = STATE_CELEBRATION;
-      startNonBlockingTypewriter(MSG_WIN_FINAL_1, MSG_WIN_FINAL_2, MSG_WIN_FINAL_3);
-      stateStartTime = now;
-    }
-    else if (currentState == STATE_FAIR_RIGHT) {
-      if (isYesBtn) {
-        currentState = STATE_CELEBRATION;
-        startNonBlockingTypewriter(MSG_WIN_STD_1, MSG_WIN_STD_2, MSG_WIN_STD_3);
-        stateStartTime = now;
-      } else {
-        currentState = STATE_FINAL_PLEA;
-        showControlScreen1();
-        controlScreenStartTime = now;
-        showingControlScreen2 = false;
-      }
-    }
-    else if (currentState == STATE_SWAP_MODE) {
-      // IMMEDIATE UPDATE BEFORE TEXT STARTS
-      isTrickReveal = true; 
-      
-      buttonStrip.clear();
-      if (isYesBtn) { 
-        buttonStrip.setPixelColor(0, buttonStrip.Color(255, 0, 0)); 
-        buttonStrip.setPixelColor(2, buttonStrip.Color(0, 255, 0));
-      } else { 
-        buttonStrip.setPixelColor(0, buttonStrip.Color(0, 255, 0));
-        buttonStrip.setPixelColor(2, buttonStrip.Color(255, 0, 0)); 
-      }
-      buttonStrip.show(); // FORCE SHOW NOW
+  startNonBlockingTypewriter(MSG_TRICK_REVEAL); 
+  return t.next;
+}
+
+AppState actFairRight(const Transition& t, AppEvent, unsigned long) {
+  startNonBlockingTypewriter(MSG_FAIR_1, MSG_FAIR_2);
+  return t.next;
+}
+
+AppState actControlScreen(const Transition& t, AppEvent, unsigned long) {
+  showControlScreen1();
+  showingControlScreen2 = false;
+  return t.next;
+}
+
+// Re-entering STATE_FINAL_PLEA restarts its 1.5s timer
+AppState actToggleControlScreen(const Transition& t, AppEvent, unsigned long) {
+  if (!showingControlScreen2) showControlScreen2();
+  else showControlScreen1();
+  showingControlScreen2 = !showingControlScreen2;
+  return t.next;
+}
 
-      startNonBlockingTypewriter(MSG_TRICK_REVEAL); 
-      trickRevealStartTime = now;
-      trickRevealWaiting = true;
+// Ignore presses in the first 500ms so the winning press doesn't skip it
+AppState actCelebrationDone(const Transition& t, AppEvent, unsigned long now) {
+  if (now - stateStartTime <= 500) return STATE_NONE;
+  startNonBlockingTypewriter(MSG_JOB_DONE_1, MSG_JOB_DONE_2);
+  noteActivity(now);
+  return t.next;
+}
+
+AppState actFinalAnimation(const Transition& t, AppEvent, unsigned long now) {
+  showFinalAnimationScreen();
+  noteActivity(now);
+  return t.next;
+}
+
+AppState actJobDone(const Transition& t, AppEvent, unsigned long now) {
+  startNonBlockingTypewriter(MSG_JOB_DONE_1, MSG_JOB_DONE_2);
+  noteActivity(now);
+  return t.next;
+}
+
+AppState actLeaveQuestion(const Transition& t, AppEvent, unsigned long) {
+  startNonBlockingTypewriter(MSG_LEAVE_QUESTION);
+  return t.next;
+}
+
+AppState actDefiant(const Transition& t, AppEvent, unsigned long) {
+  startNonBlockingTypewriter(MSG_CANT_CONTROL_1, MSG_CANT_CONTROL_2);
+  return t.next;
+}
+
+// GOODNIGHT's timeout, or the leave question answered
+AppState actShutdown(const Transition& t, AppEvent, unsigned long) {
+  animShutdown(currentState == STATE_GOODNIGHT ? STATE_GOODNIGHT : STATE_SHUTDOWN);
+  return t.next;
+}
+
+#define GO(to, fn)          Transition{ to, STATE_NONE, fn }
+#define GO_OR(to, alt, fn)  Transition{ to, alt, fn }
+#define IGNORED             Transition{ STATE_NONE, STATE_NONE, nullptr }
+
+//  state                   timeout ms            counted from         { YES, NO, TIMEOUT }
+constexpr StateRow TRANSITIONS[STATE_COUNT] = {
+  { STATE_INTRO_DOLPHIN,    0,                   FROM_ENTRY,          { GO(STATE_INTRO_1, actIntro1), GO(STATE_INTRO_1, actIntro1), IGNORED } },
+  { STATE_INTRO_1,          0,                   FROM_ENTRY,          { GO(STATE_VALENTINE_CHECK, actValentineCheck), GO(STATE_VALENTINE_CHECK, actValentineCheck), IGNORED } },
+  { STATE_VALENTINE_CHECK,  0,                   FROM_ENTRY,          { GO(STATE_INTRO_REMEMBER, actRemember), GO(STATE_GOODNIGHT, actGoodnight), IGNORED } },
+  { STATE_GOODNIGHT,        2000,                FROM_ENTRY,          { IGNORED, IGNORED, GO(STATE_SHUTDOWN, actShutdown) } },
+  { STATE_INTRO_REMEMBER,   0,                   FROM_ENTRY,          { GO(STATE_INTRO_GREEN, actGreenYes), GO(STATE_INTRO_GREEN, actGreenYes), IGNORED } },
+  { STATE_INTRO_GREEN,      0,                   FROM_ENTRY,          { GO(STATE_INTRO_RED, actRedNo), GO(STATE_INTRO_RED, actRedNo), IGNORED } },
+  { STATE_INTRO_RED,        0,                   FROM_ENTRY,          { GO(STATE_INTRO_2, actIntro2), GO(STATE_INTRO_2, actIntro2), IGNORED } },
+  { STATE_INTRO_2,          0,                   FROM_ENTRY,          { GO(STATE_INTRO_3, actIntro3), GO(STATE_INTRO_3, actIntro3), IGNORED } },
+  { STATE_INTRO_3,          0,                   FROM_ENTRY,          { GO(STATE_INTRO_4, actIntro4), GO(STATE_INTRO_4, actIntro4), IGNORED } },
+  { STATE_INTRO_4,          0,                   FROM_ENTRY,          { GO(STATE_CUTE_RESPONSE, actCuteAnswer), GO(STATE_CUTE_RESPONSE, actCuteAnswer), IGNORED } },
+  { STATE_CUTE_RESPONSE,    2000,                FROM_ENTRY,          { IGNORED, IGNORED, GO_OR(STATE_INTRO_5, STATE_INTRO_4, actAfterCuteAnswer) } },
+  { STATE_INTRO_5,          0,                   FROM_ENTRY,          { GO(STATE_INTRO_6, actIntro6), GO(STATE_INTRO_6, actIntro6), IGNORED } },
+  { STATE_INTRO_6,          0,                   FROM_ENTRY,          { GO(STATE_IDLE, actValentine), GO(STATE_IDLE, actValentine), IGNORED } },
+  { STATE_IDLE,             0,                   FROM_ENTRY,          { GO(STATE_CELEBRATION, actWinStandard), GO_OR(STATE_NO_RESPONSE, STATE_SWAP_MODE, actNoAnswer), IGNORED } },
+  { STATE_NO_RESPONSE,      2000,                FROM_TYPEWRITER_END, { IGNORED, IGNORED, GO(STATE_IDLE, actValentine) } },
+  { STATE_SWAP_MODE,        0,                   FROM_ENTRY,          { GO(STATE_TRICK_REVEAL, actTrickReveal), GO(STATE_TRICK_REVEAL, actTrickReveal), IGNORED } },
+  { STATE_TRICK_REVEAL,     2000,                FROM_ENTRY,          { GO(STATE_TRICK_REVEAL, actTrickReveal), GO(STATE_TRICK_REVEAL, actTrickReveal), GO(STATE_FAIR_RIGHT, actFairRight) } },
+  { STATE_FAIR_RIGHT,       0,                   FROM_ENTRY,          { GO(STATE_CELEBRATION, actWinStandard), GO(STATE_FINAL_PLEA, actControlScreen), IGNORED } },
+  { STATE_FINAL_PLEA,       1500,                FROM_ENTRY,          { GO(STATE_CELEBRATION, actWinFinal), GO(STATE_CELEBRATION, actWinFinal), GO(STATE_FINAL_PLEA, actToggleControlScreen) } },
+  { STATE_CELEBRATION,      CELEBRATION_DURATION, FROM_ENTRY,         { GO(STATE_JOB_DONE, actCelebrationDone), GO(STATE_JOB_DONE, actCelebrationDone), GO(STATE_FINAL_ANIMATION, actFinalAnimation) } },
+  { STATE_FINAL_ANIMATION,  5000,                FROM_ENTRY,          { IGNORED, IGNORED, GO(STATE_JOB_DONE, actJobDone) } },
+  { STATE_JOB_DONE,         4000,                FROM_ENTRY,          { GO(STATE_LEAVE_QUESTION, actLeaveQuestion), GO(STATE_LEAVE_QUESTION, actLeaveQuestion), GO(STATE_LEAVE_QUESTION, actLeaveQuestion) } },
+  { STATE_LEAVE_QUESTION,   0,                   FROM_ENTRY,          { GO(STATE_SHUTDOWN, actShutdown), GO(STATE_DEFIANT_RESPONSE, actDefiant), IGNORED } },
+  { STATE_DEFIANT_RESPONSE, 3000,                FROM_ENTRY,          { GO(STATE_SHUTDOWN, actShutdown), GO(STATE_SHUTDOWN, actShutdown), GO(STATE_SHUTDOWN, actShutdown) } },
+  { STATE_SHUTDOWN,         0,                   FROM_ENTRY,          { IGNORED, IGNORED, IGNORED } },
+};
+
+// ---- compile-time checks ----
+constexpr bool tableRowsInOrder() {
+  for (int s = 0; s < STATE_COUNT; s++) {
+    if (TRANSITIONS[s].state != s) return false;
+  }
+  return true;
+}
+
+constexpr bool tableComplete() {
+  for (int s = 0; s < STATE_COUNT; s++) {
+    const StateRow& row = TRANSITIONS[s];
+    for (int e = 0; e < EVT_COUNT; e++) {
+      const Transition& t = row.on[e];
+      if (t.next == STATE_UNSET) return false;
+      if (t.next != STATE_NONE && !t.action) return false;
     }
-    else if (currentState == STATE_IDLE) {
-      if (isYesBtn) {
-        currentState = STATE_CELEBRATION;
-        startNonBlockingTypewriter(MSG_WIN_STD_1, MSG_WIN_STD_2, MSG_WIN_STD_3);
-        stateStartTime = now;
-      } else {
-        noCount++;
-        if (noCount >= TRIGGER_COUNT) {
-          currentState = STATE_SWAP_MODE;
-          startNonBlockingTypewriter(MSG_TRICK_PROMPT);
-        } else {
-          currentState = STATE_NO_RESPONSE;
-          startNonBlockingTypewriter(NO_RESPONSES[noCount - 1]);
-          startNoResponseTimer();
+    // A timeout needs somewhere to go, and a timeout transition needs a timeout
+    bool hasTimeout = row.on[EVT_TIMEOUT].next != STATE_NONE;
+    if (hasTimeout != (row.timeoutMs > 0)) return false;
+    // Only the shutdown fade may be a dead end
+    bool hasExit = hasTimeout || row.on[EVT_YES].next != STATE_NONE || row.on[EVT_NO].next != STATE_NONE;
+    if (hasExit == (s == STATE_SHUTDOWN)) return false;
+  }
+  return true;
+}
+
+constexpr bool allStatesReachable() {
+  bool seen[STATE_COUNT] = {};
+  AppState queue[STATE_COUNT] = {};
+  int head = 0, tail = 0;
+  seen[STATE_INTRO_DOLPHIN] = true;
+  queue[tail++] = STATE_INTRO_DOLPHIN;
+  while (head < tail) {
+    const StateRow& row = TRANSITIONS[queue[head++]];
+    for (int e = 0; e < EVT_COUNT; e++) {
+      AppState targets[2] = { row.on[e].next, row.on[e].alt };
+      for (AppState to : targets) {
+        if (to < STATE_COUNT && !seen[to]) {
+          seen[to] = true;
+          queue[tail++] = to;
         }
       }
     }
   }
+  return tail == STATE_COUNT;
+}
+
+static_assert(tableRowsInOrder(), "TRANSITIONS rows must follow the AppState order");
+static_assert(tableComplete(), "TRANSITIONS has a missing or inconsistent transition");
+static_assert(allStatesReachable(), "TRANSITIONS leaves a state unreachable");
+
+// ---- runtime ----
+void dispatchEvent(AppEvent ev, unsigned long now) {
+  const Transition& t = TRANSITIONS[currentState].on[ev];
+  if (t.next == STATE_NONE) return;
+
+  uint32_t flushes = displayStats().frames;
+  AppState from = currentState; // some actions already switch it (shutdown)
+  AppState next = t.action(t, ev, now);
+  if (next == STATE_NONE) return; // guard said no
+
+  traceTransition(from, next, ev, flushes);
+  enterState(next, now);
+}
+
+// Arms the timeout of the state just entered. One counted from the end of
+// its text waits for typewriterDone() if that is still typing.
+void enterState(AppState next, unsigned long now) {
+  currentState = next;
+  stateStartTime = now;
+  const StateRow& row = TRANSITIONS[next];
+  if (row.timeoutMs == 0 || (row.from == FROM_TYPEWRITER_END && typewriterActive)) timers.cancel(stateTimer);
+  else timers.arm(stateTimer, now + row.timeoutMs + 1); // once more than timeoutMs have passed
+}
+
+void typewriterDone(unsigned long now) {
+  const StateRow& row = TRANSITIONS[currentState];
+  if (row.timeoutMs && row.from == FROM_TYPEWRITER_END) timers.arm(stateTimer, now + row.timeoutMs + 1);
+}
+
+void onStateTimeout(Timer&, uint32_t now) {
+  dispatchEvent(EVT_TIMEOUT, now);
+}
+
+void onInactivity(Timer&, uint32_t) {
+  if (currentState == STATE_SHUTDOWN) return;
+  uint32_t flushes = displayStats().frames;
+  AppState from = currentState;
+  animShutdown();
+  traceTransition(from, STATE_SHUTDOWN, EVT_INACTIVITY, flushes);
+}
+
+void handleButtonPress(bool isYesBtn, unsigned long now) {
+  noteActivity(now);
+  if (sceneFx.current() == &BOOT_FX) sceneFx.play(nullptr, now); // skip the LED boot
+  dispatchEvent(isYesBtn ? EVT_YES : EVT_NO, now);
+}
+
+// ================= BENCHMARKS =================
+#ifdef BENCH
+// Cases for 'B' (see bench.h). prepare() sets up the state a case needs;
+// runBenchmarks() puts the app back afterwards.
+static void benchSetState(uint32_t state) {
+  sceneStop();
+  sceneFx.play(nullptr, 0);
+  currentState = (AppState)state;
+}
+
+static void benchUpdateLeds(uint32_t) {
+  updateLEDs();
+}
+
+// A whole LED frame the way loop() makes one: updateLEDs() with the clips on
+// top, the current budget, then both strips out (showNow(), the refresh cap
+// aside). A black frame goes out first, so the timed one is a change, and
+// the line is idle again before it.
+static void benchLedFramePrepare(uint32_t state) {
+  benchSetState(state);
+  bodyStrip.clear();
+  buttonStrip.clear();
+  bodyOut.showNow();
+  buttonOut.showNow();
+  while (bodyOut.busy() || buttonOut.busy()) {}
+  delayMicroseconds(LED_RESET_US);
+}
+
+static void benchLedFrame(uint32_t) {
+  updateLEDs();
+  ledPower.update(millis(), currentState);
+  bodyOut.showNow();
+  buttonOut.showNow();
+}
+
+// Halfway through the longest line
+static void benchTypewriterPrepare(uint32_t) {
+  startNonBlockingTypewriter(MSG_CANT_CONTROL_1);
+  typewriterCharIndex = typewriterText[0].len / 2;
+}
+
+static void benchTypewriterTick(uint32_t) {
+  updateNonBlockingTypewriter();
+}
+
+// The last tick of the final win caption, which from the warmup on is a
+// frame cache hit on all three of its lines
+static void benchTypewriterFinishPrepare(uint32_t) {
+  currentState = STATE_CELEBRATION; // no timeout counted from the typing
+  startNonBlockingTypewriter(MSG_WIN_FINAL_1, MSG_WIN_FINAL_2, MSG_WIN_FINAL_3);
+  typewriterLine = 3;
+  typewriterCharIndex = typewriterText[2].len;
+}
+
+static void benchDisplaySync(uint32_t) {
+  displaySync();
+}
+
+static void benchFinalAnimation(uint32_t) {
+  showFinalAnimationScreen();
+}
+
+static void benchBlit(uint32_t id) {
+  bitmapDraw(u8g2, 0, 0, (BitmapId)id);
+}
+
+static void benchSetFont(uint32_t) {
+  u8g2.setFont(u8g2_font_t0_13b_tr);
+}
+
+static void benchStrWidth(uint32_t) {
+  benchSink = u8g2.getStrWidth(MSG_CANT_CONTROL_1);
+}
+
+static void benchTextWidth(uint32_t) {
+  TextView text = textView(MSG_CANT_CONTROL_1);
+  benchSink = textWidth(u8g2, text, text.len);
+}
+
+// The fixed text of a screen through drawStr() and through its sprites
+#define BENCH_CENTRED 0xFF // x of a finished typewriter line
+
+struct BenchScreen {
+  const uint8_t* font;
+  uint8_t count;
+  struct { uint8_t x, y; const char* const* msg; } lines[2];
+};
+
+static const BenchScreen BENCH_SCREENS[] = {
+  { u8g2_font_t0_13b_tr, 2, { { 11, 18, &MSG_IDLE_1 }, { 3, 33, &MSG_IDLE_2 } } },
+  { u8g2_font_ncenB08_tr, 2, { { 0, 11, &MSG_CONTROL_1 }, { 73, 59, &MSG_CONTROL_2 } } },
+  { u8g2_font_t0_13b_tr, 1, { { 29, 11, &MSG_CONTROL_3 } } },
+  { u8g2_font_t0_13b_tr, 1, { { 55, 23, &MSG_CONTROL_US } } },
+  { u8g2_font_t0_13b_tr, 2, { { BENCH_CENTRED, 25, &MSG_INTRO_4_1 }, { BENCH_CENTRED, 45, &MSG_INTRO_4_2 } } },
+};
+
+static void benchScreenPrepare(uint32_t screen) {
+  u8g2.clearBuffer();
+  u8g2.setFont(BENCH_SCREENS[screen].font);
+  u8g2.setFontMode(1);
+  u8g2.setDrawColor(1);
+}
+
+static void benchScreenText(uint32_t screen, bool sprites) {
+  const BenchScreen& s = BENCH_SCREENS[screen];
+  for (uint8_t i = 0; i < s.count; i++) {
+    TextView text = textView(*s.lines[i].msg);
+    int x = s.lines[i].x;
+    if (x == BENCH_CENTRED) x = (128 - textWidth(u8g2, text, text.len)) / 2;
+    if (sprites) textDraw(u8g2, x, s.lines[i].y, text, text.len);
+    else u8g2.drawStr(x, s.lines[i].y, text.str);
+  }
+}
+
+static void benchScreenDrawStr(uint32_t screen) {
+  benchScreenText(screen, false);
+}
+
+static void benchScreenSprites(uint32_t screen) {
+  benchScreenText(screen, true);
+}
+
+// One glyph through u8g2's list walk and through the subset's index. ' ' is
+// first in the list, 'e' past the 'a' jump and 'y' near the end of it.
+static void benchGlyphU8g2(uint32_t c) {
+  benchSink = u8g2.drawGlyph(40, 30, c);
+}
 
-  // --- 3. AUTO RESET & AUTO-ADVANCE ---
-  if (currentState == STATE_CELEBRATION && (now - stateStartTime > CELEBRATION_DURATION)) {
-      currentState = STATE_FINAL_ANIMATION;
-      showFinalAnimationScreen();
-      stateStartTime = now;
-      lastActivityTime = now; 
+static void benchGlyphIndexed(uint32_t c) {
+  benchSink = fontDrawGlyph(u8g2, *fontFind(u8g2_font_t0_13b_tr), 40, 30, c);
+}
+
+// The float math updateLEDs() used before led_math.h, against the kernels
+// that replaced it
+static void benchIdleFloat(uint32_t) {
+  unsigned long now = millis();
+  uint32_t acc = 0;
+  BodyLayout::forEach([&](uint16_t, uint32_t offsetMs) {
+    float breathe = (exp(sin((now - offsetMs) / 2500.0 * PI)) - 0.36787944) * 108.0;
+    acc += map(breathe, 0, 255, 20, 100);
+  });
+  acc += 80 + (int)(sin(now / 800.0) * 60);
+  acc += 100 + (int)(sin(now / 150.0) * 100);
+  benchSink = acc;
+}
+
+static void benchIdleFixed(uint32_t) {
+  unsigned long now = millis();
+  uint32_t acc = 0;
+  BodyLayout::forEach([&](uint16_t, uint32_t offsetMs) { acc += ledBreathe(now - offsetMs); });
+  acc += ledSoftPulse(now);
+  acc += ledPanicPulse(now);
+  benchSink = acc;
+}
+
+static void benchCelebrationFloat(uint32_t) {
+  unsigned long now = millis();
+  uint32_t acc = 0;
+  for (int i = 0; i < BodyLayout::active; i++) {
+    float wave = 0.5 + 0.5 * sin((now / 800.0 * PI) + (i * 0.5));
+    acc += (int)(20 + 80 * wave) + (int)(30 + 90 * wave);
   }
-  
-  // Auto-advance from final animation to job completion after 5 seconds
-  if (currentState == STATE_FINAL_ANIMATION && (now - stateStartTime > 5000)) {
-      currentState = STATE_JOB_DONE;
-      startNonBlockingTypewriter(MSG_JOB_DONE_1, MSG_JOB_DONE_2);
-      stateStartTime = now;
-      lastActivityTime = now; 
+  acc += 100 + (int)(sin(now / 300.0) * 155);
+  benchSink = acc;
+}
+
+static void benchCelebrationFixed(uint32_t) {
+  unsigned long now = millis();
+  uint32_t acc = 0;
+  for (int i = 0; i < BodyLayout::active; i++) {
+    uint32_t wave = ledWave(now, i);
+    acc += (20 + ((80 * wave) >> 16)) + (30 + ((90 * wave) >> 16));
   }
-  
-  // Auto-advance from job done to leave question after 4 seconds
-  if (currentState == STATE_JOB_DONE && (now - stateStartTime > 4000)) {
-    currentState = STATE_LEAVE_QUESTION;
-    startNonBlockingTypewriter(MSG_LEAVE_QUESTION);
-    stateStartTime = now;
+  acc += ledWinPulse(now);
+  benchSink = acc;
+}
+
+// Packed colour math (color.h) against the per-channel code it replaced:
+// the candle tint, a cross-fade of the body and a fade of the whole strip
+static uint8_t benchPixels[BodyLayout::physical * 3];
+static uint8_t benchTarget[BodyLayout::physical * 3];
+
+static void benchCandleChannels(uint32_t) {
+  uint32_t acc = 0;
+  for (int i = 0; i < BodyLayout::active; i++) {
+    int val = 20 + i * 9;
+    acc += bodyStrip.Color(val, val/4, val/3);
   }
-  
-  // Auto-advance from defiant response to deep sleep after 3 seconds
-  if (currentState == STATE_DEFIANT_RESPONSE && (now - stateStartTime > 3000)) {
-    animShutdown();
-    esp_deep_sleep_enable_gpio_wakeup(1ULL << BTN_YES_GPIO, ESP_GPIO_WAKEUP_GPIO_LOW);
-    delay(100);
-    esp_deep_sleep_start();
+  benchSink = acc;
+}
+
+static void benchCandleSwar(uint32_t) {
+  uint32_t acc = 0;
+  for (int i = 0; i < BodyLayout::active; i++) acc += colorScale(CANDLE, 20 + i * 9 + 1);
+  benchSink = acc;
+}
+
+static void benchLerpChannels(uint32_t) {
+  uint32_t acc = 0;
+  for (int i = 0; i < BodyLayout::active; i++) {
+    uint32_t a = colorRgb(180, 50, 80), b = colorRgb(20 + i * 9, 5 + i, 6 + i * 3);
+    uint8_t c[3];
+    for (uint8_t ch = 0; ch < 3; ch++) {
+      int32_t x = (a >> (16 - 8 * ch)) & 0xFF, y = (b >> (16 - 8 * ch)) & 0xFF;
+      c[ch] = x + (((y - x) * 100) >> 8);
+    }
+    acc += bodyStrip.Color(c[0], c[1], c[2]);
   }
-  
-  // Auto-advance from cute response after 2 seconds
-  if (currentState == STATE_CUTE_RESPONSE && (now - stateStartTime > 2000)) {
-      if (lastCuteResponseWasYes) {
-        // Only advance to next intro message if they said yes
-        currentState = STATE_INTRO_5;
-        startNonBlockingTypewriter(MSG_INTRO_5);
-        stateStartTime = now;
-      } else {
-        // Loop back to cute question if they said no
-        currentState = STATE_INTRO_4;
-        startNonBlockingTypewriter(MSG_INTRO_4_1, MSG_INTRO_4_2);
-        stateStartTime = now;
-      }
+  benchSink = acc;
+}
+
+static void benchLerpSwar(uint32_t) {
+  uint32_t acc = 0;
+  for (int i = 0; i < BodyLayout::active; i++) {
+    acc += colorLerp(colorRgb(180, 50, 80), colorRgb(20 + i * 9, 5 + i, 6 + i * 3), 100);
   }
-  
-  // Auto-advance from goodnight to deep sleep after 2 seconds
-  if (currentState == STATE_GOODNIGHT && (now - stateStartTime > 2000)) {
-    animShutdown();
-    esp_deep_sleep_enable_gpio_wakeup(1ULL << BTN_YES_GPIO, ESP_GPIO_WAKEUP_GPIO_LOW);
-    delay(100);
-    esp_deep_sleep_start();
+  benchSink = acc;
+}
+
+static void benchFillPixels(uint32_t) {
+  for (uint16_t i = 0; i < sizeof(benchPixels); i++) {
+    benchPixels[i] = i * 7;
+    benchTarget[i] = 255 - i * 3;
   }
+}
 
-  updateLEDs();
-  updateNonBlockingTypewriter();
-  updateIdleDisplay();
-  
-  // Handle NO response timer - start 2-second timer when typewriter finishes
-  if (showingNoResponse && currentState == STATE_NO_RESPONSE) {
-    if (!typewriterActive && !noResponseTimerStarted) {
-      // Typewriter just finished, start the 2-second timer now
-      noResponseDisplayTime = now;
-      noResponseTimerStarted = true;
-    }
-    if (noResponseTimerStarted && (now - noResponseDisplayTime > 2000)) {
-      // 2 seconds have passed since typewriter finished
-      showingNoResponse = false;
-      noResponseTimerStarted = false;
-      currentState = STATE_IDLE;
-      showValentineScreen();
-    }
+static void benchFadeChannels(uint32_t) {
+  for (uint16_t i = 0; i < BodyLayout::physical; i++) {
+    uint8_t* p = benchPixels + i * 3;
+    uint8_t r = p[1], g = p[0], b = p[2]; // GRB
+    r = r * 150 >> 8;
+    g = g * 150 >> 8;
+    b = b * 150 >> 8;
+    p[1] = r; p[0] = g; p[2] = b;
   }
-  
-  // Handle trick reveal timer
-  if (trickRevealWaiting && (now - trickRevealStartTime > 2000)) {
-    trickRevealWaiting = false;
-    isTrickReveal = false;
-    currentState = STATE_FAIR_RIGHT;
-    startNonBlockingTypewriter(MSG_FAIR_1, MSG_FAIR_2);
+}
+
+static void benchFadeSwar(uint32_t) {
+  colorScaleBuffer(benchPixels, sizeof(benchPixels), 150);
+}
+
+static void benchBlendSwar(uint32_t) {
+  colorLerpBuffer(benchPixels, benchTarget, sizeof(benchPixels), 100);
+}
+
+// One body frame against strip length, for builds far longer than ours:
+// the candle effect and the current estimate's channel sum, on a strip
+// that is never shown. 60 fps leaves 16.7 ms per frame; tools/bench.py
+// prints the cost per LED. The led_frame_* cases of a -DBODY_300 build
+// are the same 300 pixels through the real path.
+#define BENCH_MAX_LEDS 300
+static Adafruit_NeoPixel benchStrip(BENCH_MAX_LEDS, -1, NEO_GRB + NEO_KHZ800);
+
+using BenchBody30  = StripLayout<BENCH_MAX_LEDS, Segment<30, 40>>;
+using BenchBody60  = StripLayout<BENCH_MAX_LEDS, Segment<60, 40>>;
+using BenchBody120 = StripLayout<BENCH_MAX_LEDS, Segment<60, 40>, Segment<60, 40, 20>>;
+using BenchBody300 = StripLayout<BENCH_MAX_LEDS, Segment<100, 40>, Segment<100, 40, 20>, Segment<100, 40>>;
+
+template <typename Layout>
+static void benchBodyFrame(uint32_t) {
+  drawCandle<Layout>(benchStrip, millis());
+  const uint8_t* px = benchStrip.getPixels();
+  uint32_t sum = 0;
+  for (uint16_t i = 0; i < Layout::active * 3; i++) sum += px[i];
+  benchSink = ledFrameUa(sum);
+}
+
+static const BenchCase BENCH_FIXED_CASES[] = {
+  { "update_leds_idle",         benchSetState, benchUpdateLeds, STATE_IDLE },
+  { "update_leds_celebration",  benchSetState, benchUpdateLeds, STATE_CELEBRATION },
+  { "update_leds_swap_mode",    benchSetState, benchUpdateLeds, STATE_SWAP_MODE },
+  { "update_leds_final_plea",   benchSetState, benchUpdateLeds, STATE_FINAL_PLEA },
+  { "led_frame_idle",           benchLedFramePrepare, benchLedFrame, STATE_IDLE },
+  { "led_frame_celebration",    benchLedFramePrepare, benchLedFrame, STATE_CELEBRATION },
+#ifndef BODY_300
+  { "body_frame_9",             nullptr, benchBodyFrame<BodyLayout>, 0 },
+#endif
+  { "body_frame_30",            nullptr, benchBodyFrame<BenchBody30>, 0 },
+  { "body_frame_60",            nullptr, benchBodyFrame<BenchBody60>, 0 },
+  { "body_frame_120",           nullptr, benchBodyFrame<BenchBody120>, 0 },
+  { "body_frame_300",           nullptr, benchBodyFrame<BenchBody300>, 0 },
+  { "kernel_idle_float",        nullptr, benchIdleFloat, 0 },
+  { "kernel_idle_fixed",        nullptr, benchIdleFixed, 0 },
+  { "kernel_celebration_float", nullptr, benchCelebrationFloat, 0 },
+  { "kernel_celebration_fixed", nullptr, benchCelebrationFixed, 0 },
+  { "color_candle_channels",    nullptr, benchCandleChannels, 0 },
+  { "color_candle_swar",        nullptr, benchCandleSwar, 0 },
+  { "color_lerp_channels",      nullptr, benchLerpChannels, 0 },
+  { "color_lerp_swar",          nullptr, benchLerpSwar, 0 },
+  { "strip_fade_channels",      benchFillPixels, benchFadeChannels, 0 },
+  { "strip_fade_swar",          benchFillPixels, benchFadeSwar, 0 },
+  { "strip_blend_swar",         benchFillPixels, benchBlendSwar, 0 },
+  { "typewriter_tick",          benchTypewriterPrepare, benchTypewriterTick, 0 },
+  { "typewriter_finish_cached", benchTypewriterFinishPrepare, benchTypewriterTick, 0 },
+  { "final_animation_render",   benchDisplaySync, benchFinalAnimation, 0 },
+  { "str_width_longest",        benchSetFont, benchStrWidth, 0 },
+  { "text_width_longest",       benchSetFont, benchTextWidth, 0 },
+  { "glyph_u8g2_space",         benchSetFont, benchGlyphU8g2, ' ' },
+  { "glyph_indexed_space",      benchSetFont, benchGlyphIndexed, ' ' },
+  { "glyph_u8g2_e",             benchSetFont, benchGlyphU8g2, 'e' },
+  { "glyph_indexed_e",          benchSetFont, benchGlyphIndexed, 'e' },
+  { "glyph_u8g2_y",             benchSetFont, benchGlyphU8g2, 'y' },
+  { "glyph_indexed_y",          benchSetFont, benchGlyphIndexed, 'y' },
+  { "text_idle_drawstr",        benchScreenPrepare, benchScreenDrawStr, 0 },
+  { "text_idle_sprite",         benchScreenPrepare, benchScreenSprites, 0 },
+  { "text_control1_drawstr",    benchScreenPrepare, benchScreenDrawStr, 1 },
+  { "text_control1_sprite",     benchScreenPrepare, benchScreenSprites, 1 },
+  { "text_control2_drawstr",    benchScreenPrepare, benchScreenDrawStr, 2 },
+  { "text_control2_sprite",     benchScreenPrepare, benchScreenSprites, 2 },
+  { "text_final_drawstr",       benchScreenPrepare, benchScreenDrawStr, 3 },
+  { "text_final_sprite",        benchScreenPrepare, benchScreenSprites, 3 },
+  { "text_typed_lines_drawstr", benchScreenPrepare, benchScreenDrawStr, 4 },
+  { "text_typed_lines_sprite",  benchScreenPrepare, benchScreenSprites, 4 },
+};
+#define BENCH_FIXED_COUNT (sizeof(BENCH_FIXED_CASES) / sizeof(BENCH_FIXED_CASES[0]))
+
+void runBenchmarks() {
+  static BenchCase cases[BENCH_FIXED_COUNT + BMP_COUNT];
+  static char blitNames[BMP_COUNT][24];
+
+  memcpy(cases, BENCH_FIXED_CASES, sizeof(BENCH_FIXED_CASES));
+  for (uint8_t id = 0; id < BMP_COUNT; id++) {
+    snprintf(blitNames[id], sizeof(blitNames[id]), "blit_%s", bitmapInfo((BitmapId)id).name);
+    cases[BENCH_FIXED_COUNT + id] = { blitNames[id], nullptr, benchBlit, id };
   }
-  
-  // Handle control screen alternation
-  if (currentState == STATE_FINAL_PLEA && (now - controlScreenStartTime > 1500)) {
-    if (!showingControlScreen2) {
-      showControlScreen2();
-      showingControlScreen2 = true;
-    } else {
-      showControlScreen1();
-      showingControlScreen2 = false;
-    }
-    controlScreenStartTime = now;
+
+  AppState savedState = currentState;
+  benchRun(Serial, cases, BENCH_FIXED_COUNT + BMP_COUNT);
+
+  // The screen keeps the last case's frame until the next screen change
+  typewriterActive = false;
+  currentState = savedState;
+}
+#endif
+
+// ================= LOOP TIMING =================
+// Time of one loop() pass without the trailing delay, to see what the
+// display pipeline saves
+struct LoopTiming {
+  uint32_t passes;
+  uint32_t totalUs;
+  uint32_t maxUs;
+
+  void add(uint32_t us) {
+    passes++;
+    totalUs += us;
+    if (us > maxUs) maxUs = us;
   }
+} loopTiming;
+
+void printDisplayReport() {
+  displayPrintStats(Serial);
+  Serial.print("loop_avg_us,");
+  Serial.println(loopTiming.passes ? loopTiming.totalUs / loopTiming.passes : 0);
+  Serial.print("loop_max_us,");
+  Serial.println(loopTiming.maxUs);
+  Serial.print("boot,");
+  Serial.println(bootTiming.wake ? "wake" : "cold");
+  Serial.print("boot_input_us,");
+  Serial.println(bootTiming.inputUs);
+  Serial.print("boot_first_pixel_us,");
+  Serial.println(bootTiming.firstPixelUs);
+}
+
+// Names for the trace report, in AppState / AppEvent order
+static const char* const STATE_NAMES[] = {
+  "intro_dolphin", "intro_1", "valentine_check", "goodnight", "intro_remember",
+  "intro_green", "intro_red", "intro_2", "intro_3", "intro_4", "cute_response",
+  "intro_5", "intro_6", "idle", "no_response", "swap_mode", "trick_reveal",
+  "fair_right", "final_plea", "celebration", "final_animation", "job_done",
+  "leave_question", "defiant_response", "shutdown",
+};
+static_assert(sizeof(STATE_NAMES) / sizeof(STATE_NAMES[0]) == STATE_COUNT, "STATE_NAMES out of sync with AppState");
+
+static const char* const EVENT_NAMES[] = { "yes", "no", "timeout", "inactivity" };
+
+void printTraceReport() {
+  tracePrintReport(Serial, traceRecords(), traceCount(), STATE_NAMES, EVENT_NAMES);
+}
+
+void printLedReport() {
+  Serial.println("strip,shows_per_s,show_us_per_s,unchanged_per_s,deferred_per_s");
+  bodyOut.printStats(Serial, "body");
+  buttonOut.printStats(Serial, "buttons");
+}
+
+void printPowerReport() {
+  ledPower.printStats(Serial, STATE_NAMES, STATE_COUNT);
+}
 
-  // --- 4. SLEEP ---
-  if (now - lastActivityTime >= INACTIVITY_TIMEOUT) {
-    animShutdown();
-    esp_deep_sleep_enable_gpio_wakeup(1ULL << BTN_YES_GPIO, ESP_GPIO_WAKEUP_GPIO_LOW);
-    delay(100);
-    esp_deep_sleep_start();
+// ================= LOOP =================
+// The LED effects want a pass every LOOP_PERIOD_MS; a timer due sooner
+// (the next typewriter character) cuts the wait short. The wait itself is
+// light sleep when nothing is on its way out (see idle_sleep.h).
+#define LOOP_PERIOD_MS 10
+
+uint32_t loopWait() {
+  uint32_t at;
+  if (!timers.nextDeadline(at)) return LOOP_PERIOD_MS;
+  int32_t until = at - (uint32_t)millis();
+  return until <= 0 ? 0 : min((uint32_t)until, (uint32_t)LOOP_PERIOD_MS);
+}
+
+void loop() {
+  unsigned long now = millis();
+  uint32_t loopStartUs = micros();
+  PROFILE_MARK(PROF_LOOP_PERIOD);
+  PROFILE_BEGIN(PROF_LOOP);
+
+  {
+    PROFILE_SCOPE(PROF_INPUT);
+
+    // --- 1. INPUT READING ---
+    // Serial debug dumps: 'l' button latency histogram, 'b' bitmap sizes and
+    // decode times, 'd' display pipeline and loop timing, 'p' LED show() rates,
+    // 'm' LED current per state, 'i' duty cycle and light sleep per state,
+    // 'f' font subset sizes, 't'/'T' interaction trace dump/latency report,
+    // 'h'/'H' profiler histograms dump/clear (-DPROFILER builds), 'B'
+    // microbenchmarks as JSON (-DBENCH builds)
+    if (Serial.available()) {
+      switch (Serial.read()) {
+        case 'l': buttonsPrintLatency(Serial); break;
+        case 'b': bitmapPrintStats(Serial); break;
+        case 'd': printDisplayReport(); break;
+        case 'p': printLedReport(); break;
+        case 'm': printPowerReport(); break;
+        case 'i': idlePrintStats(Serial, STATE_NAMES, STATE_COUNT); break;
+        case 'f': fontPrintStats(Serial); break;
+        case 't': traceDump(Serial); break;
+        case 'T': printTraceReport(); break;
+#ifdef PROFILER
+        case 'h': profilePrint(Serial); break;
+        case 'H': profileReset(); break;
+#endif
+#ifdef BENCH
+        case 'B': runBenchmarks(); break;
+#endif
+      }
+    }
+
+    // --- 2. LOGIC ---
+    // Presses are consumed in edge order, so quick double taps all count
+    ButtonPress press;
+    while (buttonsPoll(press)) {
+      traceButton(press);
+      handleButtonPress(press.button == BUTTON_YES, now);
+    }
   }
+
+  // --- 3. AUTO-ADVANCE ---
+  // State timeouts, the typewriter and the inactivity shutdown
+  timers.advance(now);
+
+  updateLEDs();
+  sceneRun(now);
+  updateIdleDisplay();
+  ledPower.update(now, currentState);
+  bodyOut.update(now);
+  buttonOut.update(now);
+  
+  traceUpdate();
   
-  delay(10); 
+  bootTiming.update(loopStartUs);
+  loopTiming.add(micros() - loopStartUs);
+  PROFILE_END(PROF_LOOP);
+  idleWait(loopWait(), currentState, displayBusy() || bodyOut.busy() || buttonOut.busy());
 }
\ No newline at end of file
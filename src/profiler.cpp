@@ -0,0 +1,47 @@
+#include "profiler.h"
+
+#ifdef PROFILER
+
+ProfileHistogram profileHist[PROF_COUNT];
+uint32_t profileLastMark[PROF_COUNT];
+
+static const char* const PROFILE_NAMES[PROF_COUNT] = {
+  "loop", "loop_period", "input", "update_leds", "typewriter",
+  "idle_display", "display_flush", "send_frame", "show_body", "show_buttons",
+};
+
+void profileReset() {
+  memset(profileHist, 0, sizeof(profileHist));
+  memset(profileLastMark, 0, sizeof(profileLastMark));
+}
+
+void profilePrint(Print& out) {
+  out.print("ticks_per_us,");
+  out.println(CYCLES_PER_US);
+  out.print("name,samples,min,mean,max");
+  for (uint8_t k = 0; k < PROFILE_BUCKETS; k++) {
+    out.print(",b");
+    out.print(k);
+  }
+  out.println();
+
+  for (uint8_t id = 0; id < PROF_COUNT; id++) {
+    const ProfileHistogram& h = profileHist[id];
+    out.print(PROFILE_NAMES[id]);
+    out.print(',');
+    out.print(h.samples);
+    out.print(',');
+    out.print(h.minTicks);
+    out.print(',');
+    out.print(h.samples ? (uint32_t)(h.totalTicks / h.samples) : 0);
+    out.print(',');
+    out.print(h.maxTicks);
+    for (uint8_t k = 0; k < PROFILE_BUCKETS; k++) {
+      out.print(',');
+      out.print(h.counts[k]);
+    }
+    out.println();
+  }
+}
+
+#endif
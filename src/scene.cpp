@@ -0,0 +1,35 @@
+#include "scene.h"
+
+static SceneFn current = nullptr;
+static Scene state;
+static uint8_t generation = 0; // bumped whenever the running scene is replaced
+
+void sceneStart(SceneFn fn) {
+  current = fn;
+  memset(&state, 0, sizeof(state));
+  state.t0 = millis();
+  generation++;
+}
+
+void sceneStop() {
+  current = nullptr;
+  generation++;
+}
+
+bool sceneActive() {
+  return current != nullptr;
+}
+
+SceneFn sceneCurrent() {
+  return current;
+}
+
+void sceneRun(unsigned long now) {
+  if (!current) return;
+
+  uint8_t gen = generation;
+  bool running = current(state, now);
+
+  // A scene may start its successor from inside; don't clear that one
+  if (!running && gen == generation) sceneStop();
+}
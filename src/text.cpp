@@ -0,0 +1,93 @@
+#include "text.h"
+#include "text_layout.h"
+
+static const TextLayout* findLayout(const char* str, uint8_t len) {
+  for (const TextLayout& l : TEXT_LAYOUT) {
+    if (*l.message + l.start == str && l.len == len) return &l;
+  }
+  return nullptr;
+}
+
+TextView textView(const char* s) {
+  uint8_t len = s ? strlen(s) : 0;
+  return { s, len, findLayout(s, len) };
+}
+
+bool textSplitLine(TextView text, TextView& first, TextView& rest) {
+  const char* nl = (const char*)memchr(text.str, '\n', text.len);
+  if (!nl) return false;
+
+  uint8_t pos = nl - text.str;
+  uint8_t restLen = text.len - pos - 1;
+  first = { text.str, pos, findLayout(text.str, pos) };
+  rest = { nl + 1, restLen, findLayout(nl + 1, restLen) };
+  return true;
+}
+
+u8g2_uint_t textWidth(U8G2& display, TextView text, uint8_t n) {
+  if (n == 0) return 0;
+  if (text.layout && text.layout->font == display.getU8g2()->font) return text.layout->widths[n];
+
+  // getStrWidth() sums the advances, except that the last glyph counts with
+  // its real pixel width. Measuring that one glyph on its own gives exactly that.
+  u8g2_uint_t w = 0;
+  for (uint8_t i = 0; i + 1 < n; i++) {
+    w += u8g2_GetGlyphWidth(display.getU8g2(), (uint8_t)text.str[i]);
+  }
+  char last[2] = { text.str[n - 1], '\0' };
+  return w + display.getStrWidth(last);
+}
+
+// The sprite holds ink only, so solid font mode (which also clears the glyph
+// boxes) and rotated text are left to the glyphs
+static bool textBlit(U8G2& display, int x, int y, const TextLayout& layout) {
+  u8g2_t* u = display.getU8g2();
+  if (layout.font != u->font || !u->font_decode.is_transparent || u->font_decode.dir != 0) return false;
+  const TextSprite& s = layout.sprite;
+  if (!s.data) return true;
+
+  uint8_t* buf = display.getBufferPtr();
+  int bufW = display.getBufferTileWidth() * 8;
+  int bufPages = display.getBufferTileHeight();
+  int top = y + u->font_calc_vref(u) + s.top;
+  int page = top >> 3; // rounds down, also above the screen
+  uint8_t shift = top & 7;
+  int left = x + s.x;
+  int c0 = max(0, -left);
+  int c1 = min((int)s.w, bufW - left);
+  uint8_t color = u->draw_color;
+
+  // Off a page boundary every sprite page spills into the next buffer page
+  uint8_t span = s.pages + (shift != 0);
+  for (uint8_t i = 0; i < span; i++) {
+    int p = page + i;
+    if (p < 0 || p >= bufPages) continue;
+    const uint8_t* cur = i < s.pages ? s.data + i * s.w : nullptr;
+    const uint8_t* above = shift && i > 0 ? s.data + (i - 1) * s.w : nullptr;
+    uint8_t* dst = buf + p * bufW + left;
+    for (int c = c0; c < c1; c++) {
+      uint8_t v = (cur ? cur[c] << shift : 0) | (above ? above[c] >> (8 - shift) : 0);
+      if (color == 1) dst[c] |= v;
+      else if (color == 0) dst[c] &= ~v;
+      else dst[c] ^= v;
+    }
+  }
+  return true;
+}
+
+void textDraw(U8G2& display, int x, int y, TextView text, uint8_t n) {
+  if (n && n == text.len && text.layout && textBlit(display, x, y, *text.layout)) return;
+
+  // drawStr() is exactly this loop over the glyphs; subset fonts skip
+  // u8g2's walk through the glyph list
+  const SubsetFont* font = fontFind(display.getU8g2()->font);
+  for (uint8_t i = 0; i < n; i++) {
+    uint8_t c = text.str[i];
+    x += font ? fontDrawGlyph(display, *font, x, y, c) : display.drawGlyph(x, y, c);
+  }
+}
+
+void textDrawStr(U8G2& display, int x, int y, const char* s) {
+  TextView text = textView(s);
+  textDraw(display, x, y, text, text.len);
+}
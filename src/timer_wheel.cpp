@@ -0,0 +1,153 @@
+#include "timer_wheel.h"
+
+#define LEVEL_DUE   0xFF // t.level of a timer on the due list
+#define SLOT_MASK   (TIMER_SLOTS - 1)
+
+static inline uint8_t shiftOf(uint8_t level) {
+  return TIMER_SLOT_BITS * level;
+}
+
+void TimerWheel::link(Timer& t, Timer** head, uint8_t level, uint8_t slot) {
+  t.next = *head;
+  if (t.next) t.next->pprev = &t.next;
+  t.pprev = head;
+  *head = &t;
+  t.level = level;
+  t.slot = slot;
+  if (level != LEVEL_DUE) occupied[level] |= 1ULL << slot;
+}
+
+void TimerWheel::unlink(Timer& t) {
+  *t.pprev = t.next;
+  if (t.next) t.next->pprev = t.pprev;
+  t.next = nullptr;
+  t.pprev = nullptr;
+  if (t.level != LEVEL_DUE && !slots[t.level][t.slot]) occupied[t.level] &= ~(1ULL << t.slot);
+}
+
+// The lowest level whose slots are narrow enough to tell the deadline from
+// now. Past the top level it parks in the top level's last slot and gets
+// placed again when that one comes round.
+void TimerWheel::place(Timer& t) {
+  if ((int32_t)(t.deadline - current) <= 0) {
+    link(t, &due, LEVEL_DUE, 0);
+    return;
+  }
+  for (uint8_t l = 0; l < TIMER_LEVELS; l++) {
+    uint8_t shift = shiftOf(l);
+    uint32_t span = (t.deadline >> shift) - (current >> shift);
+    if (shift) span &= (1UL << (32 - shift)) - 1; // the shifted clock wraps at 2^(32 - shift)
+    if (span < TIMER_SLOTS) {
+      uint8_t s = (t.deadline >> shift) & SLOT_MASK;
+      link(t, &slots[l][s], l, s);
+      return;
+    }
+  }
+  uint8_t top = TIMER_LEVELS - 1;
+  uint8_t s = ((current >> shiftOf(top)) - 1) & SLOT_MASK;
+  link(t, &slots[top][s], top, s);
+}
+
+void TimerWheel::arm(Timer& t, uint32_t deadline) {
+  if (armed(t)) unlink(t);
+  else armedCount++;
+  t.deadline = deadline;
+  place(t);
+}
+
+void TimerWheel::cancel(Timer& t) {
+  if (!armed(t)) return;
+  unlink(t);
+  armedCount--;
+}
+
+// Ticks from now until the next one where a slot fires or gets handed down
+uint32_t TimerWheel::quietTicks() const {
+  if (occupied[0]) {
+    uint8_t idx = current & SLOT_MASK;
+    uint64_t ahead = idx == SLOT_MASK ? 0 : occupied[0] >> (idx + 1);
+    if (ahead) return __builtin_ctzll(ahead) + 1;
+    return TIMER_SLOTS - idx; // the rest is behind us, due after the wrap
+  }
+  for (uint8_t l = 1; l < TIMER_LEVELS; l++) {
+    if (!occupied[l]) continue;
+    uint32_t span = 1UL << shiftOf(l);
+    return span - (current & (span - 1));
+  }
+  return UINT32_MAX;
+}
+
+// One step onto `current`: levels that wrapped hand their slot down, then
+// the level-0 slot for this very millisecond fires
+void TimerWheel::tick() {
+  for (uint8_t l = 1; l < TIMER_LEVELS; l++) {
+    uint8_t shift = shiftOf(l);
+    if (current & ((1UL << shift) - 1)) break;
+    uint8_t s = (current >> shift) & SLOT_MASK;
+    Timer* list = slots[l][s];
+    slots[l][s] = nullptr;
+    occupied[l] &= ~(1ULL << s);
+    while (list) {
+      Timer* t = list;
+      list = t->next;
+      t->next = nullptr;
+      t->pprev = nullptr;
+      place(*t);
+    }
+  }
+
+  Timer** head = &slots[0][current & SLOT_MASK];
+  while (Timer* t = *head) {
+    unlink(*t);
+    armedCount--;
+    t->fn(*t, current);
+  }
+}
+
+void TimerWheel::advance(uint32_t now) {
+  for (;;) {
+    // Past deadlines, including ones callbacks just set
+    while (Timer* t = due) {
+      unlink(*t);
+      armedCount--;
+      t->fn(*t, current);
+    }
+
+    int32_t left = now - current;
+    if (left <= 0) return;
+    uint32_t step = quietTicks();
+    if (step > (uint32_t)left) {
+      current = now;
+      return;
+    }
+    current += step;
+    tick();
+  }
+}
+
+bool TimerWheel::nextDeadline(uint32_t& at) const {
+  if (due) {
+    at = current;
+    return true;
+  }
+
+  // Per level the first non-empty slot after the current one holds that
+  // level's earliest deadlines; the current slot itself was handed down
+  // already (or, on level 0, has fired). The top level can also hold
+  // parked timers in any slot, so all of it gets looked at.
+  bool found = false;
+  for (uint8_t l = 0; l < TIMER_LEVELS; l++) {
+    if (!occupied[l]) continue;
+    uint8_t idx = (current >> shiftOf(l)) & SLOT_MASK;
+    for (uint8_t i = 1; i <= TIMER_SLOTS; i++) {
+      uint8_t s = (idx + i) & SLOT_MASK;
+      if (!(occupied[l] & (1ULL << s))) continue;
+      for (const Timer* t = slots[l][s]; t; t = t->next) {
+        if (!found || (int32_t)(t->deadline - at) < 0) at = t->deadline;
+        found = true;
+      }
+      if (l < TIMER_LEVELS - 1) break;
+    }
+  }
+  return found;
+}
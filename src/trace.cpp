@@ -0,0 +1,82 @@
+#include "trace.h"
+#include "display.h"
+
+static TraceRecord records[TRACE_CAPACITY];
+static uint16_t count = 0;
+static bool pressThisPass = false; // a press was recorded in this loop() pass
+static bool awaitingPixel = false;
+static uint32_t awaitAfter = 0;    // frames flushed before the awaited transition
+
+static void add(uint32_t us, TraceKind kind, uint8_t a, uint8_t b, uint8_t c) {
+  if (count >= TRACE_CAPACITY) return;
+  records[count++] = { us, kind, a, b, c };
+}
+
+void traceButton(const ButtonPress& press) {
+  add(press.us, TRACE_PRESS, press.button, 0, 0);
+  pressThisPass = true;
+}
+
+void traceTransition(uint8_t from, uint8_t to, uint8_t event, uint32_t flushesBefore) {
+  add(micros(), TRACE_TRANSITION, from, to, event | (pressThisPass ? TRACE_BY_PRESS : 0));
+  pressThisPass = false;
+  awaitingPixel = true;
+  awaitAfter = flushesBefore;
+}
+
+void traceUpdate() {
+  pressThisPass = false; // an ignored press doesn't get blamed for a later timeout
+  if (!awaitingPixel) return;
+
+  // paintUs is written before paintSeq, so read them the other way round
+  const DisplayStats& s = displayStats();
+  uint32_t seq = s.paintSeq;
+  if ((int32_t)(seq - awaitAfter) <= 0) return;
+  add(s.paintUs, TRACE_PIXEL, 0, 0, 0);
+  awaitingPixel = false;
+}
+
+uint16_t traceCount() {
+  return count;
+}
+
+const TraceRecord* traceRecords() {
+  return records;
+}
+
+void traceDump(Print& out) {
+  out.print("trace,");
+  out.println(count);
+  for (uint16_t i = 0; i < count; i++) {
+    const uint8_t* b = (const uint8_t*)&records[i];
+    for (uint8_t k = 0; k < sizeof(TraceRecord); k++) out.printf("%02x", b[k]);
+    out.println();
+  }
+  out.println("end");
+}
+
+void tracePrintReport(Print& out, const TraceRecord* recs, uint16_t n,
+                      const char* const* stateNames, const char* const* eventNames) {
+  out.println("at_ms,from,to,event,transition_us,pixel_us");
+
+  uint32_t pressUs = 0;
+  for (uint16_t i = 0; i < n; i++) {
+    const TraceRecord& r = recs[i];
+    if (r.kind == TRACE_PRESS) pressUs = r.us;
+    if (r.kind != TRACE_TRANSITION) continue;
+
+    uint32_t cause = (r.c & TRACE_BY_PRESS) ? pressUs : r.us;
+    out.printf("%lu,%s,%s,%s,%lu,", (unsigned long)(r.us / 1000), stateNames[r.a],
+               stateNames[r.b], eventNames[r.c & ~TRACE_BY_PRESS], (unsigned long)(r.us - cause));
+
+    // The pixels count only if they came before the next transition
+    for (uint16_t j = i + 1; j < n && recs[j].kind != TRACE_TRANSITION; j++) {
+      if (recs[j].kind == TRACE_PIXEL) {
+        out.print((unsigned long)(recs[j].us - cause));
+        break;
+      }
+    }
+    out.println();
+  }
+  if (n >= TRACE_CAPACITY) out.println("# trace full, later events were not recorded");
+}
@@ -0,0 +1,91 @@
+// bitmapDraw() against u8g2's own drawXBMP() of the original assets/*.xbm:
+// every asset, solid and transparent bitmap mode, draw colours 0, 1 and 2,
+// at the origin, at odd offsets and hanging off the right and bottom edges.
+// The buffer starts out patterned, so a pixel set, cleared or flipped where
+// drawXBMP() wouldn't shows up.
+#include <unity.h>
+#include <U8g2lib.h>
+#include "bitmap.h"
+
+#include "../../assets/ble_pairing.xbm"
+#include "../../assets/cards_hearts.xbm"
+#include "../../assets/connected.xbm"
+#include "../../assets/dolphin_nice.xbm"
+#include "../../assets/error.xbm"
+#include "../../assets/passport_bad.xbm"
+#include "../../assets/passport_happy.xbm"
+#include "../../assets/scanning.xbm"
+
+#define XBM(id, name) { id, name##_width, name##_height, name##_bits }
+
+static const struct {
+  BitmapId id;
+  uint8_t w, h;
+  const unsigned char* bits;
+} ASSETS[] = {
+  XBM(BMP_BLE_PAIRING, ble_pairing),
+  XBM(BMP_CARDS_HEARTS, cards_hearts),
+  XBM(BMP_CONNECTED, connected),
+  XBM(BMP_DOLPHIN_NICE, dolphin_nice),
+  XBM(BMP_ERROR, error),
+  XBM(BMP_PASSPORT_BAD, passport_bad),
+  XBM(BMP_PASSPORT_HAPPY, passport_happy),
+  XBM(BMP_SCANNING, scanning),
+};
+static_assert(sizeof(ASSETS) / sizeof(ASSETS[0]) == BMP_COUNT, "an asset is missing");
+
+#define BUFFER_BYTES 1024
+
+static U8G2_SSD1306_128X64_NONAME_F_HW_I2C display(U8G2_R0, U8X8_PIN_NONE);
+static uint8_t expected[BUFFER_BYTES];
+
+static void fillPattern() {
+  uint8_t* buf = display.getBufferPtr();
+  for (uint16_t i = 0; i < BUFFER_BYTES; i++) buf[i] = (uint8_t)(i * 37) ^ 0x5A;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_sizes_match_the_assets() {
+  for (auto& a : ASSETS) {
+    TEST_ASSERT_EQUAL(a.w, bitmapInfo(a.id).w);
+    TEST_ASSERT_EQUAL(a.h, bitmapInfo(a.id).h);
+  }
+}
+
+void test_same_pixels_as_drawXBMP() {
+  char where[80];
+  for (auto& a : ASSETS) {
+    // origin, odd offsets, half off the right and bottom, a corner only
+    const uint8_t at[][2] = {
+      { 0, 0 }, { 3, 5 }, { 13, 1 }, { (uint8_t)(128 - a.w / 2), (uint8_t)(64 - a.h / 2) }, { 125, 61 },
+    };
+    for (uint8_t mode = 0; mode <= 1; mode++) {
+      for (uint8_t color = 0; color <= 2; color++) {
+        for (auto& p : at) {
+          snprintf(where, sizeof(where), "%s mode %u colour %u at %u,%u", bitmapInfo(a.id).name, mode, color, p[0], p[1]);
+          display.setBitmapMode(mode);
+          display.setDrawColor(color);
+
+          fillPattern();
+          display.drawXBMP(p[0], p[1], a.w, a.h, a.bits);
+          memcpy(expected, display.getBufferPtr(), BUFFER_BYTES);
+
+          fillPattern();
+          bitmapDraw(display, p[0], p[1], a.id);
+          TEST_ASSERT_EQUAL_MEMORY_MESSAGE(expected, display.getBufferPtr(), BUFFER_BYTES, where);
+          TEST_ASSERT_EQUAL_MESSAGE(color, display.getDrawColor(), where); // left as it was
+        }
+      }
+    }
+  }
+  display.setDrawColor(1);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_sizes_match_the_assets);
+  RUN_TEST(test_same_pixels_as_drawXBMP);
+  return UNITY_END();
+}
@@ -0,0 +1,308 @@
+// Bounce traces through the button path: the debounce filter on its own,
+// the edge ring, and buttons.cpp end to end on the sim's pins and clock
+// (simSetPin() runs the CHANGE interrupts like the real edges would).
+#include <unity.h>
+#include "buttons.h"
+#include "idle_sleep.h"
+#include "sim.h"
+
+#define YES_PIN 4
+#define NO_PIN  5
+#define DEBOUNCE_MS 50
+
+static void advanceMs(uint32_t ms) {
+  simAdvanceUs((uint64_t)ms * 1000);
+}
+
+// Every press waiting in the ring, oldest first
+static uint8_t pollAll(ButtonPress* out, uint8_t max) {
+  uint8_t n = 0;
+  ButtonPress p;
+  while (buttonsPoll(p)) {
+    if (n < max) out[n] = p;
+    n++;
+  }
+  return n;
+}
+
+void setUp() {
+  simSetPin(YES_PIN, HIGH);
+  simSetPin(NO_PIN, HIGH);
+  advanceMs(1000);
+  buttonsBegin(YES_PIN, NO_PIN, DEBOUNCE_MS);
+  ButtonPress p;
+  while (buttonsPoll(p)) {}
+}
+
+void tearDown() {}
+
+// ===== DEBOUNCE FILTER =====
+
+void test_filter_accepts_leading_edge_only() {
+  DebounceFilter f;
+  f.lockoutUs = 50000;
+  TEST_ASSERT_TRUE(f.update(LOW, 1000));
+  // contact bounce inside the window
+  TEST_ASSERT_FALSE(f.update(HIGH, 1200));
+  TEST_ASSERT_FALSE(f.update(LOW, 1900));
+  TEST_ASSERT_FALSE(f.update(HIGH, 2500));
+  TEST_ASSERT_FALSE(f.update(LOW, 3100));
+  TEST_ASSERT_EQUAL(LOW, f.stable);
+  // live level after the window: still pressed, nothing new
+  TEST_ASSERT_FALSE(f.update(LOW, 51000));
+  TEST_ASSERT_EQUAL(LOW, f.stable);
+}
+
+void test_filter_resyncs_release_inside_lockout() {
+  DebounceFilter f;
+  f.lockoutUs = 50000;
+  TEST_ASSERT_TRUE(f.update(LOW, 0));
+  TEST_ASSERT_FALSE(f.update(HIGH, 20000)); // a quick tap, released inside the window
+  TEST_ASSERT_EQUAL(LOW, f.stable);
+  TEST_ASSERT_FALSE(f.update(HIGH, 50000)); // window over: the live level re-syncs it
+  TEST_ASSERT_EQUAL(HIGH, f.stable);
+  TEST_ASSERT_TRUE(f.update(LOW, 200000));  // so the next press counts
+}
+
+void test_filter_lockout_across_micros_wrap() {
+  DebounceFilter f;
+  f.lockoutUs = 50000;
+  uint32_t t = 0xFFFFFFFFUL - 10000;
+  TEST_ASSERT_TRUE(f.update(LOW, t));
+  TEST_ASSERT_FALSE(f.update(HIGH, t + 20000)); // wrapped, still inside the window
+  TEST_ASSERT_EQUAL(LOW, f.stable);
+  TEST_ASSERT_FALSE(f.update(HIGH, t + 60000));
+  TEST_ASSERT_EQUAL(HIGH, f.stable);
+}
+
+// ===== EDGE RING =====
+
+void test_ring_keeps_order_and_counts_overflow() {
+  static SpscRing<uint32_t, 8> ring;
+  for (uint32_t i = 0; i < 10; i++) TEST_ASSERT_EQUAL(i < 8, ring.push(i));
+  TEST_ASSERT_EQUAL(8, ring.size());
+  TEST_ASSERT_EQUAL(2, ring.droppedCount());
+
+  uint32_t v;
+  for (uint32_t i = 0; i < 8; i++) {
+    TEST_ASSERT_TRUE(ring.pop(v));
+    TEST_ASSERT_EQUAL(i, v); // the oldest survive, the overflow is what's lost
+  }
+  TEST_ASSERT_FALSE(ring.pop(v));
+  TEST_ASSERT_TRUE(ring.push(99)); // room again
+}
+
+void test_ring_indices_wrap() {
+  static SpscRing<uint32_t, 4> ring;
+  uint32_t v;
+  // past 65535 pushes the uint16_t head and tail wrap
+  for (uint32_t i = 0; i < 70000; i++) {
+    TEST_ASSERT_TRUE(ring.push(i));
+    if (i % 3 == 2) ring.push(i | 0x80000000UL);
+    while (ring.size() > 2) ring.pop(v);
+  }
+  TEST_ASSERT_EQUAL(0, ring.droppedCount());
+  while (ring.pop(v)) {}
+  TEST_ASSERT_EQUAL(0, ring.size());
+}
+
+// ===== BUTTONS END TO END =====
+
+void test_bounce_ending_inside_lockout() {
+  // Press with 4 ms of bounce, released 30 ms later with its own bounce: all
+  // of it inside the 50 ms window
+  static const struct { uint16_t atMs; uint8_t level; } trace[] = {
+    { 0, LOW }, { 1, HIGH }, { 2, LOW }, { 3, HIGH }, { 4, LOW },
+    { 30, HIGH }, { 31, LOW }, { 33, HIGH },
+  };
+  uint64_t t0 = simNowUs();
+  for (auto& e : trace) {
+    simAdvanceUs(t0 + e.atMs * 1000ULL - simNowUs());
+    simSetPin(YES_PIN, e.level);
+  }
+
+  ButtonPress p[4];
+  TEST_ASSERT_EQUAL(1, pollAll(p, 4));
+  TEST_ASSERT_EQUAL(BUTTON_YES, p[0].button);
+  TEST_ASSERT_EQUAL_UINT32((uint32_t)t0, p[0].us); // stamped at the first edge
+
+  // After the window the drained ring re-syncs to the released pin
+  advanceMs(40);
+  TEST_ASSERT_EQUAL(0, pollAll(p, 4));
+  TEST_ASSERT_FALSE(buttonHeld(BUTTON_YES));
+
+  // and once the release's own window is over the next press counts again
+  advanceMs(DEBOUNCE_MS);
+  simSetPin(YES_PIN, LOW);
+  TEST_ASSERT_EQUAL(1, pollAll(p, 4));
+  advanceMs(100);
+  simSetPin(YES_PIN, HIGH);
+  advanceMs(100);
+  TEST_ASSERT_EQUAL(0, pollAll(p, 4));
+}
+
+void test_press_settling_inside_lockout_is_caught_up() {
+  // Release bounces back to pressed, and the last edge lands in the window:
+  // the ring alone says released, the live pin says held
+  simSetPin(NO_PIN, LOW);
+  ButtonPress p[4];
+  TEST_ASSERT_EQUAL(1, pollAll(p, 4));
+  advanceMs(100);
+  simSetPin(NO_PIN, HIGH); // release, accepted
+  TEST_ASSERT_EQUAL(0, pollAll(p, 4));
+  advanceMs(10);
+  simSetPin(NO_PIN, LOW);  // pressed again inside the release's window
+  TEST_ASSERT_EQUAL(0, pollAll(p, 4));
+  TEST_ASSERT_FALSE(buttonHeld(BUTTON_NO));
+
+  advanceMs(45);
+  TEST_ASSERT_EQUAL(1, pollAll(p, 4)); // caught up from the live level
+  TEST_ASSERT_EQUAL(BUTTON_NO, p[0].button);
+  TEST_ASSERT_EQUAL_UINT32((uint32_t)simNowUs(), p[0].us);
+  TEST_ASSERT_TRUE(buttonHeld(BUTTON_NO));
+  simSetPin(NO_PIN, HIGH);
+  advanceMs(100);
+  pollAll(p, 4);
+}
+
+void test_ring_overflow_keeps_first_press_and_final_level() {
+  uint32_t droppedBefore = buttonsDroppedEdges();
+  // 101 edges without a poll in between: far more than the 64-edge ring
+  uint64_t t0 = simNowUs();
+  for (uint8_t i = 0; i <= 100; i++) {
+    simSetPin(YES_PIN, i % 2 ? HIGH : LOW);
+    simAdvanceUs(100);
+  }
+  TEST_ASSERT_EQUAL_UINT32(droppedBefore + 101 - 64, buttonsDroppedEdges());
+
+  ButtonPress p[4];
+  TEST_ASSERT_EQUAL(1, pollAll(p, 4));
+  TEST_ASSERT_EQUAL_UINT32((uint32_t)t0, p[0].us);
+
+  // ended pressed (edge 100 is LOW), which the ring lost but the pin hasn't
+  advanceMs(60);
+  TEST_ASSERT_EQUAL(0, pollAll(p, 4));
+  TEST_ASSERT_TRUE(buttonHeld(BUTTON_YES));
+  simSetPin(YES_PIN, HIGH);
+  advanceMs(60);
+  TEST_ASSERT_EQUAL(0, pollAll(p, 4));
+  TEST_ASSERT_FALSE(buttonHeld(BUTTON_YES));
+}
+
+void test_held_button_is_one_press() {
+  ButtonPress p[4];
+  simSetPin(YES_PIN, LOW);
+  uint8_t presses = 0;
+  for (uint16_t ms = 0; ms < 2000; ms += 10) { // polled like loop() does
+    presses += pollAll(p, 4);
+    TEST_ASSERT_TRUE(ms < 50 || buttonHeld(BUTTON_YES));
+    advanceMs(10);
+  }
+  TEST_ASSERT_EQUAL(1, presses);
+
+  // the other button works while this one is held
+  simSetPin(NO_PIN, LOW);
+  TEST_ASSERT_EQUAL(1, pollAll(p, 4));
+  TEST_ASSERT_EQUAL(BUTTON_NO, p[0].button);
+  advanceMs(100);
+  simSetPin(NO_PIN, HIGH);
+
+  simSetPin(YES_PIN, HIGH);
+  advanceMs(100);
+  TEST_ASSERT_EQUAL(0, pollAll(p, 4));
+  TEST_ASSERT_FALSE(buttonHeld(BUTTON_YES));
+}
+
+void test_button_held_through_begin_is_not_a_press() {
+  simSetPin(YES_PIN, LOW);
+  ButtonPress p[4];
+  pollAll(p, 4);
+  advanceMs(100);
+  buttonsBegin(YES_PIN, NO_PIN, DEBOUNCE_MS); // a reboot with it held down
+  TEST_ASSERT_EQUAL(0, pollAll(p, 4));
+  TEST_ASSERT_TRUE(buttonHeld(BUTTON_YES));
+  simSetPin(YES_PIN, HIGH);
+  advanceMs(100);
+  TEST_ASSERT_EQUAL(0, pollAll(p, 4));
+}
+
+static volatile uint8_t isrCalls;
+
+static void countEdge() {
+  isrCalls = isrCalls + 1;
+}
+
+void test_both_edges_reach_the_isr_after_light_sleep() {
+  // The light sleep wakeup arms the pins for a level; once awake a tap must
+  // still be two edges. buttons.cpp would catch a lost release up from the
+  // live level, so the edges are counted on an ISR of the test's own
+  // (setUp()'s buttonsBegin() puts the real one back).
+  attachInterrupt(digitalPinToInterrupt(YES_PIN), countEdge, CHANGE);
+  idleBegin(YES_PIN, NO_PIN);
+  idleWait(20, 0, false);
+  TEST_ASSERT_EQUAL_UINT32(1, idleStats(0).sleeps);
+
+  isrCalls = 0;
+  simSetPin(YES_PIN, LOW);
+  advanceMs(100);
+  simSetPin(YES_PIN, HIGH);
+  advanceMs(100);
+  simSetPin(YES_PIN, LOW);
+  simSetPin(YES_PIN, HIGH);
+  TEST_ASSERT_EQUAL_UINT8(4, isrCalls);
+  idleStop();
+}
+
+static void schedulePin(uint64_t atUs, uint8_t pin, uint8_t level) {
+  SimEvent ev = {};
+  ev.kind = SIM_PIN;
+  ev.pin = pin;
+  ev.atUs = atUs;
+  ev.level = level;
+  TEST_ASSERT_TRUE(simSchedule(ev));
+}
+
+void test_button_held_across_a_wake_is_one_press() {
+  // The press wakes the chip on its level and is still down when the pass
+  // after it runs: one press, nothing dropped, and the release is seen
+  idleBegin(YES_PIN, NO_PIN);
+  uint32_t dropped = buttonsDroppedEdges();
+  uint32_t sleeps = idleStats(0).sleeps;
+  uint64_t downUs = simNowUs() + 5000;
+  schedulePin(downUs, YES_PIN, LOW);
+  schedulePin(downUs + 300000, YES_PIN, HIGH);
+  idleWait(20, 0, false);
+  TEST_ASSERT_EQUAL_UINT32(sleeps + 1, idleStats(0).sleeps);
+  TEST_ASSERT_EQUAL_UINT32(downUs, simNowUs()); // woken by the press, not the timer
+
+  ButtonPress p[4];
+  TEST_ASSERT_EQUAL(1, pollAll(p, 4));
+  TEST_ASSERT_EQUAL(BUTTON_YES, p[0].button);
+  TEST_ASSERT_TRUE(buttonHeld(BUTTON_YES));
+  advanceMs(100);
+  TEST_ASSERT_EQUAL(0, pollAll(p, 4));
+  TEST_ASSERT_TRUE(buttonHeld(BUTTON_YES));
+
+  advanceMs(250);
+  TEST_ASSERT_EQUAL(0, pollAll(p, 4));
+  TEST_ASSERT_FALSE(buttonHeld(BUTTON_YES));
+  TEST_ASSERT_EQUAL_UINT32(dropped, buttonsDroppedEdges());
+  idleStop();
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_filter_accepts_leading_edge_only);
+  RUN_TEST(test_filter_resyncs_release_inside_lockout);
+  RUN_TEST(test_filter_lockout_across_micros_wrap);
+  RUN_TEST(test_ring_keeps_order_and_counts_overflow);
+  RUN_TEST(test_ring_indices_wrap);
+  RUN_TEST(test_bounce_ending_inside_lockout);
+  RUN_TEST(test_press_settling_inside_lockout_is_caught_up);
+  RUN_TEST(test_ring_overflow_keeps_first_press_and_final_level);
+  RUN_TEST(test_held_button_is_one_press);
+  RUN_TEST(test_button_held_through_begin_is_not_a_press);
+  RUN_TEST(test_both_edges_reach_the_isr_after_light_sleep);
+  RUN_TEST(test_button_held_across_a_wake_is_one_press);
+  return UNITY_END();
+}
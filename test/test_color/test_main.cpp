@@ -0,0 +1,111 @@
+// The packed colour kernels against plain per-byte arithmetic: scale and
+// saturating add for every byte value in every lane (and every amount for
+// scale), lerp for random words plus the ends of its range, and the
+// *Buffer versions over odd lengths and unaligned starts.
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include "color.h"
+
+static uint8_t byteOf(uint32_t w, uint8_t lane) {
+  return w >> (8 * lane);
+}
+
+// Every lane sees every value as v runs over 0..255
+static uint32_t spread(uint8_t v, uint8_t stride) {
+  uint32_t w = 0;
+  for (uint8_t lane = 0; lane < 4; lane++) w |= (uint32_t)(uint8_t)(v + lane * stride) << (8 * lane);
+  return w;
+}
+
+static uint32_t rngState = 1;
+
+static uint32_t rnd() {
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 17;
+  rngState ^= rngState << 5;
+  return rngState;
+}
+
+static void checkLanes(uint32_t expected, uint32_t actual, const char* kernel, uint32_t a, uint32_t b) {
+  if (expected == actual) return;
+  char msg[96];
+  snprintf(msg, sizeof(msg), "%s(%08lx, 0x%lx): expected %08lx, got %08lx", kernel, (unsigned long)a,
+           (unsigned long)b, (unsigned long)expected, (unsigned long)actual);
+  TEST_FAIL_MESSAGE(msg);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_scale_matches_bytes() {
+  for (uint16_t s = 0; s <= 256; s++) {
+    for (uint16_t v = 0; v < 256; v++) {
+      uint32_t c = spread(v, 67);
+      uint32_t expected = 0;
+      for (uint8_t lane = 0; lane < 4; lane++) expected |= (uint32_t)(byteOf(c, lane) * s >> 8) << (8 * lane);
+      checkLanes(expected, colorScale(c, s), "colorScale", c, s);
+    }
+  }
+}
+
+void test_add_sat_matches_bytes() {
+  for (uint16_t x = 0; x < 256; x++) {
+    for (uint16_t y = 0; y < 256; y++) {
+      uint32_t a = spread(x, 67), b = spread(y, 131);
+      uint32_t expected = 0;
+      for (uint8_t lane = 0; lane < 4; lane++) {
+        uint16_t sum = byteOf(a, lane) + byteOf(b, lane);
+        expected |= (uint32_t)(sum > 255 ? 255 : sum) << (8 * lane);
+      }
+      checkLanes(expected, colorAddSat(a, b), "colorAddSat", a, b);
+    }
+  }
+}
+
+void test_lerp_matches_bytes() {
+  for (uint32_t i = 0; i < 1000000; i++) {
+    uint32_t a = rnd(), b = rnd();
+    uint16_t t = i < 3 ? i * 128 : rnd() % 257; // 0, 128 and 256 first
+    uint32_t expected = 0;
+    for (uint8_t lane = 0; lane < 4; lane++) {
+      expected |= (uint32_t)((byteOf(a, lane) * (256 - t) + byteOf(b, lane) * t) >> 8) << (8 * lane);
+    }
+    checkLanes(expected, colorLerp(a, b, t), "colorLerp", a, t);
+  }
+  TEST_ASSERT_EQUAL_HEX32(0x123456, colorLerp(0x123456, 0xABCDEF, 0));
+  TEST_ASSERT_EQUAL_HEX32(0xABCDEF, colorLerp(0x123456, 0xABCDEF, 256));
+}
+
+void test_buffers_match_bytes() {
+  uint8_t px[40], to[40], expected[40];
+  for (uint8_t start = 0; start < 4; start++) {
+    for (uint8_t bytes = 0; bytes <= 33; bytes++) {
+      for (uint8_t round = 0; round < 20; round++) {
+        for (uint8_t i = 0; i < sizeof(px); i++) {
+          px[i] = rnd();
+          to[i] = rnd();
+        }
+        uint16_t s = rnd() % 257;
+        memcpy(expected, px, sizeof(px));
+        for (uint8_t i = start; i < start + bytes; i++) expected[i] = px[i] * s >> 8;
+        colorScaleBuffer(px + start, bytes, s);
+        TEST_ASSERT_EQUAL_MEMORY(expected, px, sizeof(px)); // and nothing outside it
+
+        memcpy(expected, px, sizeof(px));
+        for (uint8_t i = start; i < start + bytes; i++) expected[i] = (px[i] * (256 - s) + to[i] * s) >> 8;
+        colorLerpBuffer(px + start, to + start, bytes, s);
+        TEST_ASSERT_EQUAL_MEMORY(expected, px, sizeof(px));
+      }
+    }
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_scale_matches_bytes);
+  RUN_TEST(test_add_sat_matches_bytes);
+  RUN_TEST(test_lerp_matches_bytes);
+  RUN_TEST(test_buffers_match_bytes);
+  return UNITY_END();
+}
@@ -0,0 +1,113 @@
+// I2C traffic of the dirty-tile flush, counted on the sim panel's byte
+// stream against a full sendBuffer() of the same frames: the idle heart
+// blinking sends only the tiles under the heart, a typed character only the
+// pages of its line, and displayStats()' byte counts are what actually
+// went over the bus.
+#include <unity.h>
+#include <Arduino.h>
+#include "app_state.h"
+#include "display.h"
+#include "sim.h"
+
+// ---- from main.cpp ----
+void setup();
+void loop();
+void enterState(AppState next, unsigned long now);
+void startNonBlockingTypewriter(const char* l1, const char* l2, const char* l3);
+extern bool typewriterActive;
+extern const char* MSG_WIN_STD_1;
+extern const char* MSG_WIN_STD_2;
+extern const char* MSG_WIN_STD_3;
+
+#define FULL_FRAME_BYTES (8 * (DISPLAY_AREA_OVERHEAD + 128))
+// The 15x16 heart at (56,41): two tile columns by three pages
+#define HEART_BYTES      (3 * (DISPLAY_AREA_OVERHEAD + 2 * 8))
+// A caption line is two pages deep; centred, a new character moves all of it
+#define LINE_BYTES       (2 * (DISPLAY_AREA_OVERHEAD + 128))
+
+struct Traffic {
+  uint32_t frames;   // loop() passes that changed the panel
+  uint32_t bytes;    // on the bus for them
+  uint32_t worst;    // the dearest of them, hand-overs left out
+  uint32_t estimate; // displayStats().bytesSent over the same passes
+};
+
+// loop() pass by pass, each one waited onto the panel, while keepGoing().
+// The pass that ends it (and the first, if asked) is a hand-over to or from
+// another screen: counted, but not in worst.
+static Traffic measure(bool (*keepGoing)(), bool skipFirst) {
+  Traffic t = {};
+  uint32_t sent = displayStats().bytesSent;
+  uint32_t bytes = simPanelStats().bytes;
+  while (keepGoing()) {
+    uint32_t before = simPanelStats().bytes;
+    uint32_t data = simPanelStats().dataBytes;
+    loop();
+    displaySync();
+    if (simPanelStats().dataBytes == data) continue;
+    uint32_t frame = simPanelStats().bytes - before;
+    bool handOver = (t.frames++ == 0 && skipFirst) || !keepGoing();
+    if (!handOver && frame > t.worst) t.worst = frame;
+  }
+  t.bytes = simPanelStats().bytes - bytes;
+  t.estimate = displayStats().bytesSent - sent;
+  return t;
+}
+
+static unsigned long untilMs;
+
+static bool beforeUntil() {
+  return millis() < untilMs;
+}
+
+static bool typing() {
+  return typewriterActive;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_full_frame_is_the_sendBuffer_baseline() {
+  setup();
+  untilMs = millis() + 2000;
+  measure(beforeUntil, false);
+
+  uint32_t bytes = simPanelStats().bytes;
+  uint32_t full = displayStats().bytesFull;
+  displayInvalidate();
+  displayFlush();
+  displaySync();
+  TEST_ASSERT_EQUAL_UINT32(FULL_FRAME_BYTES, simPanelStats().bytes - bytes);
+  TEST_ASSERT_EQUAL_UINT32(FULL_FRAME_BYTES, displayStats().bytesFull - full);
+}
+
+void test_idle_heart_sends_only_its_tiles() {
+  enterState(STATE_IDLE, millis());
+  untilMs = millis() + 3000;
+  measure(beforeUntil, false);
+
+  untilMs = millis() + 10000;
+  Traffic t = measure(beforeUntil, false);
+  TEST_ASSERT_TRUE(t.frames >= 10); // it did blink
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(HEART_BYTES, t.worst);
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(t.frames * FULL_FRAME_BYTES / 16, t.bytes);
+  TEST_ASSERT_EQUAL_UINT32(t.bytes, t.estimate);
+}
+
+void test_typed_character_sends_only_its_line() {
+  startNonBlockingTypewriter(MSG_WIN_STD_1, MSG_WIN_STD_2, MSG_WIN_STD_3);
+  // the first frame clears the heart screen, the last is the heart screen back
+  Traffic t = measure(typing, true);
+  TEST_ASSERT_TRUE(t.frames >= 20);
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(LINE_BYTES, t.worst);
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(t.frames * FULL_FRAME_BYTES / 5, t.bytes);
+  TEST_ASSERT_EQUAL_UINT32(t.bytes, t.estimate);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_full_frame_is_the_sendBuffer_baseline);
+  RUN_TEST(test_idle_heart_sends_only_its_tiles);
+  RUN_TEST(test_typed_character_sends_only_its_line);
+  return UNITY_END();
+}
@@ -0,0 +1,111 @@
+// The build-time font subsets against the complete u8g2 fonts they were cut
+// from, both drawn by u8g2's own decoder: every glyph the subset keeps
+// draws the same pixels with the same advance as in the complete font (and
+// as fontDrawGlyph() from the direct index), every glyph it drops draws
+// nothing, and the font-wide metrics from the header are unchanged.
+#include <unity.h>
+#include <U8g2lib.h>
+
+// The complete fonts, taken before fonts.h points their names at the subsets
+static const uint8_t* const FULL[] = { u8g2_font_ncenB08_tr, u8g2_font_t0_13b_tr };
+
+#include "font.h"
+
+static const uint8_t* const SUBSET[] = { u8g2_font_ncenB08_tr, u8g2_font_t0_13b_tr };
+static const char* const NAMES[] = { "u8g2_font_ncenB08_tr", "u8g2_font_t0_13b_tr" };
+
+#define FONT_TABLE (sizeof(FULL) / sizeof(FULL[0]))
+#define BUFFER_BYTES 1024
+
+static U8G2_SSD1306_128X64_NONAME_F_HW_I2C display(U8G2_R0, U8X8_PIN_NONE);
+static uint8_t fromFull[BUFFER_BYTES];
+
+// The glyph at x, y on a cleared buffer; returns its advance
+static u8g2_uint_t drawOne(const uint8_t* font, uint8_t c, bool direct) {
+  display.clearBuffer();
+  display.setFont(font);
+  if (direct) return fontDrawGlyph(display, *fontFind(font), 40, 30, c);
+  return display.drawGlyph(40, 30, c);
+}
+
+static bool kept(const SubsetFont& f, uint8_t c) {
+  uint8_t i = c - f.first;
+  return i < f.count && f.index[i];
+}
+
+void setUp() {
+  display.setFontPosBaseline();
+  display.setFontMode(1);
+  display.setDrawColor(1);
+}
+
+void tearDown() {}
+
+void test_every_font_in_use_is_a_subset() {
+  TEST_ASSERT_EQUAL(FONT_COUNT, FONT_TABLE);
+  for (uint8_t f = 0; f < FONT_TABLE; f++) {
+    TEST_ASSERT_TRUE_MESSAGE(FULL[f] != SUBSET[f], NAMES[f]);
+    const SubsetFont* sub = fontFind(SUBSET[f]);
+    TEST_ASSERT_NOT_NULL_MESSAGE(sub, NAMES[f]);
+    TEST_ASSERT_EQUAL_STRING(NAMES[f], sub->name);
+    TEST_ASSERT_TRUE_MESSAGE(sub->size < sub->fullSize, NAMES[f]);
+  }
+}
+
+void test_header_metrics_are_unchanged() {
+  for (uint8_t f = 0; f < FONT_TABLE; f++) {
+    display.setFont(FULL[f]);
+    int8_t ascent = display.getAscent(), descent = display.getDescent();
+    int8_t maxHeight = display.getMaxCharHeight(), maxWidth = display.getMaxCharWidth();
+    display.setFont(SUBSET[f]);
+    TEST_ASSERT_EQUAL_MESSAGE(ascent, display.getAscent(), NAMES[f]);
+    TEST_ASSERT_EQUAL_MESSAGE(descent, display.getDescent(), NAMES[f]);
+    TEST_ASSERT_EQUAL_MESSAGE(maxHeight, display.getMaxCharHeight(), NAMES[f]);
+    TEST_ASSERT_EQUAL_MESSAGE(maxWidth, display.getMaxCharWidth(), NAMES[f]);
+  }
+}
+
+void test_kept_glyphs_match_the_full_font() {
+  char where[64];
+  for (uint8_t f = 0; f < FONT_TABLE; f++) {
+    const SubsetFont& sub = *fontFind(SUBSET[f]);
+    uint8_t keptCount = 0;
+    for (uint16_t c = 0x20; c < 0x7F; c++) {
+      if (!kept(sub, c)) continue;
+      keptCount++;
+      snprintf(where, sizeof(where), "%s glyph 0x%02X", NAMES[f], c);
+
+      u8g2_uint_t advance = drawOne(FULL[f], c, false);
+      memcpy(fromFull, display.getBufferPtr(), BUFFER_BYTES);
+
+      // u8g2's own lookup and decoder on the subset
+      TEST_ASSERT_EQUAL_MESSAGE(advance, drawOne(SUBSET[f], c, false), where);
+      TEST_ASSERT_EQUAL_MEMORY_MESSAGE(fromFull, display.getBufferPtr(), BUFFER_BYTES, where);
+
+      // and the direct index
+      TEST_ASSERT_EQUAL_MESSAGE(advance, drawOne(SUBSET[f], c, true), where);
+      TEST_ASSERT_EQUAL_MEMORY_MESSAGE(fromFull, display.getBufferPtr(), BUFFER_BYTES, where);
+    }
+    TEST_ASSERT_TRUE_MESSAGE(keptCount > 0, NAMES[f]);
+  }
+}
+
+void test_dropped_glyphs_draw_nothing() {
+  for (uint8_t f = 0; f < FONT_TABLE; f++) {
+    const SubsetFont& sub = *fontFind(SUBSET[f]);
+    for (uint16_t c = 0x20; c < 0x7F; c++) {
+      if (kept(sub, c)) continue;
+      drawOne(SUBSET[f], c, false);
+      for (uint16_t i = 0; i < BUFFER_BYTES; i++) TEST_ASSERT_EQUAL_HEX8(0, display.getBufferPtr()[i]);
+    }
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_every_font_in_use_is_a_subset);
+  RUN_TEST(test_header_metrics_are_unchanged);
+  RUN_TEST(test_kept_glyphs_match_the_full_font);
+  RUN_TEST(test_dropped_glyphs_draw_nothing);
+  return UNITY_END();
+}
@@ -0,0 +1,62 @@
+// The frame cache behind finished typewriter captions: two captions that
+// start with the same line (MSG_WIN_STD_1 and MSG_WIN_FINAL_1 are the same
+// literal, and may well be the same address) must each come back as
+// themselves, from the cache the second time round.
+#include <unity.h>
+#include <Arduino.h>
+#include "display.h"
+#include "sim.h"
+
+// ---- from main.cpp ----
+void setup();
+void loop();
+void startNonBlockingTypewriter(const char* l1, const char* l2, const char* l3);
+extern bool typewriterActive;
+extern const char* MSG_WIN_STD_1;
+extern const char* MSG_WIN_STD_2;
+extern const char* MSG_WIN_STD_3;
+extern const char* MSG_WIN_FINAL_1;
+extern const char* MSG_WIN_FINAL_2;
+extern const char* MSG_WIN_FINAL_3;
+
+#define PANEL_BYTES 1024
+
+static uint8_t standard[PANEL_BYTES];
+static uint8_t final[PANEL_BYTES];
+static uint8_t panel[PANEL_BYTES];
+
+// Types the caption to the end and leaves what the panel shows in out
+static void typeCaption(const char* l1, const char* l2, const char* l3, uint8_t* out) {
+  startNonBlockingTypewriter(l1, l2, l3);
+  unsigned long until = millis() + 20000;
+  while (typewriterActive && millis() < until) loop();
+  TEST_ASSERT_FALSE_MESSAGE(typewriterActive, "still typing");
+  displaySync();
+  memcpy(out, simPanelRam(), PANEL_BYTES);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_captions_sharing_a_first_line_stay_apart() {
+  setup();
+  TEST_ASSERT_EQUAL_STRING(MSG_WIN_STD_1, MSG_WIN_FINAL_1);
+
+  typeCaption(MSG_WIN_STD_1, MSG_WIN_STD_2, MSG_WIN_STD_3, standard);
+  typeCaption(MSG_WIN_FINAL_1, MSG_WIN_FINAL_2, MSG_WIN_FINAL_3, final);
+  TEST_ASSERT_TRUE_MESSAGE(memcmp(standard, final, PANEL_BYTES) != 0, "final caption showed the standard one");
+
+  // Typed again, each finished screen is a cache hit and the same as before
+  uint32_t hits = displayStats().cacheHits;
+  typeCaption(MSG_WIN_STD_1, MSG_WIN_STD_2, MSG_WIN_STD_3, panel);
+  TEST_ASSERT_EQUAL_MEMORY(standard, panel, PANEL_BYTES);
+  typeCaption(MSG_WIN_FINAL_1, MSG_WIN_FINAL_2, MSG_WIN_FINAL_3, panel);
+  TEST_ASSERT_EQUAL_MEMORY(final, panel, PANEL_BYTES);
+  TEST_ASSERT_EQUAL_UINT32(hits + 2, displayStats().cacheHits);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_captions_sharing_a_first_line_stay_apart);
+  return UNITY_END();
+}
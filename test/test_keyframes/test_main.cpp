@@ -0,0 +1,328 @@
+// The keyframe clips against the loops they replaced, sampled at every loop()
+// pass: BOOT_FX, SHUTDOWN_FX, SWAP_FLASH_FX and CELEBRATION_FX from the
+// firmware itself, played on two scratch strips and compared with the old
+// sceneBoot()/sceneShutdown() and updateLEDs() code, restated below.
+//
+// Known differences, pinned with their tolerances:
+//  - boot: the old scene only noticed a ramp had finished on the next pass,
+//    so every phase of the clip starts earlier, by up to BOOT_EARLY_MS each.
+//    Inside a phase the clip is a straight line where the old ramps moved in
+//    steps, so values match within one step (RAMP_TOLERANCE).
+//  - boot phase 4 is now a 600 ms cross-fade into the live frame, where the
+//    old one faded towards the idle values in 50 steps of 12 ms.
+//  - shutdown: within SHUTDOWN_TOLERANCE counts.
+#include <unity.h>
+#include <Arduino.h>
+#include "app_state.h"
+#include "led_keyframes.h"
+#include "led_math.h"
+#include "color.h"
+#include "sim.h"
+
+// ---- from main.cpp ----
+void setup();
+void loop();
+void animShutdown();
+const Clip* stateClip(AppState state);
+extern ClipPlayer sceneFx;
+extern Adafruit_NeoPixel bodyStrip;
+
+#define PASS_MS            10 // loop() period the old scenes yielded at
+#define BOOT_EARLY_MS      30 // per phase
+#define RAMP_TOLERANCE     5  // one step of the old rampLevel() fades
+#define SHUTDOWN_TOLERANCE 2
+#define LOOP_TOLERANCE     2  // celebration (fixed-point sine vs half-sine ease)
+
+static const Clip* bootFx;
+static const Clip* shutdownFx;
+static uint16_t bodyPixels; // BodyLayout::active
+
+static Adafruit_NeoPixel body(1, -1, NEO_GRB + NEO_KHZ800); // bodyPixels long once they're known
+static Adafruit_NeoPixel buttons(3, -1, NEO_GRB + NEO_KHZ800);
+static Adafruit_NeoPixel* const STRIPS[] = { &body, &buttons }; // STRIP_BODY, STRIP_BUTTONS
+static uint16_t pixels[] = { 1, 3 };
+
+// ---- the old code ----
+// Level of a linear fade that moves `step` every `ms`, clamped at `to`
+static int rampLevel(unsigned long elapsed, int from, int to, int step, int ms) {
+  int moved = (int)(elapsed / ms) * step;
+  if (from < to) return min(from + moved, to);
+  return max(from - moved, to);
+}
+
+// First pass at or after t: when a scene waiting for t carried on
+static uint32_t passAt(uint32_t t) {
+  return (t + PASS_MS - 1) / PASS_MS * PASS_MS;
+}
+
+// ---- helpers ----
+static uint8_t red(uint32_t c)   { return c >> 16; }
+static uint8_t green(uint32_t c) { return c >> 8; }
+static uint8_t blue(uint32_t c)  { return c; }
+
+static void assertNear(int expected, int actual, int tolerance, const char* what, uint32_t t) {
+  char msg[64];
+  snprintf(msg, sizeof(msg), "%s at %lu ms: %d vs %d", what, (unsigned long)t, expected, actual);
+  TEST_ASSERT_TRUE_MESSAGE(abs(expected - actual) <= tolerance, msg);
+}
+
+// The live frame underneath, the same on every pass
+#define LIVE_BODY    colorRgb(20, 5, 7)
+#define LIVE_BUTTON0 colorRgb(80, 0, 0)
+#define LIVE_BUTTON2 colorRgb(0, 80, 0)
+
+static void paintLive() {
+  body.setBrightness(255);
+  buttons.setBrightness(255);
+  body.fill(LIVE_BODY);
+  buttons.clear();
+  buttons.setPixelColor(0, LIVE_BUTTON0);
+  buttons.setPixelColor(2, LIVE_BUTTON2);
+}
+
+// Clip time at which the channel of a pixel first gets to `value`
+static uint32_t firstAt(const Clip* clip, uint8_t pixel, uint8_t (*channel)(uint32_t), uint8_t value) {
+  ClipPlayer fx(STRIPS, pixels, 2);
+  fx.begin();
+  fx.play(clip, 0);
+  for (uint32_t t = 0; t < 5000; t++) {
+    paintLive();
+    fx.apply(t);
+    if (channel(buttons.getPixelColor(pixel)) == value) return t;
+  }
+  TEST_FAIL_MESSAGE("never got there");
+  return 0;
+}
+
+void setUp() {}
+void tearDown() {}
+
+// The clips are the firmware's own: boot starts in setup(), shutdown once
+// the goodnight lines are typed
+void test_find_the_clips() {
+  setup();
+  bootFx = sceneFx.current();
+  TEST_ASSERT_NOT_NULL(bootFx);
+  bodyPixels = bodyStrip.numPixels();
+  TEST_ASSERT_TRUE(bodyPixels > 0);
+  body.updateLength(bodyPixels);
+  pixels[0] = bodyPixels;
+
+  animShutdown();
+  unsigned long until = millis() + 30000;
+  while (millis() < until) {
+    loop();
+    const Clip* c = sceneFx.current();
+    if (c && c != bootFx) break;
+  }
+  shutdownFx = sceneFx.current();
+  TEST_ASSERT_NOT_NULL(shutdownFx);
+  TEST_ASSERT_TRUE(shutdownFx != bootFx);
+}
+
+void test_boot_phases_start_earlier_by_at_most_30ms_each() {
+  // Old: one body pixel per 60 ms, then button phases 1-3 ramp until the pass
+  // that sees the end, and phase 4 fades into idle
+  uint32_t oldStart[5];
+  oldStart[0] = 0;
+  oldStart[1] = passAt(60 * bodyPixels);                 // middle button: pink 0 -> 200, 3 per 8 ms
+  oldStart[2] = oldStart[1] + passAt((200 + 2) / 3 * 8); // sides 0 -> 255, 3 per 8 ms
+  oldStart[3] = oldStart[2] + passAt((255 + 2) / 3 * 8); // pink 200 -> 0, 5 per 8 ms
+  oldStart[4] = oldStart[3] + passAt(200 / 5 * 8);       // 50 steps of 12 ms into idle
+
+  uint32_t newStart[5];
+  newStart[0] = 0;
+  newStart[1] = 60 * bodyPixels; // the pink starts once the body is full (checked below)
+  newStart[2] = firstAt(bootFx, 1, red, 200);
+  newStart[3] = firstAt(bootFx, 0, red, 255);
+  newStart[4] = bootFx->lengthMs;
+
+  for (uint8_t k = 1; k < 5; k++) {
+    char msg[48];
+    snprintf(msg, sizeof(msg), "phase %u: old %lu, new %lu", k, (unsigned long)oldStart[k], (unsigned long)newStart[k]);
+    TEST_ASSERT_TRUE_MESSAGE(newStart[k] <= oldStart[k], msg);
+    TEST_ASSERT_TRUE_MESSAGE(oldStart[k] - newStart[k] <= (uint32_t)k * BOOT_EARLY_MS, msg);
+  }
+  TEST_ASSERT_EQUAL_UINT32(600, bootFx->blendOutMs); // old phase 4: 50 * 12 ms
+}
+
+void test_boot_values_phase_by_phase() {
+  ClipPlayer fx(STRIPS, pixels, 2);
+  fx.begin();
+  fx.play(bootFx, 0);
+  uint32_t pinkAt = 60 * bodyPixels;
+  uint32_t sidesAt = firstAt(bootFx, 1, red, 200);
+  uint32_t fadeAt = firstAt(bootFx, 0, red, 255);
+  uint32_t blendAt = bootFx->lengthMs;
+
+  for (uint32_t t = 0; t < blendAt + bootFx->blendOutMs; t += PASS_MS) {
+    paintLive();
+    fx.apply(t);
+
+    // Body flow, held through the rest: pixel i lit at 60 * i
+    if (t < blendAt) {
+      for (uint16_t i = 0; i < bodyPixels; i++) {
+        uint32_t c = body.getPixelColor(i);
+        if (t >= 60 * i) {
+          TEST_ASSERT_EQUAL_HEX32(colorRgb(180, 50, 80), c);
+        } else {
+          TEST_ASSERT_EQUAL_HEX32(0, c); // dark, not the live frame
+        }
+      }
+    }
+
+    uint32_t mid = buttons.getPixelColor(1);
+    uint32_t left = buttons.getPixelColor(0);
+    uint32_t right = buttons.getPixelColor(2);
+    if (t < pinkAt) {
+      TEST_ASSERT_EQUAL_HEX32(0, mid);
+    } else if (t < sidesAt) {
+      // Phase 1: (i, i/4, i/3) with i = rampLevel(0 -> 200, 3 per 8 ms)
+      int i = rampLevel(t - pinkAt, 0, 200, 3, 8);
+      assertNear(i, red(mid), RAMP_TOLERANCE, "pink R", t);
+      assertNear(i / 4, green(mid), RAMP_TOLERANCE, "pink G", t);
+      assertNear(i / 3, blue(mid), RAMP_TOLERANCE, "pink B", t);
+      TEST_ASSERT_EQUAL_HEX32(0, left);
+    } else if (t < fadeAt) {
+      // Phase 2: pink held at (200, 50, 67), RED and GREEN 0 -> 255
+      TEST_ASSERT_EQUAL_HEX32(colorRgb(200, 50, 67), mid);
+      int i = rampLevel(t - sidesAt, 0, 255, 3, 8);
+      assertNear(i, red(left), RAMP_TOLERANCE, "RED", t);
+      assertNear(i, green(right), RAMP_TOLERANCE, "GREEN", t);
+    } else if (t < blendAt) {
+      // Phase 3: pink 200 -> 0, 5 per 8 ms, the sides at full
+      int i = rampLevel(t - fadeAt, 200, 0, 5, 8);
+      assertNear(i, red(mid), RAMP_TOLERANCE, "pink fade R", t);
+      assertNear(i / 3, blue(mid), RAMP_TOLERANCE, "pink fade B", t);
+      TEST_ASSERT_EQUAL_HEX32(colorRgb(255, 0, 0), left);
+      TEST_ASSERT_EQUAL_HEX32(colorRgb(0, 255, 0), right);
+    } else {
+      // Phase 4: from the boot colours to whatever is live, in a straight
+      // line now, where the old code stepped every 12 ms
+      uint32_t dt = t - blendAt;
+      float old = min((int)(dt / 12), 50) / 50.0f;
+      float now = dt / 600.0f;
+      for (uint16_t i = 0; i < bodyPixels; i++) {
+        uint32_t c = body.getPixelColor(i);
+        assertNear(180 - (int)(now * (180 - red(LIVE_BODY))), red(c), 2, "blend body R", t);
+        assertNear(180 - (int)(old * (180 - red(LIVE_BODY))), red(c), RAMP_TOLERANCE, "old blend body R", t);
+        assertNear(80 - (int)(now * (80 - blue(LIVE_BODY))), blue(c), 2, "blend body B", t);
+      }
+      assertNear(255 - (int)(now * (255 - red(LIVE_BUTTON0))), red(left), 2, "blend RED", t);
+      assertNear(255 - (int)(old * (255 - red(LIVE_BUTTON0))), red(left), RAMP_TOLERANCE, "old blend RED", t);
+      assertNear(255 - (int)(now * (255 - green(LIVE_BUTTON2))), green(right), 2, "blend GREEN", t);
+    }
+  }
+
+  // Then it lets go: the live frame stays as it was painted
+  uint32_t end = blendAt + bootFx->blendOutMs;
+  TEST_ASSERT_TRUE(fx.done(end));
+  paintLive();
+  fx.apply(end);
+  TEST_ASSERT_NULL(fx.current());
+  TEST_ASSERT_EQUAL_HEX32(LIVE_BODY, body.getPixelColor(0));
+  TEST_ASSERT_EQUAL_HEX32(LIVE_BUTTON0, buttons.getPixelColor(0));
+}
+
+void test_shutdown_within_2_counts() {
+  ClipPlayer fx(STRIPS, pixels, 2);
+  fx.begin();
+  fx.play(shutdownFx, 0);
+  for (uint32_t t = 0; t <= shutdownFx->lengthMs + 100; t += PASS_MS) {
+    paintLive();
+    fx.apply(t);
+    // Old: i = rampLevel(150 -> 0, 5 per 20 ms); body (i, 0, i/3), buttons at brightness i
+    int i = rampLevel(t, 150, 0, 5, 20);
+    for (uint16_t p = 0; p < bodyPixels; p++) {
+      uint32_t c = body.getPixelColor(p);
+      assertNear(i, red(c), SHUTDOWN_TOLERANCE, "body R", t);
+      TEST_ASSERT_EQUAL(0, green(c));
+      assertNear(i / 3, blue(c), SHUTDOWN_TOLERANCE, "body B", t);
+    }
+    assertNear(i, buttons.getBrightness(), SHUTDOWN_TOLERANCE, "button brightness", t);
+  }
+  TEST_ASSERT_TRUE(fx.done(shutdownFx->lengthMs));
+  TEST_ASSERT_NOT_NULL(fx.current()); // holds black until the reset
+}
+
+void test_swap_flash_matches_exactly() {
+  const Clip* clip = stateClip(STATE_SWAP_MODE);
+  TEST_ASSERT_NOT_NULL(clip);
+  ClipPlayer fx(STRIPS, pixels, 2);
+  fx.begin();
+  fx.play(clip, 0);
+  // It runs on millis() itself, so anywhere in a long session too
+  const uint32_t from[] = { 0, 123457, 4000000001UL };
+  for (uint32_t start : from) {
+    for (uint32_t t = start; t - start < 3000; t++) {
+      paintLive();
+      fx.apply(t);
+      bool first = (t / 150) % 2 == 0;
+      TEST_ASSERT_EQUAL_HEX32(first ? colorRgb(0, 255, 0) : colorRgb(255, 0, 0), buttons.getPixelColor(0));
+      TEST_ASSERT_EQUAL_HEX32(first ? colorRgb(255, 0, 0) : colorRgb(0, 255, 0), buttons.getPixelColor(2));
+    }
+  }
+}
+
+void test_celebration_within_2_counts() {
+  const Clip* clip = stateClip(STATE_CELEBRATION);
+  TEST_ASSERT_NOT_NULL(clip);
+  ClipPlayer fx(STRIPS, pixels, 2);
+  fx.begin();
+  fx.play(clip, 0);
+  // Celebration comes a minute or two into a session
+  const uint32_t from[] = { 0, 95000, 180000 };
+  for (uint32_t start : from) {
+    for (uint32_t t = start; t - start < 4000; t += 3) {
+      paintLive();
+      fx.apply(t);
+      for (uint16_t i = 0; i < bodyPixels; i++) {
+        uint32_t wave = ledWave(t, i); // Q16
+        uint32_t c = body.getPixelColor(i);
+        TEST_ASSERT_EQUAL(255, red(c));
+        assertNear(20 + ((80 * wave) >> 16), green(c), LOOP_TOLERANCE, "wave G", t);
+        assertNear(30 + ((90 * wave) >> 16), blue(c), LOOP_TOLERANCE, "wave B", t);
+      }
+      int winPulse = ledWinPulse(t);
+      if (winPulse < 0) winPulse = 0;
+      for (uint8_t p = 0; p < 3; p++) {
+        uint32_t c = buttons.getPixelColor(p);
+        assertNear(winPulse / 4, red(c), LOOP_TOLERANCE, "pulse R", t);
+        TEST_ASSERT_EQUAL(200, green(c));
+        assertNear(winPulse / 4, blue(c), LOOP_TOLERANCE, "pulse B", t);
+      }
+    }
+  }
+}
+
+// A clip reaches every pixel the player was given for a strip, however
+// many, and none past them
+void test_clip_reaches_every_pixel_it_was_given() {
+  const uint16_t LONG = 300;
+  static Adafruit_NeoPixel strip(LONG + 1, -1, NEO_GRB + NEO_KHZ800);
+  static Adafruit_NeoPixel* const strips[] = { &strip };
+  static const Key RAMP[] = { { 0, 0, EASE_STEP }, { 1000, 1000, EASE_LINEAR } }; // the clip time itself
+  static const Track tracks[] = { { 0, CH_BLUE, 0, LONG + 1, 0, 1, CLIP_KEYS(RAMP) } }; // one past the end
+  static const Clip clip = { CLIP_TRACKS(tracks), 1000, 0, 0 };
+  const uint16_t given[] = { LONG };
+
+  ClipPlayer fx(strips, given, 1);
+  fx.begin();
+  fx.play(&clip, 0);
+  strip.fill(LIVE_BODY);
+  fx.apply(LONG);
+  for (uint16_t i = 0; i < LONG; i++) TEST_ASSERT_EQUAL_HEX32(colorRgb(0, 0, min(LONG - i, 255)), strip.getPixelColor(i));
+  TEST_ASSERT_EQUAL_HEX32(LIVE_BODY, strip.getPixelColor(LONG));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_find_the_clips);
+  RUN_TEST(test_boot_phases_start_earlier_by_at_most_30ms_each);
+  RUN_TEST(test_boot_values_phase_by_phase);
+  RUN_TEST(test_shutdown_within_2_counts);
+  RUN_TEST(test_swap_flash_matches_exactly);
+  RUN_TEST(test_celebration_within_2_counts);
+  RUN_TEST(test_clip_reaches_every_pixel_it_was_given);
+  return UNITY_END();
+}
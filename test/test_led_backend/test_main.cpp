@@ -0,0 +1,175 @@
+// The WS2812 symbol encoder the RMT translator runs, on the host: the
+// symbols for each bit and their timing, whole bytes only per call (so a
+// chunk under 8 symbols gets nowhere), the same stream however it is
+// chunked, ledDecode() flagging symbols outside the timing window, and the
+// capture backend's frame, timing and latch gap checks on the sim clock.
+#include <unity.h>
+#include "led_backend.h"
+#include "sim.h"
+
+#define FRAME_BYTES 37 // not a whole number of chunks
+
+static uint8_t frame[FRAME_BYTES];
+static LedSymbol whole[FRAME_BYTES * 8];
+static LedSymbol chunked[FRAME_BYTES * 8];
+static uint8_t decoded[FRAME_BYTES];
+
+static void fillFrame() {
+  for (uint8_t i = 0; i < FRAME_BYTES; i++) frame[i] = i * 73 + 5;
+}
+
+// Like the RMT driver calling the translator for `chunk` symbols at a time
+static size_t encodeInChunks(LedSymbol* out, size_t chunk) {
+  size_t n = 0, done = 0;
+  while (done < FRAME_BYTES) {
+    size_t used;
+    n += ledEncode(frame + done, FRAME_BYTES - done, out + n, chunk, &used);
+    if (!used) break;
+    done += used;
+  }
+  return n;
+}
+
+static LedSymbol stretched(LedSymbol s, int highTicks, int lowTicks) {
+  return LedSymbol::make(s.duration0() + highTicks, s.duration1() + lowTicks);
+}
+
+void setUp() {
+  fillFrame();
+}
+
+void tearDown() {}
+
+// ===== ENCODER =====
+
+void test_bits_become_ws2812_symbols() {
+  const uint8_t byte = 0xA5; // 1010 0101, MSB first
+  LedSymbol out[8];
+  size_t used = 99;
+  TEST_ASSERT_EQUAL(8, ledEncode(&byte, 1, out, 8, &used));
+  TEST_ASSERT_EQUAL(1, used);
+  for (uint8_t bit = 0; bit < 8; bit++) {
+    bool one = (byte << bit) & 0x80;
+    TEST_ASSERT_EQUAL(1, out[bit].level0());
+    TEST_ASSERT_EQUAL(0, out[bit].level1());
+    TEST_ASSERT_EQUAL(one ? LED_T1H : LED_T0H, out[bit].duration0());
+    TEST_ASSERT_EQUAL(one ? LED_T1L : LED_T0L, out[bit].duration1());
+  }
+
+  // Nominal timing is inside the window, and decodes back
+  uint8_t back = 0;
+  LedDecodeResult r = ledDecode(out, 8, &back, 1);
+  TEST_ASSERT_EQUAL(1, r.bytes);
+  TEST_ASSERT_EQUAL_UINT32(0, r.timingErrors);
+  TEST_ASSERT_EQUAL_HEX8(byte, back);
+}
+
+void test_encoder_only_writes_whole_bytes() {
+  size_t used;
+  for (size_t room = 0; room < 8; room++) {
+    used = 99;
+    TEST_ASSERT_EQUAL(0, ledEncode(frame, FRAME_BYTES, whole, room, &used));
+    TEST_ASSERT_EQUAL(0, used);
+  }
+  TEST_ASSERT_EQUAL(16, ledEncode(frame, FRAME_BYTES, whole, 23, &used));
+  TEST_ASSERT_EQUAL(2, used);
+  TEST_ASSERT_EQUAL(24, ledEncode(frame, 3, whole, 100, &used)); // and stops at the data
+  TEST_ASSERT_EQUAL(3, used);
+}
+
+void test_chunking_does_not_change_the_stream() {
+  size_t used;
+  TEST_ASSERT_EQUAL(FRAME_BYTES * 8, ledEncode(frame, FRAME_BYTES, whole, sizeof(whole) / sizeof(whole[0]), &used));
+  TEST_ASSERT_EQUAL(FRAME_BYTES, used);
+
+  const size_t chunks[] = { 8, 20, CAPTURE_CHUNK, 31, 64 };
+  for (size_t chunk : chunks) {
+    memset(chunked, 0, sizeof(chunked));
+    TEST_ASSERT_EQUAL(FRAME_BYTES * 8, encodeInChunks(chunked, chunk));
+    TEST_ASSERT_EQUAL_MEMORY(whole, chunked, sizeof(whole));
+  }
+
+  LedDecodeResult r = ledDecode(whole, FRAME_BYTES * 8, decoded, FRAME_BYTES);
+  TEST_ASSERT_EQUAL(FRAME_BYTES, r.bytes);
+  TEST_ASSERT_EQUAL_UINT32(0, r.timingErrors);
+  TEST_ASSERT_EQUAL_MEMORY(frame, decoded, FRAME_BYTES);
+}
+
+// ===== DECODER =====
+
+void test_decoder_flags_timing_outside_the_window() {
+  const uint8_t ones = 0xFF, zeros = 0x00;
+  LedSymbol one[8], zero[8];
+  size_t used;
+  ledEncode(&ones, 1, one, 8, &used);
+  ledEncode(&zeros, 1, zero, 8, &used);
+
+  // +-150 ns (6 ticks) is in spec, one tick more isn't
+  LedSymbol s[8];
+  uint8_t b;
+  for (uint8_t i = 0; i < 8; i++) s[i] = stretched(one[i], i % 2 ? 6 : -6, i % 2 ? -6 : 6);
+  TEST_ASSERT_EQUAL_UINT32(0, ledDecode(s, 8, &b, 1).timingErrors);
+  TEST_ASSERT_EQUAL_HEX8(0xFF, b);
+
+  s[2] = stretched(one[2], -7, 0);
+  s[5] = stretched(zero[5], 0, 7);
+  TEST_ASSERT_EQUAL_UINT32(2, ledDecode(s, 8, &b, 1).timingErrors);
+
+  // Levels the wrong way round
+  for (uint8_t i = 0; i < 8; i++) s[i] = zero[i];
+  s[0].val ^= 1u << 15;
+  s[7].val |= 1u << 31;
+  TEST_ASSERT_EQUAL_UINT32(2, ledDecode(s, 8, &b, 1).timingErrors);
+}
+
+// ===== CAPTURE BACKEND =====
+
+void test_capture_checks_the_frame_and_the_latch_gap() {
+  static LedSymbol symbols[FRAME_BYTES * 8];
+  static uint8_t out[FRAME_BYTES];
+  CaptureLedBackend tx(symbols, out, FRAME_BYTES);
+
+  tx.send(frame, FRAME_BYTES);
+  TEST_ASSERT_EQUAL_UINT32(1, tx.stats().frames);
+  TEST_ASSERT_EQUAL_UINT32(FRAME_BYTES * 8, tx.stats().symbols);
+  TEST_ASSERT_EQUAL_UINT32(0, tx.stats().timingErrors);
+  TEST_ASSERT_EQUAL_UINT32(0, tx.stats().mismatches);
+  TEST_ASSERT_EQUAL(FRAME_BYTES, tx.lastFrameBytes());
+  TEST_ASSERT_EQUAL_MEMORY(frame, tx.lastFrame(), FRAME_BYTES);
+
+  // Straight after: still inside the latch gap
+  tx.send(frame, FRAME_BYTES);
+  TEST_ASSERT_EQUAL_UINT32(1, tx.stats().gapErrors);
+
+  // Once the frame is out and the gap has passed, fine again
+  uint32_t frameUs = FRAME_BYTES * 8 * (LED_T0H + LED_T0L) * LED_TICK_NS / 1000;
+  simAdvanceUs(frameUs + LED_RESET_US);
+  frame[FRAME_BYTES - 1] ^= 1;
+  tx.send(frame, FRAME_BYTES);
+  TEST_ASSERT_EQUAL_UINT32(1, tx.stats().gapErrors);
+  TEST_ASSERT_EQUAL_UINT32(0, tx.stats().mismatches);
+  TEST_ASSERT_EQUAL_MEMORY(frame, tx.lastFrame(), FRAME_BYTES);
+}
+
+void test_capture_chunk_under_one_byte_gives_up() {
+  static LedSymbol symbols[FRAME_BYTES * 8];
+  static uint8_t out[FRAME_BYTES];
+  CaptureLedBackend tx(symbols, out, FRAME_BYTES, 7);
+
+  tx.send(frame, FRAME_BYTES); // returns instead of spinning
+  TEST_ASSERT_EQUAL_UINT32(1, tx.stats().frames);
+  TEST_ASSERT_EQUAL_UINT32(0, tx.stats().symbols);
+  TEST_ASSERT_EQUAL_UINT32(1, tx.stats().mismatches);
+  TEST_ASSERT_EQUAL(0, tx.lastFrameBytes());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_bits_become_ws2812_symbols);
+  RUN_TEST(test_encoder_only_writes_whole_bytes);
+  RUN_TEST(test_chunking_does_not_change_the_stream);
+  RUN_TEST(test_decoder_flags_timing_outside_the_window);
+  RUN_TEST(test_capture_checks_the_frame_and_the_latch_gap);
+  RUN_TEST(test_capture_chunk_under_one_byte_gives_up);
+  return UNITY_END();
+}
@@ -0,0 +1,79 @@
+// The fixed-point LED kernels against the float formulas they replaced
+// (restated below from the old updateLEDs()), for every millisecond of the
+// first SWEEP_MS: each 8-bit channel value within +-1. The phase steps are
+// rounded to whole units of 2^-32 turns, so the error grows with t; the
+// sweep covers well past the inactivity shutdown, after which millis()
+// starts again from a deep sleep.
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "led_math.h"
+
+#define SWEEP_MS   2000000UL
+#define WAVE_PIXELS 16
+
+static int breatheFloat(uint32_t t) {
+  float breathe = (exp(sin(t / 2500.0 * M_PI)) - 0.36787944) * 108.0;
+  long x = breathe; // map() takes a long
+  return (x - 0) * (100 - 20) / (255 - 0) + 20;
+}
+
+static void checkWithinOne(int expected, int actual, const char* kernel, uint32_t t) {
+  if (abs(expected - actual) <= 1) return;
+  char msg[80];
+  snprintf(msg, sizeof(msg), "%s at t=%lu: float %d, fixed %d", kernel, (unsigned long)t, expected, actual);
+  TEST_FAIL_MESSAGE(msg);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_breathe_matches_float() {
+  for (uint32_t t = 0; t < SWEEP_MS; t++) checkWithinOne(breatheFloat(t), ledBreathe(t), "ledBreathe", t);
+  // now - offsetMs wraps below 0 for the first pixels after boot: the phase
+  // wraps with it, so that's the same as a negative time
+  for (uint32_t back = 1; back <= 1000; back++) {
+    uint32_t t = 0 - back;
+    float breathe = (exp(sin(-(double)back / 2500.0 * M_PI)) - 0.36787944) * 108.0;
+    long x = breathe;
+    checkWithinOne(x * 80 / 255 + 20, ledBreathe(t), "ledBreathe before 0", t);
+  }
+}
+
+void test_wave_matches_float() {
+  for (uint32_t t = 0; t < SWEEP_MS; t++) {
+    for (uint8_t i = 0; i < WAVE_PIXELS; i++) {
+      float localWave = 0.5 + 0.5 * sin((t / 800.0 * M_PI) + (i * 0.5));
+      uint32_t wave = ledWave(t, i);
+      checkWithinOne(20 + (int)(80 * localWave), 20 + ((80 * wave) >> 16), "ledWave green", t);
+      checkWithinOne(30 + (int)(90 * localWave), 30 + ((90 * wave) >> 16), "ledWave blue", t);
+    }
+  }
+}
+
+void test_pulses_match_float() {
+  for (uint32_t t = 0; t < SWEEP_MS; t++) {
+    checkWithinOne(80 + (int)(sin(t / 800.0) * 60), ledSoftPulse(t), "ledSoftPulse", t);
+    checkWithinOne(100 + (int)(sin(t / 150.0) * 100), ledPanicPulse(t), "ledPanicPulse", t);
+    checkWithinOne(100 + (int)(sin(t / 300.0) * 155), ledWinPulse(t), "ledWinPulse", t);
+  }
+}
+
+void test_sine_table_endpoints() {
+  TEST_ASSERT_EQUAL_INT32(0, sinQ15(0));
+  TEST_ASSERT_EQUAL_INT32(32767, sinQ15(1UL << 30));
+  TEST_ASSERT_EQUAL_INT32(0, sinQ15(1UL << 31));
+  TEST_ASSERT_EQUAL_INT32(-32767, sinQ15(3UL << 30));
+  // the last step interpolates toward the guard entry, not past the table
+  TEST_ASSERT_TRUE(abs(sinQ15(0xFFFFFFFFUL)) <= 1);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_breathe_matches_float);
+  RUN_TEST(test_wave_matches_float);
+  RUN_TEST(test_pulses_match_float);
+  RUN_TEST(test_sine_table_endpoints);
+  return UNITY_END();
+}
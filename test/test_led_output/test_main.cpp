@@ -0,0 +1,169 @@
+// LedOutput decides when a strip is shown: a 12-pixel chain with 8 active,
+// through Adafruit's show() on the sim, which counts every call per pin
+// (simLedShows()). A second output with the capture backend checks the
+// bytes that limit() sends.
+#include <unity.h>
+#include "led_output.h"
+#include "color.h"
+#include "sim.h"
+
+#define PIN      6
+#define PHYSICAL 12
+#define ACTIVE   8
+
+static Adafruit_NeoPixel strip(PHYSICAL, PIN, NEO_GRB + NEO_KHZ800);
+static NeoPixelShowBackend showTx(strip);
+static LedOutput out(strip, showTx, ACTIVE, 0); // no refresh cap
+
+static Adafruit_NeoPixel capStrip(ACTIVE, -1, NEO_GRB + NEO_KHZ800);
+static LedSymbol capSymbols[ACTIVE * 3 * 8];
+static uint8_t capDecoded[ACTIVE * 3];
+static CaptureLedBackend capTx(capSymbols, capDecoded, sizeof(capDecoded));
+static LedOutput capOut(capStrip, capTx, ACTIVE, 0);
+
+static uint32_t showsBefore;
+
+static uint32_t newShows() {
+  return simLedShows(PIN) - showsBefore;
+}
+
+static void advanceMs(uint32_t ms) {
+  simAdvanceUs((uint64_t)ms * 1000);
+}
+
+static void paint() {
+  for (uint16_t i = 0; i < ACTIVE; i++) strip.setPixelColor(i, 10 * i, 200 - 10 * i, 77);
+}
+
+void setUp() {
+  strip.setBrightness(255);
+  out.limit(256);
+  out.begin();
+  showsBefore = simLedShows(PIN);
+}
+
+void tearDown() {}
+
+void test_begin_blanks_the_chain_once_then_streams_the_active_pixels() {
+  TEST_ASSERT_EQUAL(PHYSICAL, out.physicalPixels());
+  TEST_ASSERT_EQUAL(ACTIVE, strip.numPixels());
+  // a second begin() is one more blank frame, and nothing is allocated for it
+  uint32_t allocs = simHeapAllocs();
+  out.begin();
+  TEST_ASSERT_EQUAL_UINT32(1, newShows());
+  TEST_ASSERT_EQUAL_UINT32(allocs, simHeapAllocs());
+  TEST_ASSERT_EQUAL(ACTIVE, strip.numPixels());
+}
+
+void test_unchanged_frames_are_not_shown() {
+  TEST_ASSERT_FALSE(out.update(millis())); // still the black begin() sent
+  paint();
+  TEST_ASSERT_TRUE(out.update(millis()));
+  TEST_ASSERT_EQUAL_UINT32(1, newShows());
+
+  uint32_t unchanged = out.total().unchanged;
+  for (uint8_t i = 0; i < 100; i++) {
+    advanceMs(10);
+    paint(); // the same colours written again
+    TEST_ASSERT_FALSE(out.update(millis()));
+  }
+  TEST_ASSERT_EQUAL_UINT32(1, newShows());
+  TEST_ASSERT_EQUAL_UINT32(unchanged + 100, out.total().unchanged);
+
+  out.showNow(); // nothing new for it either
+  TEST_ASSERT_EQUAL_UINT32(1, newShows());
+}
+
+void test_changed_tail_is_shown() {
+  paint();
+  out.update(millis());
+  uint32_t shown = newShows();
+
+  // only the last active pixel changes
+  advanceMs(10);
+  strip.setPixelColor(ACTIVE - 1, 1, 2, 3);
+  TEST_ASSERT_TRUE(out.update(millis()));
+  TEST_ASSERT_EQUAL_UINT32(shown + 1, newShows());
+
+  // past the active pixels there is nothing to change
+  advanceMs(10);
+  strip.setPixelColor(ACTIVE, 255, 255, 255);
+  strip.setPixelColor(PHYSICAL - 1, 255, 255, 255);
+  TEST_ASSERT_FALSE(out.update(millis()));
+  TEST_ASSERT_EQUAL_UINT32(shown + 1, newShows());
+}
+
+void test_brightness_only_change_is_shown_once() {
+  paint();
+  out.update(millis());
+  uint8_t before[ACTIVE * 3];
+  memcpy(before, strip.getPixels(), sizeof(before));
+
+  // limit() scales what goes out, the strip's own bytes stay as they were
+  advanceMs(10);
+  out.limit(128);
+  TEST_ASSERT_TRUE(out.update(millis()));
+  TEST_ASSERT_EQUAL_MEMORY(before, strip.getPixels(), sizeof(before));
+  for (uint8_t i = 0; i < 10; i++) {
+    advanceMs(10);
+    TEST_ASSERT_FALSE(out.update(millis()));
+  }
+  TEST_ASSERT_EQUAL_UINT32(2, newShows());
+
+  // and lifting it again is one more frame
+  advanceMs(10);
+  out.limit(256);
+  TEST_ASSERT_TRUE(out.update(millis()));
+  TEST_ASSERT_FALSE(out.update(millis()));
+  TEST_ASSERT_EQUAL_UINT32(3, newShows());
+
+  // setBrightness() rescales the strip's buffer: a change like any other
+  advanceMs(10);
+  strip.setBrightness(100);
+  TEST_ASSERT_TRUE(out.update(millis()));
+  TEST_ASSERT_FALSE(out.update(millis()));
+  TEST_ASSERT_EQUAL_UINT32(4, newShows());
+}
+
+void test_limit_scales_the_bytes_sent() {
+  capOut.begin();
+  for (uint16_t i = 0; i < ACTIVE; i++) capStrip.setPixelColor(i, 255, 128, 10 * i);
+  uint8_t expected[ACTIVE * 3];
+  memcpy(expected, capStrip.getPixels(), sizeof(expected));
+  colorScaleBuffer(expected, sizeof(expected), 64);
+
+  advanceMs(10);
+  capOut.limit(64);
+  TEST_ASSERT_TRUE(capOut.update(millis()));
+  TEST_ASSERT_EQUAL(sizeof(expected), capTx.lastFrameBytes());
+  TEST_ASSERT_EQUAL_MEMORY(expected, capTx.lastFrame(), sizeof(expected));
+  TEST_ASSERT_EQUAL_UINT32(0, capTx.stats().mismatches);
+}
+
+void test_refresh_cap_defers_changes() {
+  static Adafruit_NeoPixel capped(ACTIVE, PIN + 1, NEO_GRB + NEO_KHZ800);
+  static NeoPixelShowBackend cappedTx(capped);
+  static LedOutput cappedOut(capped, cappedTx, ACTIVE, 50); // every 20 ms at most
+  cappedOut.begin();
+  uint32_t before = simLedShows(PIN + 1);
+
+  // a new colour every 5 ms: only every fourth one makes it out
+  for (uint8_t i = 1; i <= 40; i++) {
+    advanceMs(5);
+    capped.setPixelColor(0, i, 0, 0);
+    cappedOut.update(millis());
+  }
+  TEST_ASSERT_EQUAL_UINT32(10, simLedShows(PIN + 1) - before);
+  TEST_ASSERT_EQUAL_UINT32(30, cappedOut.total().deferred);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_begin_blanks_the_chain_once_then_streams_the_active_pixels);
+  RUN_TEST(test_unchanged_frames_are_not_shown);
+  RUN_TEST(test_changed_tail_is_shown);
+  RUN_TEST(test_brightness_only_change_is_shown_once);
+  RUN_TEST(test_limit_scales_the_bytes_sent);
+  RUN_TEST(test_refresh_cap_defers_changes);
+  return UNITY_END();
+}
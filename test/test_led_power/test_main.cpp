@@ -0,0 +1,95 @@
+// The current budget: ledFrameUa() up to long strips, ledBudgetScale() at its
+// edges (idle alone over the budget, an exact fit, one µA over) and never
+// letting a scaled frame go over, and LedPowerBudget setting limit() on the
+// outputs and booking the draw per state.
+#include <unity.h>
+#include "led_power.h"
+#include "color.h"
+#include "sim.h"
+
+void setUp() {}
+void tearDown() {}
+
+// ===== FRAME ESTIMATE =====
+
+void test_frame_ua_is_linear_in_the_bytes() {
+  TEST_ASSERT_EQUAL_UINT32(0, ledFrameUa(0));
+  TEST_ASSERT_EQUAL_UINT32(LED_CHANNEL_FULL_UA, ledFrameUa(255));
+  TEST_ASSERT_EQUAL_UINT32(3 * LED_CHANNEL_FULL_UA, ledFrameUa(3 * 255)); // one white pixel
+  TEST_ASSERT_EQUAL_UINT32(LED_CHANNEL_FULL_UA / 2 - 40, ledFrameUa(127)); // floored
+}
+
+void test_frame_ua_of_long_strips_does_not_overflow() {
+  // 300 white pixels: 229500 * 20000 is past 2^32
+  TEST_ASSERT_EQUAL_UINT32(300UL * 3 * LED_CHANNEL_FULL_UA, ledFrameUa(300UL * 3 * 255));
+  TEST_ASSERT_EQUAL_UINT32(1000UL * 3 * LED_CHANNEL_FULL_UA, ledFrameUa(1000UL * 3 * 255));
+}
+
+// ===== BUDGET SCALE =====
+
+void test_idle_at_or_over_budget_is_dark() {
+  TEST_ASSERT_EQUAL_UINT16(0, ledBudgetScale(1000, 500000, 500000));
+  TEST_ASSERT_EQUAL_UINT16(0, ledBudgetScale(1000, 500001, 500000));
+  TEST_ASSERT_EQUAL_UINT16(0, ledBudgetScale(0, 500000, 500000));
+}
+
+void test_exact_fit_is_untouched() {
+  TEST_ASSERT_EQUAL_UINT16(256, ledBudgetScale(0, 30000, 500000));
+  TEST_ASSERT_EQUAL_UINT16(256, ledBudgetScale(470000, 30000, 500000));
+  TEST_ASSERT_EQUAL_UINT16(255, ledBudgetScale(470001, 30000, 500000)); // one µA over
+}
+
+void test_scaled_frame_never_goes_over() {
+  const uint32_t idle = 33 * LED_IDLE_UA, budget = 500000;
+  for (uint32_t dynamic = budget - idle; dynamic < 20000000; dynamic += 7919) {
+    uint16_t s = ledBudgetScale(dynamic, idle, budget);
+    TEST_ASSERT_TRUE(s <= 256);
+    TEST_ASSERT_TRUE((uint64_t)dynamic * s / 256 + idle <= budget);
+    // and it doesn't give away more than one step of the scale
+    TEST_ASSERT_TRUE((uint64_t)dynamic * (s + 1) / 256 + idle > budget);
+  }
+}
+
+// ===== BUDGET ON THE OUTPUTS =====
+
+#define BUDGET_MA 100
+
+static Adafruit_NeoPixel strip(8, -1, NEO_GRB + NEO_KHZ800);
+static NeoPixelShowBackend tx(strip);
+static LedOutput out(strip, tx, 8, 0);
+static LedOutput* const OUTPUTS[] = { &out };
+
+void test_budget_limits_the_outputs_and_books_per_state() {
+  static LedPowerBudget budget(OUTPUTS, 1, BUDGET_MA);
+  out.begin();
+
+  // Dark: only the idle draw, untouched
+  budget.update(0, 1);
+  TEST_ASSERT_EQUAL_UINT16(256, budget.currentScale());
+  TEST_ASSERT_EQUAL_UINT32(8 * LED_IDLE_UA, budget.currentUa());
+
+  // 8 white pixels want 480 mA of 100
+  strip.fill(colorRgb(255, 255, 255));
+  budget.update(1000, 2);
+  TEST_ASSERT_TRUE(budget.currentScale() < 256);
+  TEST_ASSERT_TRUE(budget.currentUa() <= BUDGET_MA * 1000UL);
+  TEST_ASSERT_TRUE(budget.currentUa() > BUDGET_MA * 1000UL - 8 * 3 * LED_CHANNEL_FULL_UA / 256);
+
+  budget.update(1500, 2);
+  TEST_ASSERT_EQUAL_UINT32(1000, budget.stats(1).ms);
+  TEST_ASSERT_TRUE(budget.stats(1).uaMs == 1000ULL * 8 * LED_IDLE_UA);
+  TEST_ASSERT_EQUAL_UINT32(500, budget.stats(2).ms);
+  TEST_ASSERT_EQUAL_UINT32(500, budget.stats(2).limitedMs);
+  TEST_ASSERT_EQUAL_UINT32(budget.currentUa(), budget.stats(2).peakUa);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_frame_ua_is_linear_in_the_bytes);
+  RUN_TEST(test_frame_ua_of_long_strips_does_not_overflow);
+  RUN_TEST(test_idle_at_or_over_budget_is_dark);
+  RUN_TEST(test_exact_fit_is_untouched);
+  RUN_TEST(test_scaled_frame_never_goes_over);
+  RUN_TEST(test_budget_limits_the_outputs_and_books_per_state);
+  return UNITY_END();
+}
@@ -0,0 +1,80 @@
+// The firmware never touches the heap once it's running: a whole session,
+// from the dolphin through the NO answers, the trick, the final plea, the
+// celebration and the leave question into deep sleep, with every
+// allocation counted by the sim (simHeapAllocs(): operator new, and malloc,
+// calloc and realloc on glibc). setup() may allocate (the strips' pixel
+// buffers); nothing after it may.
+#include <unity.h>
+#include <Arduino.h>
+#include <setjmp.h>
+#include "app_state.h"
+#include "sim.h"
+
+void setup();
+void loop();
+
+#define YES_PIN   D1
+#define NO_PIN    D2
+#define PRESS_MS  100
+#define LIMIT_MS  300000UL
+
+// ms, pin: every screen but the goodnight branch, then the defiant answer
+// into deep sleep. Timeouts do the rest (cute answer, NO answers, trick
+// reveal, celebration, final animation, job done, defiant response).
+static const struct { uint32_t atMs; uint8_t pin; } SESSION[] = {
+  { 6000, YES_PIN }, { 12000, YES_PIN }, { 18000, YES_PIN }, { 24000, YES_PIN },  // intro
+  { 30000, YES_PIN }, { 36000, YES_PIN }, { 42000, YES_PIN }, { 48000, YES_PIN },
+  { 54000, NO_PIN }, { 60000, YES_PIN }, { 66000, YES_PIN }, { 72000, YES_PIN },  // cute?, question
+  { 78000, NO_PIN }, { 84000, NO_PIN }, { 90000, NO_PIN }, { 96000, NO_PIN },     // NO answers, trick
+  { 102000, YES_PIN }, { 108000, NO_PIN }, { 114000, YES_PIN },                   // reveal, plea, win
+  { 140000, NO_PIN },                                                             // leave? no
+};
+
+static jmp_buf asleep;
+static bool visited[STATE_COUNT];
+
+static void onDeepSleep() {
+  longjmp(asleep, 1);
+}
+
+static void schedulePress(uint32_t atMs, uint8_t pin) {
+  SimEvent ev = {};
+  ev.kind = SIM_PIN;
+  ev.pin = pin;
+  ev.atUs = atMs * 1000ULL;
+  ev.level = LOW;
+  TEST_ASSERT_TRUE(simSchedule(ev));
+  ev.atUs += PRESS_MS * 1000ULL;
+  ev.level = HIGH;
+  TEST_ASSERT_TRUE(simSchedule(ev));
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_session_never_allocates() {
+  for (auto& p : SESSION) schedulePress(p.atMs, p.pin);
+  simOnDeepSleep(onDeepSleep);
+
+  setup();
+  uint32_t before = simHeapAllocs();
+  if (!setjmp(asleep)) {
+    while (millis() < LIMIT_MS) {
+      loop();
+      visited[currentState] = true;
+    }
+    TEST_FAIL_MESSAGE("no deep sleep");
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, simHeapAllocs() - before);
+
+  // It did go all the way round
+  for (int st = 0; st < STATE_COUNT; st++) {
+    if (st != STATE_GOODNIGHT) TEST_ASSERT_TRUE_MESSAGE(visited[st], "state not reached");
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_session_never_allocates);
+  return UNITY_END();
+}
@@ -0,0 +1,114 @@
+// Press to state change, end to end on the sim's clock: a bouncing press at
+// an odd microsecond goes through the GPIO interrupt, the edge ring, the
+// debounce filter and loop()'s poll into dispatchEvent(). Every state gets
+// YES and NO while the typewriter is busy, and a state that takes the press
+// has to have made its transition within PRESS_LATENCY_US of the first
+// edge. The interaction trace (trace.h) has both times: the accepted edge
+// and the transition.
+#include <unity.h>
+#include <Arduino.h>
+#include <setjmp.h>
+#include "app_state.h"
+#include "scene.h"
+#include "trace.h"
+#include "sim.h"
+
+// ---- from main.cpp ----
+void setup();
+void loop();
+void enterState(AppState next, unsigned long now);
+void startNonBlockingTypewriter(const char* l1, const char* l2, const char* l3);
+extern AppState currentState;
+extern const char* MSG_CANT_CONTROL_1;
+extern const char* MSG_CANT_CONTROL_2;
+
+#define YES_PIN          D1
+#define NO_PIN           D2
+#define PRESS_LATENCY_US 20000
+#define SETTLE_MS        150 // in the state before the press; the last lockout is long over
+#define HOLD_MS          80
+#define AFTER_MS         200 // after the release, for presses the state ignores
+
+static jmp_buf asleep;
+
+static void onDeepSleep() {
+  longjmp(asleep, 1);
+}
+
+static void schedulePin(uint64_t atUs, uint8_t pin, uint8_t level) {
+  SimEvent ev = {};
+  ev.kind = SIM_PIN;
+  ev.pin = pin;
+  ev.atUs = atUs;
+  ev.level = level;
+  TEST_ASSERT_TRUE(simSchedule(ev));
+}
+
+// Contact bounce on the way down and on the way up
+static void scheduleBouncyPress(uint64_t atUs, uint8_t pin) {
+  const uint16_t BOUNCE_US[] = { 0, 180, 420, 900, 1300 };
+  for (uint8_t i = 0; i < 5; i++) schedulePin(atUs + BOUNCE_US[i], pin, i % 2 ? HIGH : LOW);
+  uint64_t up = atUs + HOLD_MS * 1000ULL;
+  for (uint8_t i = 0; i < 5; i++) schedulePin(up + BOUNCE_US[i], pin, i % 2 ? LOW : HIGH);
+}
+
+static void loopUntil(uint64_t us) {
+  while (simNowUs() < us) loop();
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_every_state_takes_a_press_within_20ms() {
+  simOnDeepSleep(onDeepSleep);
+  if (setjmp(asleep)) TEST_FAIL_MESSAGE("went to sleep");
+  setup();
+  loopUntil(simNowUs() + 500000);
+
+  uint8_t taken = 0;
+  for (uint8_t s = 0; s < STATE_COUNT; s++) {
+    for (uint8_t b = 0; b < 2; b++) {
+      char where[48];
+      snprintf(where, sizeof(where), "state %u, %s", s, b ? "NO" : "YES");
+
+      // Busy typing the longest line, nothing else going on
+      sceneStop();
+      startNonBlockingTypewriter(MSG_CANT_CONTROL_1, MSG_CANT_CONTROL_2, NULL);
+      enterState((AppState)s, millis());
+
+      // Somewhere different inside a loop() pass every time
+      uint64_t edgeUs = simNowUs() + SETTLE_MS * 1000ULL + (s * 7919 + b * 3301) % 10000;
+      scheduleBouncyPress(edgeUs, b ? NO_PIN : YES_PIN);
+      uint16_t from = traceCount();
+      loopUntil(edgeUs + (HOLD_MS + AFTER_MS) * 1000ULL);
+
+      // The first edge is the press (debounce is leading edge), once
+      const TraceRecord* r = traceRecords();
+      uint16_t n = traceCount();
+      uint16_t presses = 0;
+      for (uint16_t i = from; i < n; i++) {
+        if (r[i].kind != TRACE_PRESS) continue;
+        presses++;
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE((uint32_t)edgeUs, r[i].us, where);
+        TEST_ASSERT_EQUAL_MESSAGE(b, r[i].a, where);
+      }
+      TEST_ASSERT_EQUAL_MESSAGE(1, presses, where);
+
+      for (uint16_t i = from; i < n; i++) {
+        if (r[i].kind != TRACE_TRANSITION || !(r[i].c & TRACE_BY_PRESS)) continue;
+        TEST_ASSERT_EQUAL_MESSAGE(s, r[i].a, where);
+        TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(PRESS_LATENCY_US, r[i].us - (uint32_t)edgeUs, where);
+        taken++;
+        break;
+      }
+    }
+  }
+  TEST_ASSERT_TRUE(traceCount() < TRACE_CAPACITY); // or later presses went unrecorded
+  TEST_ASSERT_TRUE(taken >= STATE_COUNT); // most states take one of the two, many both
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_every_state_takes_a_press_within_20ms);
+  return UNITY_END();
+}
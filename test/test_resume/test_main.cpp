@@ -0,0 +1,169 @@
+// Deep sleep and the wake after it, on the sim's clock: where a wake picks
+// up for every state the cube can fall asleep in (resumeTarget(), the whole
+// mapping spelled out below), then whole sleeps. A leave question nobody
+// answered is asked again and takes a press straight away; once it has been
+// answered the cube wakes to the hearts and keeps them, through another
+// sleep too. Every wake has to have its first pixel on the panel within
+// FIRST_PIXEL_US of the button going down, and be on the resumed screen
+// reading presses within RESUME_US.
+//
+// A sleep here is a longjmp out of loop() and a wake is setup() again, with
+// the scene a reset would have dropped stopped by hand; RAM isn't cleared
+// in between the way the chip's is.
+#include <unity.h>
+#include <Arduino.h>
+#include <setjmp.h>
+#include "app_state.h"
+#include "display.h"
+#include "scene.h"
+#include "sim.h"
+
+// ---- from main.cpp ----
+void setup();
+void loop();
+void enterState(AppState next, unsigned long now);
+AppState resumeTarget(AppState slept);
+extern AppState currentState;
+
+#define YES_PIN        D1
+#define NO_PIN         D2
+#define WAKE_HOLD_MS   100 // the press that woke it, like the sim's -w
+#define FIRST_PIXEL_US 150000
+#define RESUME_US      300000
+#define INACTIVITY_MS  180000
+
+static jmp_buf asleep;
+
+static void onDeepSleep() {
+  longjmp(asleep, 1);
+}
+
+static void schedulePin(uint64_t atUs, uint8_t pin, uint8_t level) {
+  SimEvent ev = {};
+  ev.kind = SIM_PIN;
+  ev.pin = pin;
+  ev.atUs = atUs;
+  ev.level = level;
+  TEST_ASSERT_TRUE(simSchedule(ev));
+}
+
+static void schedulePress(uint64_t atUs, uint8_t pin) {
+  schedulePin(atUs, pin, LOW);
+  schedulePin(atUs + 100000, pin, HIGH);
+}
+
+static void loopUntil(uint64_t us) {
+  while (simNowUs() < us) loop();
+}
+
+// loop() until it goes to sleep; false if it hadn't within ms
+static bool sleepsWithin(uint32_t ms) {
+  if (setjmp(asleep)) return true;
+  loopUntil(simNowUs() + ms * 1000ULL);
+  return false;
+}
+
+// A wake by `pin`, still held when setup() runs, and RESUME_US of loop()
+// after it
+static void wakeBy(uint8_t pin, AppState expected) {
+  sceneStop(); // a reset drops whatever was running
+  simWakeFromSleep();
+  uint64_t wokeUs = simNowUs();
+  simSetPin(pin, LOW);
+  schedulePin(wokeUs + WAKE_HOLD_MS * 1000ULL, pin, HIGH);
+
+  uint32_t paintSeq = displayStats().paintSeq;
+  setup();
+  uint64_t readyUs = 0;
+  uint32_t firstPixelUs = 0;
+  bool painted = false;
+  while (simNowUs() < wokeUs + RESUME_US) {
+    loop();
+    if (!readyUs && currentState == expected) readyUs = simNowUs();
+    if (!painted && displayStats().paintSeq != paintSeq) {
+      painted = true;
+      firstPixelUs = displayStats().paintUs - (uint32_t)wokeUs;
+    }
+  }
+  TEST_ASSERT_TRUE_MESSAGE(painted, "nothing on the panel");
+  TEST_ASSERT_LESS_OR_EQUAL(FIRST_PIXEL_US, firstPixelUs);
+  TEST_ASSERT_TRUE_MESSAGE(readyUs != 0, "not on the resumed screen");
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_every_state_resumes_somewhere_that_stands_on_its_own() {
+  const AppState EXPECTED[STATE_COUNT] = {
+    STATE_INTRO_DOLPHIN,   // STATE_INTRO_DOLPHIN
+    STATE_INTRO_1,         // STATE_INTRO_1
+    STATE_VALENTINE_CHECK, // STATE_VALENTINE_CHECK
+    STATE_VALENTINE_CHECK, // STATE_GOODNIGHT: asked again, it was about to sleep anyway
+    STATE_INTRO_REMEMBER,  // STATE_INTRO_REMEMBER
+    STATE_INTRO_GREEN,     // STATE_INTRO_GREEN
+    STATE_INTRO_RED,       // STATE_INTRO_RED
+    STATE_INTRO_2,         // STATE_INTRO_2
+    STATE_INTRO_3,         // STATE_INTRO_3
+    STATE_INTRO_4,         // STATE_INTRO_4
+    STATE_INTRO_4,         // STATE_CUTE_RESPONSE: the answer to the question before it
+    STATE_INTRO_5,         // STATE_INTRO_5
+    STATE_INTRO_6,         // STATE_INTRO_6
+    STATE_IDLE,            // STATE_IDLE
+    STATE_IDLE,            // STATE_NO_RESPONSE: back to the question
+    STATE_IDLE,            // STATE_SWAP_MODE
+    STATE_IDLE,            // STATE_TRICK_REVEAL
+    STATE_IDLE,            // STATE_FAIR_RIGHT
+    STATE_IDLE,            // STATE_FINAL_PLEA
+    STATE_FINAL_ANIMATION, // STATE_CELEBRATION: the hearts, not the YES typed again
+    STATE_FINAL_ANIMATION, // STATE_FINAL_ANIMATION
+    STATE_JOB_DONE,        // STATE_JOB_DONE
+    STATE_LEAVE_QUESTION,  // STATE_LEAVE_QUESTION: nobody answered it
+    STATE_FINAL_ANIMATION, // STATE_DEFIANT_RESPONSE: answered, the hearts for good
+    STATE_FINAL_ANIMATION, // STATE_SHUTDOWN: answered, the hearts for good
+  };
+  for (uint8_t s = 0; s < STATE_COUNT; s++) {
+    char msg[16];
+    snprintf(msg, sizeof(msg), "state %u", s);
+    TEST_ASSERT_EQUAL_MESSAGE(EXPECTED[s], resumeTarget((AppState)s), msg);
+  }
+  TEST_ASSERT_EQUAL(STATE_INTRO_DOLPHIN, resumeTarget(STATE_NONE)); // garbage in RTC memory
+}
+
+void test_unanswered_leave_question_is_asked_again() {
+  simOnDeepSleep(onDeepSleep);
+  if (setjmp(asleep)) TEST_FAIL_MESSAGE("went to sleep");
+  setup();
+  loopUntil(simNowUs() + 500000);
+  enterState(STATE_LEAVE_QUESTION, millis());
+  TEST_ASSERT_TRUE(sleepsWithin(INACTIVITY_MS + 10000));
+
+  // Back to the question, and the answer inside RESUME_US counts
+  uint64_t wokeUs = simNowUs();
+  schedulePress(wokeUs + RESUME_US - 50000, YES_PIN);
+  wakeBy(NO_PIN, STATE_LEAVE_QUESTION);
+  TEST_ASSERT_EQUAL(STATE_SHUTDOWN, currentState);
+}
+
+void test_answered_leave_question_wakes_to_the_hearts_for_good() {
+  // YES to leaving: off it goes
+  TEST_ASSERT_TRUE(sleepsWithin(10000));
+  wakeBy(NO_PIN, STATE_FINAL_ANIMATION);
+
+  // FINAL_ANIMATION's own timeout would go on to JOB_DONE and the question
+  loopUntil(simNowUs() + 30000000ULL);
+  TEST_ASSERT_EQUAL(STATE_FINAL_ANIMATION, currentState);
+
+  // and an inactivity sleep on the hearts comes back to them too
+  TEST_ASSERT_TRUE(sleepsWithin(INACTIVITY_MS));
+  wakeBy(YES_PIN, STATE_FINAL_ANIMATION);
+  loopUntil(simNowUs() + 30000000ULL);
+  TEST_ASSERT_EQUAL(STATE_FINAL_ANIMATION, currentState);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_every_state_resumes_somewhere_that_stands_on_its_own);
+  RUN_TEST(test_unanswered_leave_question_is_asked_again);
+  RUN_TEST(test_answered_leave_question_wakes_to_the_hearts_for_good);
+  return UNITY_END();
+}
@@ -0,0 +1,157 @@
+// Every MSG_* line drawn from its build-time sprite (textDraw() on the whole
+// line) against u8g2's own drawStr() of the same characters, buffers
+// compared byte for byte: draw colours 0, 1 and 2, on and off page
+// boundaries, cut off at the top, the bottom and the right edge. The
+// sprite's box is the ink drawStr() lights. Solid font mode, which skips the
+// sprite for the glyph decoder, is held to the same standard, and so is
+// every prefix width.
+#include <unity.h>
+#include <U8g2lib.h>
+#include "text.h"
+#include "text_layout.h"
+
+#define BUFFER_BYTES 1024
+
+static U8G2_SSD1306_128X64_NONAME_F_HW_I2C display(U8G2_R0, U8X8_PIN_NONE);
+static uint8_t expected[BUFFER_BYTES];
+
+static void fillPattern() {
+  uint8_t* buf = display.getBufferPtr();
+  for (uint16_t i = 0; i < BUFFER_BYTES; i++) buf[i] = (uint8_t)(i * 37) ^ 0x5A;
+}
+
+// The line on its own, for drawStr()
+static const char* lineOf(const TextLayout& l) {
+  static char line[256];
+  memcpy(line, *l.message + l.start, l.len);
+  line[l.len] = '\0';
+  return line;
+}
+
+static TextView viewOf(const TextLayout& l) {
+  return { *l.message + l.start, l.len, &l };
+}
+
+// drawStr() and textDraw() at x, y in the current modes, then compared
+static void compareAt(const TextLayout& l, int x, int y, const char* mode) {
+  char where[96];
+  snprintf(where, sizeof(where), "\"%s\" %s colour %u at %d,%d", lineOf(l), mode, display.getDrawColor(), x, y);
+
+  fillPattern();
+  display.drawStr(x, y, lineOf(l));
+  memcpy(expected, display.getBufferPtr(), BUFFER_BYTES);
+
+  fillPattern();
+  textDraw(display, x, y, viewOf(l), l.len);
+  TEST_ASSERT_EQUAL_MEMORY_MESSAGE(expected, display.getBufferPtr(), BUFFER_BYTES, where);
+}
+
+static void compareEverywhere(const TextLayout& l, const char* mode) {
+  int w = l.widths[l.len];
+  // where the screens put them, odd rows, cut off at the top, the bottom and the right
+  const int at[][2] = {
+    { (128 - w) / 2, 17 }, { 0, 13 }, { 3, 20 }, { 1, 5 }, { 7, 63 }, { 128 - w / 2, 36 }, { 120, 40 },
+  };
+  for (uint8_t color = 0; color <= 2; color++) {
+    display.setDrawColor(color);
+    for (auto& p : at) compareAt(l, p[0], p[1], mode);
+  }
+  display.setDrawColor(1);
+}
+
+void setUp() {
+  display.setFontPosBaseline();
+  display.setFontDirection(0);
+}
+
+void tearDown() {}
+
+void test_every_line_has_a_layout() {
+  TEST_ASSERT_TRUE(sizeof(TEXT_LAYOUT) / sizeof(TEXT_LAYOUT[0]) > 0);
+  for (const TextLayout& l : TEXT_LAYOUT) {
+    // the firmware's own lookup finds it too, whole or split at '\n'
+    const char* line = *l.message + l.start;
+    TextView v = textView(*l.message);
+    TextView first, rest;
+    while (!(v.str == line && v.len == l.len) && textSplitLine(v, first, rest)) {
+      v = first.str == line ? first : rest;
+    }
+    TEST_ASSERT_TRUE_MESSAGE(v.str == line && v.len == l.len, lineOf(l));
+    TEST_ASSERT_NOT_NULL_MESSAGE(v.layout, lineOf(l));
+    TEST_ASSERT_EQUAL_MEMORY_MESSAGE(l.widths, v.layout->widths, l.len + 1, lineOf(l));
+  }
+}
+
+void test_widths_match_getStrWidth() {
+  char prefix[256];
+  for (const TextLayout& l : TEXT_LAYOUT) {
+    display.setFont(l.font);
+    for (uint8_t n = 1; n <= l.len; n++) {
+      memcpy(prefix, *l.message + l.start, n);
+      prefix[n] = '\0';
+      TEST_ASSERT_EQUAL_MESSAGE(display.getStrWidth(prefix), textWidth(display, viewOf(l), n), prefix);
+    }
+  }
+}
+
+void test_sprites_draw_like_drawStr() {
+  display.setFontMode(1);
+  for (const TextLayout& l : TEXT_LAYOUT) {
+    display.setFont(l.font);
+    compareEverywhere(l, "transparent");
+  }
+}
+
+// The generated ink box (x and top from the pen position, w, pages) is the
+// one drawStr() lights, placed so all of it is on screen
+void test_sprite_box_is_drawStr_ink() {
+  display.setFontMode(1);
+  display.setDrawColor(1);
+  for (const TextLayout& l : TEXT_LAYOUT) {
+    const TextSprite& s = l.sprite;
+    display.setFont(l.font);
+    int x = (128 - s.w) / 2 - s.x;
+    int y = 2 - s.top;
+    display.clearBuffer();
+    display.drawStr(x, y, lineOf(l));
+
+    int left = 128, right = -1, top = 64, bottom = -1;
+    const uint8_t* buf = display.getBufferPtr();
+    for (int px = 0; px < 128; px++) {
+      for (int py = 0; py < 64; py++) {
+        if (!(buf[(py / 8) * 128 + px] & (1 << (py % 8)))) continue;
+        if (px < left) left = px;
+        if (px > right) right = px;
+        if (py < top) top = py;
+        if (py > bottom) bottom = py;
+      }
+    }
+    if (!s.data) {
+      TEST_ASSERT_EQUAL_MESSAGE(-1, right, lineOf(l)); // no ink either
+      continue;
+    }
+    TEST_ASSERT_EQUAL_MESSAGE(x + s.x, left, lineOf(l));
+    TEST_ASSERT_EQUAL_MESSAGE(x + s.x + s.w - 1, right, lineOf(l));
+    TEST_ASSERT_EQUAL_MESSAGE(y + s.top, top, lineOf(l));
+    TEST_ASSERT_TRUE_MESSAGE(bottom < y + s.top + s.pages * 8 && bottom >= y + s.top + (s.pages - 1) * 8, lineOf(l));
+  }
+}
+
+void test_glyphs_draw_like_drawStr_in_solid_mode() {
+  display.setFontMode(0);
+  for (const TextLayout& l : TEXT_LAYOUT) {
+    display.setFont(l.font);
+    compareEverywhere(l, "solid");
+  }
+  display.setFontMode(1);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_every_line_has_a_layout);
+  RUN_TEST(test_widths_match_getStrWidth);
+  RUN_TEST(test_sprites_draw_like_drawStr);
+  RUN_TEST(test_sprite_box_is_drawStr_ink);
+  RUN_TEST(test_glyphs_draw_like_drawStr_in_solid_mode);
+  return UNITY_END();
+}
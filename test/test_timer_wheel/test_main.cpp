@@ -0,0 +1,354 @@
+// The timer wheel on its own, with a wheel of the test's own: a timer fires
+// at its deadline and not before, cancel() and re-arming move it, callbacks
+// re-arm their own timer and arm others, and nextDeadline() names the
+// earliest one on every level, parked timers included. Then the same
+// against a plain sorted list of deadlines for a long pseudo-random run of
+// arms, cancels and advances, once from 0 and once from just short of
+// 0xFFFFFFFF so millis() wraps mid-run.
+#include <unity.h>
+#include "timer_wheel.h"
+
+#define MAX_FIRED 4096
+
+struct Fired {
+  const Timer* timer;
+  uint32_t deadline;
+  uint32_t at;
+};
+
+static Fired fired[MAX_FIRED];
+static uint16_t firedCount;
+static TimerWheel* wheel;
+
+static void record(Timer& t, uint32_t now) {
+  TEST_ASSERT_TRUE_MESSAGE(firedCount < MAX_FIRED, "fired log full");
+  fired[firedCount++] = { &t, t.deadline, now };
+}
+
+// Every `*(uint32_t*)arg` ms until cleared
+static void periodic(Timer& t, uint32_t now) {
+  record(t, now);
+  uint32_t period = *(uint32_t*)t.arg;
+  if (period) wheel->arm(t, now + period);
+}
+
+// Arms the timer in arg for right now, so it fires in the same advance()
+static void chain(Timer& t, uint32_t now) {
+  record(t, now);
+  wheel->arm(*(Timer*)t.arg, now);
+}
+
+static void resetLog(TimerWheel& w) {
+  wheel = &w;
+  firedCount = 0;
+}
+
+void setUp() {}
+void tearDown() {}
+
+// ===== ARM AND CANCEL =====
+
+void test_timer_fires_at_its_deadline() {
+  TimerWheel w(1000);
+  resetLog(w);
+  Timer a(record);
+  TEST_ASSERT_FALSE(TimerWheel::armed(a));
+
+  w.arm(a, 1050);
+  TEST_ASSERT_TRUE(TimerWheel::armed(a));
+  TEST_ASSERT_EQUAL_UINT16(1, w.count());
+
+  w.advance(1049);
+  TEST_ASSERT_EQUAL_UINT16(0, firedCount);
+  TEST_ASSERT_EQUAL_UINT32(1049, w.time());
+
+  w.advance(1060); // stepped over: still fired at its own millisecond
+  TEST_ASSERT_EQUAL_UINT16(1, firedCount);
+  TEST_ASSERT_EQUAL_UINT32(1050, fired[0].at);
+  TEST_ASSERT_FALSE(TimerWheel::armed(a));
+  TEST_ASSERT_EQUAL_UINT16(0, w.count());
+  TEST_ASSERT_EQUAL_UINT32(1060, w.time());
+}
+
+void test_past_deadline_fires_on_the_next_advance() {
+  TimerWheel w(5000);
+  resetLog(w);
+  Timer a(record);
+  w.arm(a, 4990);
+  w.advance(5000);
+  TEST_ASSERT_EQUAL_UINT16(1, firedCount);
+  TEST_ASSERT_EQUAL_UINT32(5000, fired[0].at);
+}
+
+void test_cancel_and_rearm() {
+  TimerWheel w(0);
+  resetLog(w);
+  Timer a(record), b(record);
+
+  w.cancel(a); // not armed: nothing to do
+  TEST_ASSERT_EQUAL_UINT16(0, w.count());
+
+  w.arm(a, 100);
+  w.arm(b, 200);
+  w.cancel(a);
+  TEST_ASSERT_FALSE(TimerWheel::armed(a));
+  TEST_ASSERT_EQUAL_UINT16(1, w.count());
+
+  w.arm(b, 70000); // moved from level 0 to level 2, counted once
+  TEST_ASSERT_EQUAL_UINT16(1, w.count());
+  w.advance(69999);
+  TEST_ASSERT_EQUAL_UINT16(0, firedCount);
+
+  w.arm(b, 70010); // and back down
+  w.advance(80000);
+  TEST_ASSERT_EQUAL_UINT16(1, firedCount);
+  TEST_ASSERT_EQUAL_PTR(&b, fired[0].timer);
+  TEST_ASSERT_EQUAL_UINT32(70010, fired[0].at);
+}
+
+void test_same_slot_fires_in_deadline_order() {
+  TimerWheel w(0);
+  resetLog(w);
+  Timer a(record), b(record), c(record);
+  w.arm(c, 300000);
+  w.arm(a, 299999);
+  w.arm(b, 300000 + 64 * 64);
+  w.advance(400000);
+  TEST_ASSERT_EQUAL_UINT16(3, firedCount);
+  TEST_ASSERT_EQUAL_PTR(&a, fired[0].timer);
+  TEST_ASSERT_EQUAL_PTR(&c, fired[1].timer);
+  TEST_ASSERT_EQUAL_PTR(&b, fired[2].timer);
+  for (uint16_t i = 0; i < firedCount; i++) TEST_ASSERT_EQUAL_UINT32(fired[i].deadline, fired[i].at);
+}
+
+// ===== CALLBACKS =====
+
+void test_callback_rearms_itself() {
+  TimerWheel w(0);
+  resetLog(w);
+  uint32_t period = 30;
+  Timer tick(periodic, &period);
+  w.arm(tick, 30);
+
+  w.advance(1000); // one advance, every period in it
+  TEST_ASSERT_EQUAL_UINT16(33, firedCount);
+  for (uint16_t i = 0; i < firedCount; i++) TEST_ASSERT_EQUAL_UINT32(30 * (i + 1), fired[i].at);
+  TEST_ASSERT_TRUE(TimerWheel::armed(tick));
+
+  period = 0;
+  w.advance(1020);
+  TEST_ASSERT_EQUAL_UINT16(34, firedCount);
+  TEST_ASSERT_FALSE(TimerWheel::armed(tick));
+  TEST_ASSERT_EQUAL_UINT16(0, w.count());
+}
+
+void test_callback_arms_another_timer_for_now() {
+  TimerWheel w(0);
+  resetLog(w);
+  Timer second(record);
+  Timer first(chain, &second);
+  Timer later(record);
+  w.arm(first, 10);
+  w.arm(later, 11);
+
+  w.advance(100);
+  TEST_ASSERT_EQUAL_UINT16(3, firedCount);
+  TEST_ASSERT_EQUAL_PTR(&first, fired[0].timer);
+  TEST_ASSERT_EQUAL_PTR(&second, fired[1].timer);
+  TEST_ASSERT_EQUAL_UINT32(10, fired[1].at); // before the wheel moved on
+  TEST_ASSERT_EQUAL_PTR(&later, fired[2].timer);
+}
+
+// ===== NEXT DEADLINE =====
+
+void test_next_deadline_is_the_earliest_on_any_level() {
+  TimerWheel w(100);
+  resetLog(w);
+  uint32_t at = 0;
+  TEST_ASSERT_FALSE(w.nextDeadline(at));
+
+  Timer far(record), mid(record), near(record), parked(record);
+  w.arm(parked, 100 + (1UL << 30)); // past the top level
+  TEST_ASSERT_TRUE(w.nextDeadline(at));
+  TEST_ASSERT_EQUAL_UINT32(100 + (1UL << 30), at);
+
+  w.arm(far, 100 + 500000);
+  w.arm(mid, 100 + 5000);
+  w.arm(near, 100 + 40);
+  TEST_ASSERT_TRUE(w.nextDeadline(at));
+  TEST_ASSERT_EQUAL_UINT32(140, at);
+
+  w.cancel(near);
+  TEST_ASSERT_TRUE(w.nextDeadline(at));
+  TEST_ASSERT_EQUAL_UINT32(5100, at);
+
+  w.advance(5100);
+  TEST_ASSERT_TRUE(w.nextDeadline(at));
+  TEST_ASSERT_EQUAL_UINT32(500100, at);
+
+  // already due counts as the wheel's own time
+  w.arm(near, 10);
+  TEST_ASSERT_TRUE(w.nextDeadline(at));
+  TEST_ASSERT_EQUAL_UINT32(w.time(), at);
+
+  w.cancel(near);
+  w.cancel(far);
+  w.cancel(parked);
+  TEST_ASSERT_FALSE(w.nextDeadline(at));
+}
+
+void test_next_deadline_looks_past_parked_timers() {
+  TimerWheel w(0);
+  resetLog(w);
+  Timer parked(record), soon(record);
+  w.arm(parked, 1UL << 30); // parked in the top level's last slot
+
+  // A little later that slot is the next one round, but what lands in a
+  // slot after it comes first
+  const uint32_t topSlot = 1UL << (3 * TIMER_SLOT_BITS);
+  w.advance(62 * topSlot);
+  w.arm(soon, w.time() + 60 * topSlot);
+  uint32_t at = 0;
+  TEST_ASSERT_TRUE(w.nextDeadline(at));
+  TEST_ASSERT_EQUAL_UINT32(122 * topSlot, at);
+
+  w.cancel(parked);
+  w.cancel(soon);
+}
+
+// ===== MILLIS() WRAP =====
+
+void test_deadlines_across_the_wrap() {
+  const uint32_t start = 0xFFFFFFFFUL - 100;
+  TimerWheel w(start);
+  resetLog(w);
+  Timer before(record), after(record), hours(record);
+  w.arm(hours, start + 5000000); // level 3, across the wrap
+  w.arm(after, start + 300);     // 199 after the wrap
+  w.arm(before, start + 50);
+
+  uint32_t at = 0;
+  TEST_ASSERT_TRUE(w.nextDeadline(at));
+  TEST_ASSERT_EQUAL_UINT32(start + 50, at);
+
+  w.advance(start + 200); // across 0
+  TEST_ASSERT_EQUAL_UINT16(1, firedCount);
+  TEST_ASSERT_EQUAL_UINT32(start + 50, fired[0].at);
+  TEST_ASSERT_TRUE(w.nextDeadline(at));
+  TEST_ASSERT_EQUAL_UINT32(199, at);
+
+  w.advance(start + 6000000);
+  TEST_ASSERT_EQUAL_UINT16(3, firedCount);
+  TEST_ASSERT_EQUAL_PTR(&after, fired[1].timer);
+  TEST_ASSERT_EQUAL_UINT32(199, fired[1].at);
+  TEST_ASSERT_EQUAL_PTR(&hours, fired[2].timer);
+  TEST_ASSERT_EQUAL_UINT32(start + 5000000, fired[2].at);
+  TEST_ASSERT_EQUAL_UINT16(0, w.count());
+}
+
+// ===== AGAINST A SORTED LIST =====
+
+#define SWEEP_TIMERS 24
+#define SWEEP_STEPS  20000
+
+static uint32_t rngState;
+
+static uint32_t rnd(uint32_t n) {
+  rngState = rngState * 1664525UL + 1013904223UL;
+  return (rngState >> 8) % n;
+}
+
+// Arms, cancels and advances at random, checking every advance against the
+// deadlines it should fire: the same ones, in order, each at its own time
+// (or at the advance's start if it was already due)
+static void sweep(uint32_t start, uint32_t seed) {
+  static Timer timers[SWEEP_TIMERS] = {
+    Timer(record), Timer(record), Timer(record), Timer(record), Timer(record), Timer(record),
+    Timer(record), Timer(record), Timer(record), Timer(record), Timer(record), Timer(record),
+    Timer(record), Timer(record), Timer(record), Timer(record), Timer(record), Timer(record),
+    Timer(record), Timer(record), Timer(record), Timer(record), Timer(record), Timer(record),
+  };
+  TimerWheel w(start);
+  resetLog(w);
+  rngState = seed;
+  uint32_t now = start;
+  uint32_t expected[SWEEP_TIMERS];
+
+  for (uint32_t step = 0; step < SWEEP_STEPS; step++) {
+    Timer& t = timers[rnd(SWEEP_TIMERS)];
+    uint32_t op = rnd(10);
+    if (op < 4) {
+      static const uint32_t reach[] = { 64, 5000, 300000, 20000000 };
+      uint32_t r = rnd(5);
+      w.arm(t, r < 4 ? now + rnd(reach[r]) : now - rnd(50));
+      continue;
+    }
+    if (op < 5) {
+      w.cancel(t);
+      continue;
+    }
+
+    // What should fire, relative to now and already sorted
+    uint32_t adv = rnd(3) == 0 ? rnd(3000000) : rnd(100);
+    uint8_t n = 0, armedNow = 0;
+    uint32_t earliest = UINT32_MAX;
+    for (uint8_t i = 0; i < SWEEP_TIMERS; i++) {
+      if (!TimerWheel::armed(timers[i])) continue;
+      armedNow++;
+      int32_t rel = timers[i].deadline - now;
+      uint32_t due = rel < 0 ? 0 : rel;
+      if (due < earliest) earliest = due;
+      if (due > adv) continue;
+      uint8_t k = n++;
+      while (k && expected[k - 1] > due) {
+        expected[k] = expected[k - 1];
+        k--;
+      }
+      expected[k] = due;
+    }
+    TEST_ASSERT_EQUAL_UINT16(armedNow, w.count());
+
+    uint32_t at;
+    TEST_ASSERT_EQUAL(armedNow > 0, w.nextDeadline(at));
+    if (armedNow) {
+      int32_t rel = at - now;
+      TEST_ASSERT_EQUAL_UINT32(earliest, rel < 0 ? 0 : rel);
+    }
+
+    firedCount = 0;
+    w.advance(now + adv);
+    TEST_ASSERT_EQUAL_UINT16(n, firedCount);
+    for (uint8_t k = 0; k < n; k++) {
+      TEST_ASSERT_EQUAL_UINT32(expected[k], fired[k].at - now);
+      if (expected[k]) TEST_ASSERT_EQUAL_UINT32(fired[k].deadline, fired[k].at);
+    }
+    now += adv;
+    TEST_ASSERT_EQUAL_UINT32(now, w.time());
+  }
+  for (uint8_t i = 0; i < SWEEP_TIMERS; i++) w.cancel(timers[i]);
+}
+
+void test_matches_a_sorted_list_from_zero() {
+  sweep(0, 1);
+}
+
+void test_matches_a_sorted_list_across_the_wrap() {
+  sweep(0xFFFFFFFFUL - 1500000, 2);
+  sweep(0xFFFFFFFFUL - 63, 3);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_timer_fires_at_its_deadline);
+  RUN_TEST(test_past_deadline_fires_on_the_next_advance);
+  RUN_TEST(test_cancel_and_rearm);
+  RUN_TEST(test_same_slot_fires_in_deadline_order);
+  RUN_TEST(test_callback_rearms_itself);
+  RUN_TEST(test_callback_arms_another_timer_for_now);
+  RUN_TEST(test_next_deadline_is_the_earliest_on_any_level);
+  RUN_TEST(test_next_deadline_looks_past_parked_timers);
+  RUN_TEST(test_deadlines_across_the_wrap);
+  RUN_TEST(test_matches_a_sorted_list_from_zero);
+  RUN_TEST(test_matches_a_sorted_list_across_the_wrap);
+  return UNITY_END();
+}
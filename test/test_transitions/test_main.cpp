@@ -0,0 +1,339 @@
+// The transition table against the if/else chain it replaced: every state
+// gets YES, NO and its timeout, and must end up in the state the old
+// handleButtonPress()/loop() code went to, having drawn the same thing
+// (typed the same lines, started the same scene, shown the same screen).
+// Timeouts go through the timer wheel on the sim's clock and have to fire
+// exactly when the old `now - stateStartTime > ms` checks did.
+//
+// Known difference, pinned below: a press in STATE_SWAP_MODE used to stay in
+// SWAP_MODE with a trickRevealWaiting flag; the table calls that
+// STATE_TRICK_REVEAL.
+#include <unity.h>
+#include <Adafruit_NeoPixel.h>
+#include "app_state.h"
+#include "display.h"
+#include "scene.h"
+#include "text.h"
+#include "timer_wheel.h"
+#include "sim.h"
+
+// ---- from main.cpp ----
+void setup();
+void enterState(AppState next, unsigned long now);
+void noteActivity(unsigned long now);
+extern int noCount;
+extern bool lastCuteResponseWasYes;
+extern bool typewriterActive;
+extern TextView typewriterText[3];
+extern bool showingControlScreen2;
+extern TimerWheel timers;
+extern Timer stateTimer;
+extern Adafruit_NeoPixel buttonStrip;
+
+bool sceneGreenYes(Scene& s, unsigned long now);
+bool sceneRedNo(Scene& s, unsigned long now);
+bool scenePassportHappy(Scene& s, unsigned long now);
+bool scenePassportBad(Scene& s, unsigned long now);
+bool sceneValentine(Scene& s, unsigned long now);
+bool sceneShutdown(Scene& s, unsigned long now);
+void showControlScreen1();
+void showControlScreen2();
+void showFinalAnimationScreen();
+
+extern const char* MSG_INTRO_1;
+extern const char* MSG_VALENTINE_CHECK;
+extern const char* MSG_GOODNIGHT;
+extern const char* MSG_REMEMBER;
+extern const char* MSG_INTRO_2_1;
+extern const char* MSG_INTRO_2_2;
+extern const char* MSG_INTRO_3;
+extern const char* MSG_INTRO_4_1;
+extern const char* MSG_INTRO_4_2;
+extern const char* MSG_INTRO_5;
+extern const char* MSG_INTRO_6;
+extern const char* NO_RESPONSES[];
+extern const char* MSG_TRICK_PROMPT;
+extern const char* MSG_TRICK_REVEAL;
+extern const char* MSG_FAIR_1;
+extern const char* MSG_FAIR_2;
+extern const char* MSG_WIN_STD_1;
+extern const char* MSG_WIN_STD_2;
+extern const char* MSG_WIN_STD_3;
+extern const char* MSG_WIN_FINAL_1;
+extern const char* MSG_WIN_FINAL_2;
+extern const char* MSG_WIN_FINAL_3;
+extern const char* MSG_JOB_DONE_1;
+extern const char* MSG_JOB_DONE_2;
+extern const char* MSG_LEAVE_QUESTION;
+extern const char* MSG_CANT_CONTROL_1;
+extern const char* MSG_CANT_CONTROL_2;
+extern const char* MSG_SLEEP_1;
+extern const char* MSG_SLEEP_2;
+
+// ================= THE OLD CHAIN =================
+enum ActionKind : uint8_t {
+  DOES_NOTHING, // event ignored
+  TYPES,        // startNonBlockingTypewriter(lines...)
+  STARTS,       // a scene, typewriter stopped
+  SHOWS,        // a one-frame screen
+  TRICK_REVEAL, // button LEDs frozen swapped, then "You pressed YES!"
+  SHUTS_DOWN,   // animShutdown()
+};
+
+struct Expect {
+  AppState next;
+  ActionKind kind;
+  const char* const* lines[3]; // TYPES: the MSG_* variables, in order
+  SceneFn scene;               // STARTS
+  void (*screen)();            // SHOWS
+};
+
+struct OldRow {
+  AppState state;
+  uint16_t timeoutMs; // the old `now - stateStartTime > timeoutMs` check, 0 for none
+  Expect on[EVT_COUNT];
+};
+
+#define NOTHING           { STATE_NONE, DOES_NOTHING }
+#define TYPE(to, ...)     { to, TYPES, { __VA_ARGS__ } }
+#define START(to, fn)     { to, STARTS, {}, fn }
+#define SHOW(to, fn)      { to, SHOWS, {}, nullptr, fn }
+#define TRICK             { STATE_TRICK_REVEAL, TRICK_REVEAL }
+#define SHUTDOWN          { STATE_SHUTDOWN, SHUTS_DOWN }
+
+// Transcribed from handleButtonPress() and the loop() timeouts before the
+// table. CUTE_RESPONSE's timeout is after a YES, IDLE's NO is the first one.
+static const OldRow OLD_CHAIN[] = {
+  { STATE_INTRO_DOLPHIN,    0,     { TYPE(STATE_INTRO_1, &MSG_INTRO_1), TYPE(STATE_INTRO_1, &MSG_INTRO_1), NOTHING } },
+  { STATE_INTRO_1,          0,     { TYPE(STATE_VALENTINE_CHECK, &MSG_VALENTINE_CHECK), TYPE(STATE_VALENTINE_CHECK, &MSG_VALENTINE_CHECK), NOTHING } },
+  { STATE_VALENTINE_CHECK,  0,     { TYPE(STATE_INTRO_REMEMBER, &MSG_REMEMBER), TYPE(STATE_GOODNIGHT, &MSG_GOODNIGHT), NOTHING } },
+  { STATE_GOODNIGHT,        2000,  { NOTHING, NOTHING, SHUTDOWN } },
+  { STATE_INTRO_REMEMBER,   0,     { START(STATE_INTRO_GREEN, sceneGreenYes), START(STATE_INTRO_GREEN, sceneGreenYes), NOTHING } },
+  { STATE_INTRO_GREEN,      0,     { START(STATE_INTRO_RED, sceneRedNo), START(STATE_INTRO_RED, sceneRedNo), NOTHING } },
+  { STATE_INTRO_RED,        0,     { TYPE(STATE_INTRO_2, &MSG_INTRO_2_1, &MSG_INTRO_2_2), TYPE(STATE_INTRO_2, &MSG_INTRO_2_1, &MSG_INTRO_2_2), NOTHING } },
+  { STATE_INTRO_2,          0,     { TYPE(STATE_INTRO_3, &MSG_INTRO_3), TYPE(STATE_INTRO_3, &MSG_INTRO_3), NOTHING } },
+  { STATE_INTRO_3,          0,     { TYPE(STATE_INTRO_4, &MSG_INTRO_4_1, &MSG_INTRO_4_2), TYPE(STATE_INTRO_4, &MSG_INTRO_4_1, &MSG_INTRO_4_2), NOTHING } },
+  { STATE_INTRO_4,          0,     { START(STATE_CUTE_RESPONSE, scenePassportHappy), START(STATE_CUTE_RESPONSE, scenePassportBad), NOTHING } },
+  { STATE_CUTE_RESPONSE,    2000,  { NOTHING, NOTHING, TYPE(STATE_INTRO_5, &MSG_INTRO_5) } },
+  { STATE_INTRO_5,          0,     { TYPE(STATE_INTRO_6, &MSG_INTRO_6), TYPE(STATE_INTRO_6, &MSG_INTRO_6), NOTHING } },
+  { STATE_INTRO_6,          0,     { START(STATE_IDLE, sceneValentine), START(STATE_IDLE, sceneValentine), NOTHING } },
+  { STATE_IDLE,             0,     { TYPE(STATE_CELEBRATION, &MSG_WIN_STD_1, &MSG_WIN_STD_2, &MSG_WIN_STD_3), TYPE(STATE_NO_RESPONSE, &NO_RESPONSES[0]), NOTHING } },
+  { STATE_NO_RESPONSE,      2000,  { NOTHING, NOTHING, START(STATE_IDLE, sceneValentine) } },
+  { STATE_SWAP_MODE,        0,     { TRICK, TRICK, NOTHING } },
+  { STATE_TRICK_REVEAL,     2000,  { TRICK, TRICK, TYPE(STATE_FAIR_RIGHT, &MSG_FAIR_1, &MSG_FAIR_2) } },
+  { STATE_FAIR_RIGHT,       0,     { TYPE(STATE_CELEBRATION, &MSG_WIN_STD_1, &MSG_WIN_STD_2, &MSG_WIN_STD_3), SHOW(STATE_FINAL_PLEA, showControlScreen1), NOTHING } },
+  { STATE_FINAL_PLEA,       1500,  { TYPE(STATE_CELEBRATION, &MSG_WIN_FINAL_1, &MSG_WIN_FINAL_2, &MSG_WIN_FINAL_3), TYPE(STATE_CELEBRATION, &MSG_WIN_FINAL_1, &MSG_WIN_FINAL_2, &MSG_WIN_FINAL_3), SHOW(STATE_FINAL_PLEA, showControlScreen2) } },
+  { STATE_CELEBRATION,      10000, { TYPE(STATE_JOB_DONE, &MSG_JOB_DONE_1, &MSG_JOB_DONE_2), TYPE(STATE_JOB_DONE, &MSG_JOB_DONE_1, &MSG_JOB_DONE_2), SHOW(STATE_FINAL_ANIMATION, showFinalAnimationScreen) } },
+  { STATE_FINAL_ANIMATION,  5000,  { NOTHING, NOTHING, TYPE(STATE_JOB_DONE, &MSG_JOB_DONE_1, &MSG_JOB_DONE_2) } },
+  { STATE_JOB_DONE,         4000,  { TYPE(STATE_LEAVE_QUESTION, &MSG_LEAVE_QUESTION), TYPE(STATE_LEAVE_QUESTION, &MSG_LEAVE_QUESTION), TYPE(STATE_LEAVE_QUESTION, &MSG_LEAVE_QUESTION) } },
+  { STATE_LEAVE_QUESTION,   0,     { SHUTDOWN, TYPE(STATE_DEFIANT_RESPONSE, &MSG_CANT_CONTROL_1, &MSG_CANT_CONTROL_2), NOTHING } },
+  { STATE_DEFIANT_RESPONSE, 3000,  { SHUTDOWN, SHUTDOWN, SHUTDOWN } },
+  { STATE_SHUTDOWN,         0,     { NOTHING, NOTHING, NOTHING } },
+};
+static_assert(sizeof(OLD_CHAIN) / sizeof(OLD_CHAIN[0]) == STATE_COUNT, "a state is missing");
+
+#define PRESS_AFTER_MS 600 // past the celebration's 500 ms guard
+#define PANEL_BYTES    1024
+
+static const char* const EVENT_NAMES[EVT_COUNT] = { "YES", "NO", "timeout" };
+static char where[96];
+
+static void advanceMs(uint32_t ms) {
+  simAdvanceUs((uint64_t)ms * 1000);
+}
+
+// Runs whatever the wheel has due by now, the state timeout included
+static void advanceTimersMs(uint32_t ms) {
+  advanceMs(ms);
+  timers.advance(millis());
+}
+
+// Quiet firmware in `state`, entered the way dispatchEvent() enters it
+static void enter(AppState state) {
+  sceneStop();
+  typewriterActive = false;
+  for (TextView& t : typewriterText) t = TextView{};
+  showingControlScreen2 = false;
+  lastCuteResponseWasYes = true;
+  noCount = 0;
+  noteActivity(millis());
+  enterState(state, millis());
+}
+
+static void panelNow(uint8_t* out) {
+  displaySync();
+  memcpy(out, simPanelRam(), PANEL_BYTES);
+}
+
+static void checkAction(const Expect& want) {
+  if (want.next == STATE_NONE) return;
+  TEST_ASSERT_EQUAL_MESSAGE(want.next, currentState, where);
+
+  switch (want.kind) {
+    case TYPES:
+      TEST_ASSERT_TRUE_MESSAGE(typewriterActive, where);
+      for (uint8_t k = 0; k < 3; k++) {
+        if (want.lines[k]) TEST_ASSERT_EQUAL_PTR_MESSAGE(*want.lines[k], typewriterText[k].str, where);
+      }
+      TEST_ASSERT_NULL(sceneCurrent());
+      break;
+    case STARTS:
+      TEST_ASSERT_FALSE_MESSAGE(typewriterActive, where);
+      TEST_ASSERT_TRUE_MESSAGE(sceneCurrent() == want.scene, where);
+      break;
+    case SHOWS: {
+      static uint8_t got[PANEL_BYTES], ref[PANEL_BYTES];
+      panelNow(got);
+      want.screen();
+      panelNow(ref);
+      TEST_ASSERT_EQUAL_MEMORY_MESSAGE(ref, got, PANEL_BYTES, where);
+      break;
+    }
+    case TRICK_REVEAL:
+      TEST_ASSERT_TRUE_MESSAGE(typewriterActive, where);
+      TEST_ASSERT_EQUAL_PTR_MESSAGE(MSG_TRICK_REVEAL, typewriterText[0].str, where);
+      break;
+    case SHUTS_DOWN:
+      TEST_ASSERT_EQUAL_PTR_MESSAGE(MSG_SLEEP_1, typewriterText[0].str, where);
+      TEST_ASSERT_EQUAL_PTR_MESSAGE(MSG_SLEEP_2, typewriterText[1].str, where);
+      TEST_ASSERT_TRUE_MESSAGE(sceneCurrent() == sceneShutdown, where);
+      TEST_ASSERT_FALSE_MESSAGE(TimerWheel::armed(stateTimer), where);
+      break;
+    case DOES_NOTHING:
+      break;
+  }
+}
+
+void setUp() {}
+void tearDown() {}
+
+// ================= TESTS =================
+
+void test_presses_match_old_chain() {
+  for (const OldRow& row : OLD_CHAIN) {
+    for (uint8_t ev = EVT_YES; ev <= EVT_NO; ev++) {
+      snprintf(where, sizeof(where), "state %d on %s", row.state, EVENT_NAMES[ev]);
+      enter(row.state);
+      advanceMs(PRESS_AFTER_MS);
+      dispatchEvent((AppEvent)ev, millis());
+
+      const Expect& want = row.on[ev];
+      TEST_ASSERT_EQUAL_MESSAGE(want.next == STATE_NONE ? row.state : want.next, currentState, where);
+      checkAction(want);
+    }
+  }
+}
+
+void test_timeouts_match_old_chain() {
+  for (const OldRow& row : OLD_CHAIN) {
+    snprintf(where, sizeof(where), "state %d on timeout", row.state);
+    enter(row.state);
+    uint32_t t0 = millis();
+
+    if (!row.timeoutMs) {
+      TEST_ASSERT_FALSE_MESSAGE(TimerWheel::armed(stateTimer), where);
+      dispatchEvent(EVT_TIMEOUT, millis());
+      TEST_ASSERT_EQUAL_MESSAGE(row.state, currentState, where);
+      continue;
+    }
+
+    // Fires on the first millisecond the old check was true
+    TEST_ASSERT_TRUE_MESSAGE(TimerWheel::armed(stateTimer), where);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(t0 + row.timeoutMs + 1, stateTimer.deadline, where);
+    advanceTimersMs(row.timeoutMs);
+    TEST_ASSERT_EQUAL_MESSAGE(row.state, currentState, where);
+    advanceTimersMs(1);
+    checkAction(row.on[EVT_TIMEOUT]);
+  }
+}
+
+// Pure red or green, whatever the strip's brightness made of 255
+static char hue(uint32_t c) {
+  uint8_t r = c >> 16, g = c >> 8, b = c;
+  if (b) return '?';
+  if (r && !g) return 'R';
+  if (g && !r) return 'G';
+  return '?';
+}
+
+void test_swap_mode_press_swaps_button_leds() {
+  for (uint8_t ev = EVT_YES; ev <= EVT_NO; ev++) {
+    enter(STATE_SWAP_MODE);
+    dispatchEvent((AppEvent)ev, millis());
+    TEST_ASSERT_EQUAL(STATE_TRICK_REVEAL, currentState);
+    // YES lit red and NO green, whichever was pressed the pressed one "was YES"
+    TEST_ASSERT_EQUAL(ev == EVT_YES ? 'R' : 'G', hue(buttonStrip.getPixelColor(0)));
+    TEST_ASSERT_EQUAL(ev == EVT_YES ? 'G' : 'R', hue(buttonStrip.getPixelColor(2)));
+  }
+}
+
+void test_cute_answer_no_asks_again() {
+  enter(STATE_INTRO_4);
+  dispatchEvent(EVT_NO, millis());
+  TEST_ASSERT_EQUAL(STATE_CUTE_RESPONSE, currentState);
+  TEST_ASSERT_FALSE(lastCuteResponseWasYes);
+  advanceTimersMs(2001);
+  TEST_ASSERT_EQUAL(STATE_INTRO_4, currentState);
+  TEST_ASSERT_EQUAL_PTR(MSG_INTRO_4_1, typewriterText[0].str);
+  TEST_ASSERT_EQUAL_PTR(MSG_INTRO_4_2, typewriterText[1].str);
+}
+
+void test_no_presses_count_up_to_the_trick() {
+  enter(STATE_IDLE);
+  // TRIGGER_COUNT is 4: three answers, the fourth NO starts the trick
+  for (uint8_t i = 0; i < 3; i++) {
+    dispatchEvent(EVT_NO, millis());
+    TEST_ASSERT_EQUAL(STATE_NO_RESPONSE, currentState);
+    TEST_ASSERT_EQUAL_PTR(NO_RESPONSES[i], typewriterText[0].str);
+    TEST_ASSERT_EQUAL(i + 1, noCount);
+
+    // The 2 s only start once the answer is typed out
+    TEST_ASSERT_FALSE(TimerWheel::armed(stateTimer));
+    uint32_t guard = 0;
+    while (typewriterActive && guard++ < 10000) advanceTimersMs(1);
+    TEST_ASSERT_FALSE(typewriterActive);
+    TEST_ASSERT_EQUAL_UINT32(millis() + 2001, stateTimer.deadline);
+    advanceTimersMs(2000);
+    TEST_ASSERT_EQUAL(STATE_NO_RESPONSE, currentState);
+    advanceTimersMs(1);
+    TEST_ASSERT_EQUAL(STATE_IDLE, currentState);
+  }
+  dispatchEvent(EVT_NO, millis());
+  TEST_ASSERT_EQUAL(STATE_SWAP_MODE, currentState);
+  TEST_ASSERT_EQUAL_PTR(MSG_TRICK_PROMPT, typewriterText[0].str);
+}
+
+void test_celebration_ignores_presses_for_500ms() {
+  enter(STATE_CELEBRATION);
+  advanceMs(500);
+  dispatchEvent(EVT_YES, millis());
+  TEST_ASSERT_EQUAL(STATE_CELEBRATION, currentState);
+  advanceMs(1);
+  dispatchEvent(EVT_NO, millis());
+  TEST_ASSERT_EQUAL(STATE_JOB_DONE, currentState);
+}
+
+void test_final_plea_alternates_screens() {
+  enter(STATE_FAIR_RIGHT);
+  dispatchEvent(EVT_NO, millis());
+  TEST_ASSERT_EQUAL(STATE_FINAL_PLEA, currentState);
+  for (uint8_t i = 0; i < 4; i++) {
+    TEST_ASSERT_EQUAL(i % 2 == 1, showingControlScreen2);
+    advanceTimersMs(1501); // restarted on each toggle
+    TEST_ASSERT_EQUAL(STATE_FINAL_PLEA, currentState);
+  }
+  TEST_ASSERT_FALSE(showingControlScreen2);
+}
+
+int main() {
+  setup();
+  UNITY_BEGIN();
+  RUN_TEST(test_presses_match_old_chain);
+  RUN_TEST(test_timeouts_match_old_chain);
+  RUN_TEST(test_swap_mode_press_swaps_button_leds);
+  RUN_TEST(test_cute_answer_no_asks_again);
+  RUN_TEST(test_no_presses_count_up_to_the_trick);
+  RUN_TEST(test_celebration_ignores_presses_for_500ms);
+  RUN_TEST(test_final_plea_alternates_screens);
+  return UNITY_END();
+}
@@ -0,0 +1,171 @@
+"""Runs the microbenchmark suite ('B' in -DBENCH builds) and checks it against
+the stored baseline.
+
+    python tools/bench.py host [--env ENV] [--update]  simulator (pio run -e native_bench)
+    python tools/bench.py device --port PORT [--update]   board (pio run -e bench -t upload)
+    python tools/bench.py compare RESULT.json [--update]
+
+The firmware prints one JSON document per run: the target ("esp32c3" or
+"host", "_body300" added in the *_300 envs), the cycle counter rate and min/median/mean ticks per case. Each
+result is compared by median with bench/baseline-<target>.json; a case more
+than --threshold percent (default 10) slower fails the run with exit status 1.
+--update writes the result as the new baseline instead.
+
+The body_frame_<leds> cases are also printed as per-frame cost against LED
+count, with a straight-line fit and the share of a 60 fps frame it takes.
+
+Host numbers are only comparable with a baseline from the same machine.
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import time
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SIM_ENV = "native_bench"
+BASELINE_DIR = os.path.join(ROOT, "bench")
+
+# Boot and the intro are done by then; the suite itself runs at one instant
+# of virtual time, apart from a 1 ms delay between cases
+SIM_EVENTS = "2000 serial B;3000 end"
+
+
+def extract_json(lines):
+    doc = None
+    for line in lines:
+        line = line.strip()
+        if line.startswith('{"target"'):
+            doc = []
+        if doc is not None:
+            doc.append(line)
+            if line == "]}":
+                return json.loads("".join(doc))
+    raise ValueError("no benchmark output (was the firmware built with -DBENCH?)")
+
+
+def run_host(env):
+    program = os.path.join(ROOT, ".pio", "build", env, "program")
+    if not os.path.exists(program):
+        raise ValueError("%s missing, run: pio run -e %s" % (program, env))
+    out = subprocess.run([program, "-e", SIM_EVENTS], check=True, stderr=subprocess.DEVNULL,
+                         stdout=subprocess.PIPE, universal_newlines=True).stdout
+    return extract_json(out.splitlines())
+
+
+def run_device(port, timeout):
+    import serial  # pyserial, ships with PlatformIO
+
+    with serial.Serial(port, 115200, timeout=1) as link:
+        link.reset_input_buffer()
+        link.write(b"B")
+        lines = []
+        deadline = time.time() + timeout
+        while time.time() < deadline:
+            line = link.readline().decode("utf-8", "replace")
+            if not line:
+                continue
+            lines.append(line)
+            if line.strip() == "]}":
+                return extract_json(lines)
+    raise ValueError("timed out waiting for the benchmark on %s" % port)
+
+
+def compare(result, baseline, threshold):
+    base = {r["name"]: r for r in baseline["results"]}
+    failed = False
+    print("%-28s %10s %10s %8s" % ("case", "baseline", "median", "change"))
+    for r in result["results"]:
+        b = base.get(r["name"])
+        if b is None:
+            print("%-28s %10s %10d %8s" % (r["name"], "-", r["median"], "new"))
+            continue
+        change = 100.0 * (r["median"] - b["median"]) / max(b["median"], 1)
+        mark = ""
+        if change > threshold:
+            mark = "  REGRESSION"
+            failed = True
+        print("%-28s %10d %10d %+7.1f%%%s" % (r["name"], b["median"], r["median"], change, mark))
+    for name in base:
+        if name not in {r["name"] for r in result["results"]}:
+            print("%-28s %10d %10s %8s" % (name, base[name]["median"], "-", "gone"))
+    return not failed
+
+
+FRAME_CASE = "body_frame_"
+FRAME_BUDGET_US = 1e6 / 60
+
+
+def frame_scaling(result):
+    """Per-frame cost of the body_frame_<leds> cases, and a fit over LED count."""
+    rate = result.get("ticks_per_us") or 1
+    points = sorted((int(r["name"][len(FRAME_CASE):]), r["median"] / rate)
+                    for r in result["results"] if r["name"].startswith(FRAME_CASE))
+    if not points:
+        return
+    print("\n%6s %10s %10s %9s" % ("leds", "frame_us", "us_per_led", "60fps_pct"))
+    for leds, us in points:
+        print("%6d %10.2f %10.3f %8.2f%%" % (leds, us, us / leds, 100 * us / FRAME_BUDGET_US))
+    if len(points) > 1:
+        n = len(points)
+        mx = sum(p[0] for p in points) / n
+        my = sum(p[1] for p in points) / n
+        slope = sum((x - mx) * (y - my) for x, y in points) / sum((x - mx) ** 2 for x, _ in points)
+        base = my - slope * mx
+        print("fit: %.1f us + %.3f us per LED; 60 fps holds up to %d LEDs"
+              % (base, slope, int((FRAME_BUDGET_US - base) / slope) if slope > 0 else 0))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Run and check the microbenchmarks")
+    parser.add_argument("mode", choices=["host", "device", "compare"])
+    parser.add_argument("result", nargs="?", help="result JSON (compare only)")
+    parser.add_argument("--env", default=SIM_ENV, help="simulator build, e.g. native_bench_300 (host only)")
+    parser.add_argument("--port", help="serial port of the board (device only)")
+    parser.add_argument("--timeout", type=float, default=60, help="seconds to wait for the board")
+    parser.add_argument("--threshold", type=float, default=10, help="allowed median slowdown, percent")
+    parser.add_argument("--update", action="store_true", help="store the result as the new baseline")
+    args = parser.parse_args()
+
+    if args.mode == "host":
+        result = run_host(args.env)
+    elif args.mode == "device":
+        if not args.port:
+            raise ValueError("device needs --port")
+        result = run_device(args.port, args.timeout)
+    else:
+        if not args.result:
+            raise ValueError("compare needs a result file")
+        with open(args.result) as f:
+            result = json.load(f)
+
+    frame_scaling(result)
+    baseline_path = os.path.join(BASELINE_DIR, "baseline-%s.json" % result["target"])
+    if args.update:
+        os.makedirs(BASELINE_DIR, exist_ok=True)
+        with open(baseline_path, "w") as f:
+            json.dump(result, f, indent=1)
+            f.write("\n")
+        print("bench: wrote %s" % os.path.relpath(baseline_path, ROOT))
+        return 0
+
+    if not os.path.exists(baseline_path):
+        json.dump(result, sys.stdout, indent=1)
+        print("\nbench: no baseline at %s yet, store one with --update" % os.path.relpath(baseline_path, ROOT))
+        return 0
+
+    with open(baseline_path) as f:
+        baseline = json.load(f)
+    if baseline.get("ticks_per_us") != result.get("ticks_per_us"):
+        print("bench: warning, baseline was taken at %s ticks/us, this run at %s"
+              % (baseline.get("ticks_per_us"), result.get("ticks_per_us")))
+    return 0 if compare(result, baseline, args.threshold) else 1
+
+
+if __name__ == "__main__":
+    try:
+        sys.exit(main())
+    except ValueError as e:
+        sys.exit("bench: " + str(e))
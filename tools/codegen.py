@@ -0,0 +1,23 @@
+"""Shared plumbing for the pre-build generators in tools/."""
+
+import os
+
+
+def generated_dir(env):
+    """Build-local include directory for generated headers (added to CPPPATH)."""
+    path = os.path.join(env.subst("$BUILD_DIR"), "generated")
+    os.makedirs(path, exist_ok=True)
+    if path not in env.get("CPPPATH", []):
+        env.Append(CPPPATH=[path])
+    return path
+
+
+def write_if_changed(path, text):
+    """Leave the file (and its mtime) alone when nothing changed, so SCons
+    doesn't rebuild everything that includes it."""
+    if os.path.exists(path):
+        with open(path) as f:
+            if f.read() == text:
+                return
+    with open(path, "w") as f:
+        f.write(text)
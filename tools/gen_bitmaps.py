@@ -0,0 +1,212 @@
+"""Packs assets/*.xbm into the compressed bitmap format read by src/bitmap.cpp.
+
+The screens' XBM art is line drawings on an empty background, so consecutive
+rows are nearly identical and most pixels are 0. Each image is stored as:
+
+  1. every row XORed with the row above it (the first row as is), which
+     turns long vertical edges and the passport frames into more background;
+  2. those pixels in scan order, left to right, top to bottom, without the
+     XBM padding bits, run-length coded: one bit for the colour of the first
+     run, then each run length as an Elias gamma code (n zero bits, then the
+     length in n+1 bits, MSB first). Runs alternate colour.
+
+The decoder only needs the previous row (at most 16 bytes) to undo step 1,
+so it streams straight into the u8g2 buffer. Every packed image is unpacked
+again here and compared with the source before anything is written.
+
+Outputs, in the build's generated/ include directory:
+    bitmaps.h      BitmapId enum, one BMP_<NAME> per asset
+    bitmap_data.h  packed streams + the BITMAPS[] table (bitmap.cpp only)
+
+Runs as a PlatformIO pre: script, or by hand:
+    python tools/gen_bitmaps.py <out_dir>
+"""
+
+import glob
+import os
+import re
+import sys
+
+MAX_WIDTH = 128  # one row of the 128x64 panel, the decoder's row buffer
+
+
+def read_xbm(path):
+    with open(path) as f:
+        src = f.read()
+    w = int(re.search(r"#define\s+\w*_width\s+(\d+)", src).group(1))
+    h = int(re.search(r"#define\s+\w*_height\s+(\d+)", src).group(1))
+    body = src[src.index("{") + 1:src.rindex("}")]
+    data = [int(v, 16) for v in re.findall(r"0x[0-9a-fA-F]+", body)]
+    stride = (w + 7) // 8
+    if len(data) != stride * h:
+        raise ValueError("%s: %d bytes, expected %d for %dx%d" % (path, len(data), stride * h, w, h))
+    if w > MAX_WIDTH:
+        raise ValueError("%s: %d px is wider than the display" % (path, w))
+    return w, h, data
+
+
+def _pixels(w, h, data):
+    stride = (w + 7) // 8
+    return [[(data[y * stride + x // 8] >> (x % 8)) & 1 for x in range(w)] for y in range(h)]
+
+
+class _BitWriter:
+    def __init__(self):
+        self.bits = []
+
+    def put(self, value, n):
+        self.bits += [(value >> i) & 1 for i in reversed(range(n))]
+
+    def gamma(self, v):
+        n = v.bit_length() - 1
+        self.put(0, n)
+        self.put(v, n + 1)
+
+    def bytes(self):
+        bits = self.bits + [0] * (-len(self.bits) % 8)
+        return [int("".join(map(str, bits[i:i + 8])), 2) for i in range(0, len(bits), 8)]
+
+
+class _BitReader:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def get(self):
+        bit = (self.data[self.pos // 8] >> (7 - self.pos % 8)) & 1
+        self.pos += 1
+        return bit
+
+    def gamma(self):
+        n = 0
+        while self.get() == 0:
+            n += 1
+        v = 1
+        for _ in range(n):
+            v = (v << 1) | self.get()
+        return v
+
+
+def pack(w, h, data):
+    rows = _pixels(w, h, data)
+    scan = []
+    prev = [0] * w
+    for row in rows:
+        scan += [p ^ q for p, q in zip(row, prev)]
+        prev = row
+
+    out = _BitWriter()
+    out.put(scan[0], 1)
+    run = 1
+    for i in range(1, len(scan)):
+        if scan[i] == scan[i - 1]:
+            run += 1
+        else:
+            out.gamma(run)
+            run = 1
+    out.gamma(run)
+    return out.bytes()
+
+
+def unpack(w, h, stream):
+    """Back to XBM bytes (padding bits clear), mirroring bitmapDraw()."""
+    src = _BitReader(stream)
+    color = src.get()
+    left = src.gamma()
+    stride = (w + 7) // 8
+    out = [0] * (stride * h)
+    prev = [0] * stride
+    for y in range(h):
+        for c in range(stride):
+            bits = 0
+            for k in range(min(8, w - 8 * c)):
+                if left == 0:
+                    color ^= 1
+                    left = src.gamma()
+                bits |= color << k
+                left -= 1
+            bits ^= prev[c]
+            prev[c] = bits
+            out[y * stride + c] = bits
+    return out
+
+
+def _clear_padding(w, h, data):
+    stride = (w + 7) // 8
+    out = list(data)
+    if w % 8:
+        for y in range(h):
+            out[y * stride + stride - 1] &= (1 << (w % 8)) - 1
+    return out
+
+
+def _hex_lines(data, indent="  ", per_line=16):
+    return [indent + ", ".join("0x%02x" % b for b in data[i:i + per_line]) + ","
+            for i in range(0, len(data), per_line)]
+
+
+def generate(asset_dir):
+    assets = []
+    for path in sorted(glob.glob(os.path.join(asset_dir, "*.xbm"))):
+        name = os.path.splitext(os.path.basename(path))[0]
+        w, h, data = read_xbm(path)
+        packed = pack(w, h, data)
+        if unpack(w, h, packed) != _clear_padding(w, h, data):
+            raise ValueError("%s: packed stream does not round-trip" % path)
+        assets.append((name, w, h, data, packed))
+
+    ids = ["// Generated by tools/gen_bitmaps.py from assets/*.xbm. Do not edit.",
+           "#pragma once",
+           "#include <stdint.h>",
+           "",
+           "enum BitmapId : uint8_t {"]
+    body = ["// Generated by tools/gen_bitmaps.py from assets/*.xbm. Do not edit.",
+            "#pragma once",
+            "#include \"bitmap.h\"",
+            ""]
+    table = ["static const PackedBitmap BITMAPS[BMP_COUNT] = {"]
+    raw_total = packed_total = 0
+    for name, w, h, data, packed in assets:
+        ident = "BMP_" + name.upper()
+        ids.append("  %s, // %dx%d, %d -> %d bytes" % (ident, w, h, len(data), len(packed)))
+        body.append("static const uint8_t %s_DATA[] = {" % ident)
+        body += _hex_lines(packed)
+        body += ["};", ""]
+        table.append("  { \"%s\", %d, %d, %d, sizeof(%s_DATA), %s_DATA }," % (name, w, h, len(data), ident, ident))
+        raw_total += len(data)
+        packed_total += len(packed)
+        print("gen_bitmaps: %-16s %3dx%-3d %5d -> %4d bytes" % (name, w, h, len(data), len(packed)))
+    print("gen_bitmaps: %d -> %d bytes, %d bytes of flash saved" % (raw_total, packed_total, raw_total - packed_total))
+
+    ids += ["  BMP_COUNT", "};", ""]
+    body += table + ["};", ""]
+    return "\n".join(ids), "\n".join(body)
+
+
+def run(project_dir, out_dir):
+    from codegen import write_if_changed
+
+    ids, body = generate(os.path.join(project_dir, "assets"))
+    os.makedirs(out_dir, exist_ok=True)
+    write_if_changed(os.path.join(out_dir, "bitmaps.h"), ids)
+    write_if_changed(os.path.join(out_dir, "bitmap_data.h"), body)
+
+
+if "Import" in globals():  # PlatformIO pre: script (SCons)
+    Import("env")  # noqa: F821
+
+    project_dir = env.subst("$PROJECT_DIR")
+    sys.path.insert(0, os.path.join(project_dir, "tools"))
+    from codegen import generated_dir
+
+    try:
+        run(project_dir, generated_dir(env))
+    except ValueError as e:
+        sys.stderr.write("gen_bitmaps: %s\n" % e)
+        env.Exit(1)
+elif __name__ == "__main__":
+    sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+    try:
+        run(os.path.dirname(os.path.dirname(os.path.abspath(__file__))), sys.argv[1])
+    except ValueError as e:
+        sys.exit("gen_bitmaps: " + str(e))
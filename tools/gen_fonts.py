@@ -0,0 +1,260 @@
+"""Rebuilds every u8g2 font the firmware uses with only the glyphs it draws.
+
+Scans src/*.cpp for what gets rendered: every MSG_* string and NO_RESPONSES
+(in their own font, see gen_text_layout.py) and the string literals passed
+straight to drawStr()/getStrWidth()/textDrawStr(), which go into every font
+since the current font isn't known statically. Each u8g2_font_* the sources name is
+then written out again in u8g2's own format, header and glyph bitstreams
+unchanged but only the glyphs in use, so setFont()/drawStr() and everything
+else in u8g2 work on it as before.
+
+Next to each font goes a direct index, the offset of every glyph's data by
+character code, which fontDrawGlyph() (src/font.cpp) uses instead of u8g2's
+walk through the glyph list.
+
+A rendered byte that the font has no glyph for fails the build; u8g2 would
+silently skip it. Strings are UTF-8 in the source, and the _tr fonts only
+cover printable ASCII, so this is mostly about invisible characters pasted
+in with the text.
+
+Outputs, in the build's generated/ include directory:
+    fonts.h      the FONT_* data, and a #define from each u8g2 name to it
+    font_data.h  subset fonts, their indexes and the FONTS[] table (font.cpp only)
+
+Runs as a PlatformIO pre: script, or by hand:
+    python tools/gen_fonts.py <path/to/u8g2_fonts.c> <out_dir>
+"""
+
+import glob
+import os
+import re
+import sys
+
+HEADER_SIZE = 23  # u8g2_font.HEADER_SIZE
+FONT_REF_RE = re.compile(r"\bu8g2_font_\w+\b(?!\s*\()")  # not u8g2_font_*() functions
+LITERAL_CALL_RE = re.compile(r"\b(?:drawStr|drawUTF8|getStrWidth|getUTF8Width|textDrawStr)\s*\(([^;]*)\)\s*;")
+
+# Header words (big endian, offsets from the end of the header)
+POS_UPPER_A = 17
+POS_LOWER_A = 19
+POS_UNICODE = 21
+
+
+def font_ident(name):
+    return "FONT_" + name[len("u8g2_font_"):].upper()
+
+
+def scan_sources(src_dir):
+    """({font: {byte: (user, its text)}}, [font names]) for everything rendered."""
+    from gen_text_layout import DEFAULT_FONT, STR_RE, scan_messages
+    from u8g2_font import c_string_bytes
+
+    fonts = []
+    uses = {}
+    literals = []
+    for path in sorted(glob.glob(os.path.join(src_dir, "*.cpp"))):
+        with open(path, encoding="latin-1") as f:
+            source = f.read()
+        for name in FONT_REF_RE.findall(source):
+            if name not in fonts:
+                fonts.append(name)
+        for ref, _, text, font in scan_messages(source):
+            uses.setdefault(font, []).append((ref.lstrip("&"), text))
+        for m in LITERAL_CALL_RE.finditer(source):
+            for s in STR_RE.findall(m.group(1)):
+                line = source.count("\n", 0, m.start()) + 1
+                literals.append(("%s:%d" % (os.path.basename(path), line), c_string_bytes(s)))
+    if DEFAULT_FONT not in fonts and DEFAULT_FONT in uses:
+        fonts.append(DEFAULT_FONT)
+
+    used = {}
+    for name in fonts:
+        chars = {}
+        for who, text in uses.get(name, []) + literals:
+            for c in text:
+                if c != 0x0A:  # line break, split off before drawing
+                    chars.setdefault(c, (who, text))
+        used[name] = chars
+    return used, fonts
+
+
+def _describe(text, c):
+    """The missing byte, or the UTF-8 character it is part of."""
+    i = text.index(c)
+    start = i
+    while start > 0 and 0x80 <= text[start] < 0xC0:
+        start -= 1
+    for end in range(start + 1, min(start + 4, len(text)) + 1):
+        try:
+            ch = text[start:end].decode("utf-8")
+        except UnicodeDecodeError:
+            continue
+        if ord(ch) > 0x7F:
+            return "U+%04X (UTF-8 %s)" % (ord(ch), " ".join("%02X" % b for b in text[start:end]))
+        break
+    if c < 0x20:
+        return "0x%02X (control character)" % c
+    return "0x%02X '%s'" % (c, chr(c))
+
+
+def _word(data, pos):
+    return (data[pos] << 8) | data[pos + 1]
+
+
+def glyph_entries(data):
+    """{encoding: (offset, size)} of the 8-bit glyph list, and where it ends."""
+    entries = {}
+    pos = HEADER_SIZE
+    while data[pos + 1] != 0:
+        entries[data[pos]] = (pos, data[pos + 1])
+        pos += data[pos + 1]
+    return entries, pos
+
+
+def subset(data, keep):
+    """u8g2 font data holding only the glyphs in keep, plus {code: offset}."""
+    entries, end = glyph_entries(data)
+    out = bytearray(data[:HEADER_SIZE])
+    offsets = {}
+    upper_a = lower_a = None
+    for code in sorted(keep):
+        pos, size = entries[code]
+        if upper_a is None and code >= ord("A"):
+            upper_a = len(out) - HEADER_SIZE
+        if lower_a is None and code >= ord("a"):
+            lower_a = len(out) - HEADER_SIZE
+        offsets[code] = len(out)
+        out += data[pos:pos + size]
+
+    # The list terminator and the (unused) 16-bit glyph section go over as
+    # they are; only their position moves
+    tail = len(out) - HEADER_SIZE
+    unicode = _word(data, POS_UNICODE) - (end - HEADER_SIZE) + tail
+    out += data[end:]
+    out[0] = len(keep)
+    for pos, value in ((POS_UPPER_A, upper_a), (POS_LOWER_A, lower_a), (POS_UNICODE, unicode)):
+        value = tail if value is None else value
+        out[pos] = value >> 8
+        out[pos + 1] = value & 0xFF
+    return bytes(out), offsets
+
+
+def check_subset(full, sub, keep):
+    """Every kept glyph is found by u8g2's own lookup, with the same bits."""
+    full_entries, _ = glyph_entries(full)
+    sub_entries, _ = glyph_entries(sub)
+    if sorted(sub_entries) != sorted(keep):
+        raise ValueError("subset glyph list does not match")
+    for code in keep:
+        # u8g2_font_get_glyph_data(): jump to 'A' or 'a', then walk
+        pos = HEADER_SIZE
+        if code >= ord("a"):
+            pos += _word(sub, POS_LOWER_A)
+        elif code >= ord("A"):
+            pos += _word(sub, POS_UPPER_A)
+        while sub[pos + 1] != 0 and sub[pos] != code:
+            pos += sub[pos + 1]
+        fpos, size = full_entries[code]
+        if sub[pos:pos + size] != full[fpos:fpos + size]:
+            raise ValueError("glyph 0x%02X not found intact in the subset" % code)
+
+
+def _hex_lines(data, indent="  ", per_line=16):
+    return [indent + ", ".join("0x%02x" % b for b in data[i:i + per_line]) + ","
+            for i in range(0, len(data), per_line)]
+
+
+def generate(src_dir, fonts_c):
+    from u8g2_font import load_font
+
+    used, names = scan_sources(src_dir)
+
+    errors = []
+    for name in names:
+        glyphs = glyph_entries(load_font(fonts_c, name))[0]
+        for c, (who, text) in sorted(used[name].items()):
+            if c in glyphs:
+                continue
+            error = "%s: %s has no glyph for %s" % (who, name, _describe(text, c))
+            if error not in errors:
+                errors.append(error)
+    if errors:
+        raise ValueError("\n".join(errors))
+
+    ids = ["// Generated by tools/gen_fonts.py from src/*.cpp. Do not edit.",
+           "#pragma once",
+           "#include <stdint.h>",
+           "",
+           "#define FONT_COUNT %d" % len(names),
+           ""]
+    defines = []
+    body = ["// Generated by tools/gen_fonts.py from src/*.cpp. Do not edit.",
+            "#pragma once",
+            "#include \"font.h\"",
+            ""]
+    table = ["static const SubsetFont FONTS[FONT_COUNT] = {"]
+    full_total = sub_total = 0
+
+    for name in names:
+        full = load_font(fonts_c, name)
+        keep = sorted(used[name])
+        sub, offsets = subset(full, keep)
+        check_subset(full, sub, keep)
+
+        ident = font_ident(name)
+        first = keep[0] if keep else 0
+        count = keep[-1] - first + 1 if keep else 0
+        index = [offsets.get(first + i, 0) for i in range(count)]
+        size = len(sub) + 2 * count
+
+        ids.append("extern const uint8_t %s[]; // %d of %d glyphs" % (ident, len(keep), len(glyph_entries(full)[0])))
+        defines.append("#define %s %s" % (name, ident))
+        body.append("// %s: \"%s\"" % (name, "".join(chr(c) for c in keep).replace("\\", "\\\\").replace("*/", "*\\/")))
+        body.append("const uint8_t %s[] = {" % ident)
+        body += _hex_lines(sub)
+        body += ["};", ""]
+        body.append("static const uint16_t %s_INDEX[] = {" % ident)
+        body += ["  " + ", ".join(map(str, index[i:i + 16])) + "," for i in range(0, len(index), 16)]
+        body += ["};", ""]
+        table.append("  { \"%s\", %s, %d, %d, %d, %d, %s_INDEX }," % (name, ident, len(full), size, first, count, ident))
+
+        full_total += len(full)
+        sub_total += size
+        print("gen_fonts: %-22s %3d glyphs, %5d -> %4d bytes (%d of them index)"
+              % (name, len(keep), len(full), size, 2 * count))
+    print("gen_fonts: %d -> %d bytes, %d bytes of flash saved" % (full_total, sub_total, full_total - sub_total))
+
+    ids += ["", "// Every use of these u8g2 fonts gets the subset instead"] + defines + [""]
+    body += table + ["};", ""]
+    return "\n".join(ids), "\n".join(body)
+
+
+def run(project_dir, fonts_c, out_dir):
+    from codegen import write_if_changed
+
+    ids, body = generate(os.path.join(project_dir, "src"), fonts_c)
+    os.makedirs(out_dir, exist_ok=True)
+    write_if_changed(os.path.join(out_dir, "fonts.h"), ids)
+    write_if_changed(os.path.join(out_dir, "font_data.h"), body)
+
+
+if "Import" in globals():  # PlatformIO pre: script (SCons)
+    Import("env")  # noqa: F821
+
+    project_dir = env.subst("$PROJECT_DIR")
+    sys.path.insert(0, os.path.join(project_dir, "tools"))
+    from codegen import generated_dir
+    from u8g2_font import find_fonts_c
+
+    try:
+        run(project_dir, find_fonts_c(os.path.join(env.subst("$PROJECT_LIBDEPS_DIR"), env.subst("$PIOENV"))),
+            generated_dir(env))
+    except (ValueError, KeyError, FileNotFoundError) as e:
+        sys.stderr.write("gen_fonts: %s\n" % e)
+        env.Exit(1)
+elif __name__ == "__main__":
+    sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+    try:
+        run(os.path.dirname(os.path.dirname(os.path.abspath(__file__))), sys.argv[1], sys.argv[2])
+    except (ValueError, KeyError) as e:
+        sys.exit("gen_fonts: " + str(e))
@@ -0,0 +1,154 @@
+"""Precomputes the layout of every MSG_* string at build time.
+
+Scans the TEXT CONFIGURATION block of src/main.cpp (every `const char* MSG_*`
+plus the NO_RESPONSES array), splits each message at '\\n' and measures every
+prefix of every line with the real u8g2 font data. The result is
+text_layout.h in the build directory: per line, a table where widths[n] is
+exactly what getStrWidth() would return for the first n characters, so the
+typewriter centres text by indexing instead of walking glyphs every tick.
+
+Every line is also rendered into a sprite, its ink laid out page-major like
+the u8g2 buffer (byte page * w + column, LSB the top row), which textDraw()
+ORs into the buffer whenever it draws the whole line.
+
+Messages are measured in u8g2_font_t0_13b_tr unless the definition carries a
+trailing `// font: <u8g2 font name>` comment. A line wider than the 128 px
+panel fails the build.
+
+Runs as a PlatformIO pre: script, or by hand:
+    python tools/gen_text_layout.py <path/to/u8g2_fonts.c> <out_dir>
+"""
+
+import os
+import re
+import sys
+
+DISPLAY_WIDTH = 128
+DEFAULT_FONT = "u8g2_font_t0_13b_tr"
+OUT_NAME = "text_layout.h"
+
+MSG_RE = re.compile(r'const\s+char\s*\*\s*(MSG_\w+)\s*=\s*"((?:[^"\\]|\\.)*)"\s*;([^\n]*)')
+ARRAY_RE = re.compile(r'const\s+char\s*\*\s*(NO_RESPONSES)\s*\[\s*\]\s*=\s*\{(.*?)\}\s*;', re.S)
+STR_RE = re.compile(r'"((?:[^"\\]|\\.)*)"')
+FONT_RE = re.compile(r'//\s*font:\s*(\w+)')
+
+
+def scan_messages(source):
+    """[(c_ref, decl, bytes, font)] in source order."""
+    from u8g2_font import c_string_bytes
+
+    found = []
+    for m in MSG_RE.finditer(source):
+        font = FONT_RE.search(m.group(3))
+        found.append((m.start(), "&" + m.group(1), "extern const char* %s;" % m.group(1),
+                      c_string_bytes(m.group(2)), font.group(1) if font else DEFAULT_FONT))
+    for m in ARRAY_RE.finditer(source):
+        decl = "extern const char* %s[];" % m.group(1)
+        for i, s in enumerate(STR_RE.findall(m.group(2))):
+            found.append((m.start(), "&%s[%d]" % (m.group(1), i), decl, c_string_bytes(s), DEFAULT_FONT))
+    found.sort(key=lambda f: f[0])
+    return [f[1:] for f in found]
+
+
+def _comment(line):
+    return line.decode("latin-1").encode("ascii", "backslashreplace").decode().replace("*/", "*\\/")
+
+
+def sprite_bytes(rows):
+    """Page-major packing of rows of 0/1: ([bytes], pages)."""
+    h = len(rows)
+    w = len(rows[0]) if rows else 0
+    pages = (h + 7) // 8
+    out = []
+    for p in range(pages):
+        for c in range(w):
+            out.append(sum(rows[r][c] << (r - 8 * p) for r in range(8 * p, min(8 * p + 8, h))))
+    return out, pages
+
+
+def generate(source, fonts_c):
+    from u8g2_font import Font, load_font
+
+    fonts = {}
+    errors = []
+    decls = []
+    arrays = []
+    entries = []
+    sprite_total = 0
+
+    for ref, decl, text, font_name in scan_messages(source):
+        if decl not in decls:
+            decls.append(decl)
+        if font_name not in fonts:
+            fonts[font_name] = Font(font_name, load_font(fonts_c, font_name))
+        font = fonts[font_name]
+
+        start = 0
+        for line in text.split(b"\n"):
+            missing = sorted({c for c in line if not font.has_glyph(c)})
+            if missing:
+                print("gen_text_layout: warning: %s has no glyph for %s in \"%s\""
+                      % (font_name, ", ".join("0x%02X" % c for c in missing), _comment(line)))
+            widths = [font.str_width(line[:n]) for n in range(len(line) + 1)]
+            if widths[-1] > DISPLAY_WIDTH:
+                errors.append("%s: \"%s\" is %d px wide in %s, the display is %d px"
+                              % (ref.lstrip("&"), _comment(line), widths[-1], font_name, DISPLAY_WIDTH))
+            index = len(entries)
+            arrays.append("static const uint8_t TW_%d[] = { %s }; // \"%s\""
+                          % (index, ", ".join(map(str, widths)), _comment(line)))
+
+            x, top, rows = font.rasterize(line)
+            data, pages = sprite_bytes(rows)
+            w = len(rows[0]) if rows else 0
+            sprite = "nullptr"
+            if data:
+                sprite = "TS_%d" % index
+                arrays.append("static const uint8_t %s[] = { %s };" % (sprite, ", ".join(map(str, data))))
+            sprite_total += len(data)
+
+            entries.append("  { %s, %d, %d, %s, TW_%d, { %d, %d, %d, %d, %s } },"
+                           % (ref, start, len(line), font_name, index, x, top, w, pages, sprite))
+            start += len(line) + 1
+
+    if errors:
+        raise ValueError("\n".join(errors))
+    print("gen_text_layout: %d lines, %d bytes of sprites" % (len(entries), sprite_total))
+
+    out = ["// Generated by tools/gen_text_layout.py from src/main.cpp. Do not edit.",
+           "#pragma once",
+           "#include \"text.h\"",
+           ""]
+    out += decls + [""] + arrays + [""]
+    out += ["static const TextLayout TEXT_LAYOUT[] = {"] + entries + ["};", ""]
+    return "\n".join(out)
+
+
+def run(project_dir, fonts_c, out_dir):
+    from codegen import write_if_changed
+
+    with open(os.path.join(project_dir, "src", "main.cpp"), encoding="latin-1") as f:
+        source = f.read()
+    os.makedirs(out_dir, exist_ok=True)
+    write_if_changed(os.path.join(out_dir, OUT_NAME), generate(source, fonts_c))
+
+
+if "Import" in globals():  # PlatformIO pre: script (SCons)
+    Import("env")  # noqa: F821
+
+    project_dir = env.subst("$PROJECT_DIR")
+    sys.path.insert(0, os.path.join(project_dir, "tools"))
+    from codegen import generated_dir
+    from u8g2_font import find_fonts_c
+
+    try:
+        run(project_dir, find_fonts_c(os.path.join(env.subst("$PROJECT_LIBDEPS_DIR"), env.subst("$PIOENV"))),
+            generated_dir(env))
+    except (ValueError, FileNotFoundError) as e:
+        sys.stderr.write("gen_text_layout: %s\n" % e)
+        env.Exit(1)
+elif __name__ == "__main__":
+    sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+    try:
+        run(os.path.dirname(os.path.dirname(os.path.abspath(__file__))), sys.argv[1], sys.argv[2])
+    except ValueError as e:
+        sys.exit("gen_text_layout: " + str(e))
@@ -0,0 +1,34 @@
+"""Build setup for env:native, the host simulator in sim/.
+
+Puts the sim/ stand-ins (Arduino core, Wire, Adafruit_NeoPixel, esp_sleep and
+the U8g2 display class) first on the include path and builds them together
+with U8g2's portable C core (src/clib of the installed library), so text and
+bitmaps are drawn by the real u8g2 code with the real fonts. U8g2 itself is
+lib_ignore'd in that env: its C++ wrapper needs the Arduino core.
+
+Under pio test the test's own main() replaces sim_main.cpp, the rest of sim/
+is the same.
+
+PlatformIO pre: script only.
+"""
+
+import glob
+import os
+import sys
+
+Import("env")  # noqa: F821
+
+project_dir = env.subst("$PROJECT_DIR")
+sim_dir = os.path.join(project_dir, "sim")
+libdeps_dir = os.path.join(env.subst("$PROJECT_LIBDEPS_DIR"), env.subst("$PIOENV"))
+
+hits = glob.glob(os.path.join(libdeps_dir, "**", "clib", "u8g2.h"), recursive=True)
+if not hits:
+    sys.stderr.write("sim_env: U8g2 clib/ not found under %s (is U8g2 in lib_deps?)\n" % libdeps_dir)
+    env.Exit(1)
+clib_dir = os.path.dirname(hits[0])
+
+env.Prepend(CPPPATH=[sim_dir, clib_dir])
+sim_filter = "+<*> -<sim_main.cpp>" if env.get("PIOTEST_RUNNING_NAME") else "+<*>"
+env.BuildSources(os.path.join("$BUILD_DIR", "sim"), sim_dir, src_filter=sim_filter)
+env.BuildSources(os.path.join("$BUILD_DIR", "u8g2_clib"), clib_dir)
@@ -0,0 +1,135 @@
+"""Captures interaction traces from the board and replays them in the simulator.
+
+    python tools/trace.py capture --port PORT session.trc
+    python tools/trace.py convert serial.log session.trc
+    python tools/trace.py replay session.trc [--update | --threshold MS]
+
+capture sends 't' and saves the hex dump (see include/trace.h) as a .trc
+file; convert does the same from a saved serial log. replay runs the trace
+through the simulator (pio run -e native), prints the press-to-first-pixel
+report of the replayed run and compares it with session.trc.csv from an
+earlier replay: a transition whose pixel_us grew by more than --threshold
+milliseconds (default 5) fails with exit status 1. --update stores the
+report as the new reference instead.
+"""
+
+import argparse
+import csv
+import io
+import os
+import subprocess
+import sys
+import time
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SIM_PROGRAM = os.path.join(ROOT, ".pio", "build", "native", "program")
+TRACE_MAGIC = b"VTR1"
+
+
+def parse_dump(lines):
+    records = None
+    for line in lines:
+        line = line.strip()
+        if line.startswith("trace,"):
+            records = []
+        elif records is not None:
+            if line == "end":
+                return b"".join(records)
+            records.append(bytes.fromhex(line))
+    raise ValueError("no complete trace dump found")
+
+
+def capture(port, timeout):
+    import serial  # pyserial, ships with PlatformIO
+
+    with serial.Serial(port, 115200, timeout=1) as link:
+        link.reset_input_buffer()
+        link.write(b"t")
+        lines = []
+        deadline = time.time() + timeout
+        while time.time() < deadline:
+            line = link.readline().decode("utf-8", "replace")
+            lines.append(line)
+            if line.strip() == "end":
+                return parse_dump(lines)
+    raise ValueError("timed out waiting for the trace on %s" % port)
+
+
+def save(path, records):
+    with open(path, "wb") as f:
+        f.write(TRACE_MAGIC + records)
+    print("trace: %d records in %s" % (len(records) // 8, path))
+
+
+def replay(path):
+    if not os.path.exists(SIM_PROGRAM):
+        raise ValueError("%s missing, run: pio run -e native" % SIM_PROGRAM)
+    run = subprocess.run([SIM_PROGRAM, "-r", path], stdout=subprocess.PIPE,
+                         stderr=subprocess.PIPE, universal_newlines=True)
+    sys.stderr.write("".join(l + "\n" for l in run.stderr.splitlines() if "replay" in l))
+    if run.returncode:
+        raise ValueError("simulator failed:\n" + run.stderr)
+    out = run.stdout
+    start = out.rfind("at_ms,from,to,event")
+    if start < 0:
+        raise ValueError("no report in the simulator output")
+    return out[start:]
+
+
+def compare(report, reference, threshold_ms):
+    rows = list(csv.DictReader(io.StringIO(report)))
+    old = list(csv.DictReader(io.StringIO(reference)))
+    failed = False
+    for i, row in enumerate(rows):
+        if row["at_ms"].startswith("#") or i >= len(old) or not row["pixel_us"] or not old[i]["pixel_us"]:
+            continue
+        step = "%s -> %s (%s)" % (row["from"], row["to"], row["event"])
+        if (row["from"], row["to"]) != (old[i]["from"], old[i]["to"]):
+            print("trace: transition %d is now %s, reference has %s -> %s" % (i, step, old[i]["from"], old[i]["to"]))
+            return False
+        grew = (int(row["pixel_us"]) - int(old[i]["pixel_us"])) / 1000.0
+        if grew > threshold_ms:
+            print("trace: %s at %s ms: first pixel %.1f ms later than before" % (step, row["at_ms"], grew))
+            failed = True
+    return not failed
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Capture and replay interaction traces")
+    parser.add_argument("mode", choices=["capture", "convert", "replay"])
+    parser.add_argument("files", nargs="+", help="capture: OUT.trc, convert: LOG OUT.trc, replay: IN.trc")
+    parser.add_argument("--port", help="serial port of the board (capture only)")
+    parser.add_argument("--timeout", type=float, default=10, help="seconds to wait for the board")
+    parser.add_argument("--threshold", type=float, default=5, help="allowed first-pixel slowdown, ms")
+    parser.add_argument("--update", action="store_true", help="store the replay report as the reference")
+    args = parser.parse_args()
+
+    if args.mode == "capture":
+        if not args.port:
+            raise ValueError("capture needs --port")
+        save(args.files[0], capture(args.port, args.timeout))
+        return 0
+    if args.mode == "convert":
+        if len(args.files) != 2:
+            raise ValueError("convert needs a log and an output file")
+        with open(args.files[0]) as f:
+            save(args.files[1], parse_dump(f))
+        return 0
+
+    report = replay(args.files[0])
+    sys.stdout.write(report)
+    reference_path = args.files[0] + ".csv"
+    if args.update or not os.path.exists(reference_path):
+        with open(reference_path, "w") as f:
+            f.write(report)
+        print("trace: wrote %s" % os.path.relpath(reference_path))
+        return 0
+    with open(reference_path) as f:
+        return 0 if compare(report, f.read(), args.threshold) else 1
+
+
+if __name__ == "__main__":
+    try:
+        sys.exit(main())
+    except ValueError as e:
+        sys.exit("trace: " + str(e))
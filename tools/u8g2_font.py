@@ -0,0 +1,211 @@
+"""Minimal reader for u8g2 font data, used by the build-time generators.
+
+Fonts are taken from the U8g2 library sources (clib/u8g2_fonts.c), where each
+font is a C string literal. The decoding below follows u8g2_font.c: glyph
+metrics (u8g2_GetGlyphWidth), string width (u8g2_string_width) and the RLE
+glyph bitmap (u8g2_font_decode_glyph).
+"""
+
+import glob
+import os
+import re
+
+HEADER_SIZE = 23
+
+
+def c_string_bytes(body):
+    """Bytes of a C string literal body (without the quotes), as strlen() sees them."""
+    out = bytearray()
+    i = 0
+    while i < len(body):
+        c = body[i]
+        if c != "\\":
+            out += c.encode("latin-1")
+            i += 1
+            continue
+        i += 1
+        c = body[i]
+        if c in "01234567":
+            j = i
+            while j < len(body) and j < i + 3 and body[j] in "01234567":
+                j += 1
+            out.append(int(body[i:j], 8) & 0xFF)
+            i = j
+        elif c == "x":
+            j = i + 1
+            while j < len(body) and body[j] in "0123456789abcdefABCDEF":
+                j += 1
+            out.append(int(body[i + 1:j], 16) & 0xFF)
+            i = j
+        else:
+            simple = {"n": 10, "t": 9, "r": 13, "a": 7, "b": 8, "f": 12, "v": 11,
+                      "\\": 92, "\"": 34, "'": 39, "?": 63}
+            out.append(simple[c])
+            i += 1
+    return bytes(out)
+
+
+def load_font(fonts_c, name):
+    """Return the raw bytes of font `name` from u8g2_fonts.c."""
+    with open(fonts_c, encoding="latin-1") as f:
+        src = f.read()
+    m = re.search(r"const\s+uint8_t\s+" + re.escape(name) + r"\[\d*\][^=]*=\s*((?:\s*\"(?:[^\"\\]|\\.)*\")+)\s*;", src)
+    if not m:
+        raise KeyError("font %s not found in %s" % (name, fonts_c))
+    parts = re.findall(r"\"((?:[^\"\\]|\\.)*)\"", m.group(1))
+    return c_string_bytes("".join(parts))
+
+
+def find_fonts_c(libdeps_dir):
+    hits = glob.glob(os.path.join(libdeps_dir, "**", "u8g2_fonts.c"), recursive=True)
+    if not hits:
+        raise FileNotFoundError("u8g2_fonts.c not found under %s (is U8g2 installed?)" % libdeps_dir)
+    return hits[0]
+
+
+class _Bits:
+    def __init__(self, data, pos):
+        self.data = data
+        self.pos = pos
+        self.bit = 0
+
+    def unsigned(self, cnt):
+        val = self.data[self.pos] >> self.bit
+        end = self.bit + cnt
+        if end >= 8:
+            self.pos += 1
+            val |= self.data[self.pos] << (8 - self.bit)
+            end -= 8
+        self.bit = end
+        return val & ((1 << cnt) - 1)
+
+    def signed(self, cnt):
+        return self.unsigned(cnt) - (1 << (cnt - 1))
+
+
+class Glyph:
+    def __init__(self, width, height, x, y, dx, pixels):
+        self.width = width    # bitmap width
+        self.height = height
+        self.x = x            # offset from the pen position
+        self.y = y            # offset of the bitmap bottom above the baseline
+        self.dx = dx          # advance
+        self.pixels = pixels  # rows of 0/1, top row first
+
+
+class Font:
+    def __init__(self, name, data):
+        self.name = name
+        self.data = data
+        h = data[:HEADER_SIZE]
+        self.glyph_cnt = h[0]
+        self.bits_per_0 = h[2]
+        self.bits_per_1 = h[3]
+        self.bits_per_char_width = h[4]
+        self.bits_per_char_height = h[5]
+        self.bits_per_char_x = h[6]
+        self.bits_per_char_y = h[7]
+        self.bits_per_delta_x = h[8]
+        self.max_char_height = h[10]
+        self.ascent_A = _s8(h[13])
+        self.descent_g = _s8(h[14])
+        self.glyphs = self._read_glyphs()
+
+    def _read_glyphs(self):
+        glyphs = {}
+        pos = HEADER_SIZE
+        while self.data[pos + 1] != 0:
+            encoding = self.data[pos]
+            glyphs[encoding] = self._decode(pos + 2)
+            pos += self.data[pos + 1]
+        return glyphs
+
+    def _decode(self, pos):
+        b = _Bits(self.data, pos)
+        w = b.unsigned(self.bits_per_char_width)
+        h = b.unsigned(self.bits_per_char_height)
+        x = b.signed(self.bits_per_char_x)
+        y = b.signed(self.bits_per_char_y)
+        dx = b.signed(self.bits_per_delta_x)
+        pixels = [[0] * w for _ in range(h)]
+        if w > 0:
+            lx = ly = 0
+            while ly < h:
+                a = b.unsigned(self.bits_per_0)
+                n1 = b.unsigned(self.bits_per_1)
+                while True:
+                    for cnt, color in ((a, 0), (n1, 1)):
+                        while cnt > 0 and ly < h:
+                            run = min(cnt, w - lx)
+                            for i in range(run):
+                                pixels[ly][lx + i] = color
+                            cnt -= run
+                            lx += run
+                            if lx >= w:
+                                lx = 0
+                                ly += 1
+                    if b.unsigned(1) == 0:
+                        break
+        return Glyph(w, h, x, y, dx, pixels)
+
+    def has_glyph(self, ch):
+        return _code(ch) in self.glyphs
+
+    def str_width(self, text):
+        """u8g2 getStrWidth(): advances, but the last glyph counts its real width."""
+        w = dx = 0
+        last_w = last_x = 0
+        for ch in text:
+            g = self.glyphs.get(_code(ch))
+            dx = g.dx if g else 0
+            if g:
+                last_w, last_x = g.width, g.x
+            w += dx
+        if last_w != 0:
+            w = w - dx + last_w + last_x
+        return w & 0xFF
+
+    def rasterize(self, text):
+        """Ink of drawStr(0, 0, text) as (x, top, rows), rows of 0/1 from its
+        top left pixel at (x, top); (0, 0, []) for a string without ink."""
+        ink = set()
+        pen = 0
+        for ch in text:
+            g = self.glyphs.get(_code(ch))
+            if not g:
+                continue
+            top = -(g.height + g.y)
+            for r, row in enumerate(g.pixels):
+                for c, p in enumerate(row):
+                    if p:
+                        ink.add((pen + g.x + c, top + r))
+            pen += g.dx
+        if not ink:
+            return 0, 0, []
+        x0 = min(p[0] for p in ink)
+        y0 = min(p[1] for p in ink)
+        w = max(p[0] for p in ink) - x0 + 1
+        h = max(p[1] for p in ink) - y0 + 1
+        return x0, y0, [[int((x0 + c, y0 + r) in ink) for c in range(w)] for r in range(h)]
+
+    def render(self, text, x, y, canvas):
+        """drawStr(x, y, text) into canvas[row][col] (transparent font mode)."""
+        for ch in text:
+            g = self.glyphs.get(_code(ch))
+            if not g:
+                continue
+            top = y - (g.height + g.y)
+            for r, row in enumerate(g.pixels):
+                for c, p in enumerate(row):
+                    px, py = x + g.x + c, top + r
+                    if p and 0 <= py < len(canvas) and 0 <= px < len(canvas[0]):
+                        canvas[py][px] = 1
+            x += g.dx
+
+
+def _code(ch):
+    return ch if isinstance(ch, int) else ord(ch)  # iterating bytes gives ints
+
+
+def _s8(v):
+    return v - 256 if v > 127 else v